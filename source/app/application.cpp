@@ -27,6 +27,7 @@
 #include "shared/utils/scopetimer.h"
 #include "shared/utils/preferences.h"
 
+#include "loading/binarygraphsaver.h"
 #include "loading/graphmlsaver.h"
 #include "loading/jsongraphsaver.h"
 #include "loading/gmlsaver.h"
@@ -67,6 +68,7 @@ Application::Application(QObject *parent) :
     registerSaverFactory(std::make_unique<GMLSaverFactory>());
     registerSaverFactory(std::make_unique<PairwiseSaverFactory>());
     registerSaverFactory(std::make_unique<JSONGraphSaverFactory>());
+    registerSaverFactory(std::make_unique<BinaryGraphSaverFactory>());
 
     _updater.enableAutoBackgroundCheck();
     loadPlugins();
@@ -0,0 +1,168 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATTRIBUTECOLUMN_H
+#define ATTRIBUTECOLUMN_H
+
+#include "attribute.h"
+
+#include "graph/graph.h"
+#include "shared/graph/grapharray.h"
+#include "shared/utils/statistics.h"
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#include <QString>
+
+// A snapshot of the values of an attribute, for every element of a graph, held
+// in contiguous memory; it is only valid for as long as the version it was
+// created with is current (see GraphModel::materialisedAttribute)
+template<typename E>
+class AttributeColumn
+{
+    static_assert(std::is_same_v<E, NodeId> || std::is_same_v<E, EdgeId>,
+        "AttributeColumn only supports NodeId and EdgeId");
+
+private:
+    ValueType _valueType = ValueType::Unknown;
+    uint64_t _version = 0;
+
+    // Only one of these is allocated, depending on the value type
+    std::unique_ptr<ElementIdArray<E, double>> _numericValues;
+    std::unique_ptr<ElementIdArray<E, QString>> _stringValues;
+
+    ElementIdArray<E, bool> _valueMissing;
+
+    template<typename Fn>
+    static void forEachElementId(const Graph& graph, Fn&& fn)
+    {
+        auto visit = [&graph, &fn](auto elementId)
+        {
+            if(graph.typeOf(elementId) == MultiElementType::Not)
+            {
+                fn(elementId);
+                return;
+            }
+
+            // Include the elements that have been merged
+            if constexpr(std::is_same_v<E, NodeId>)
+            {
+                for(auto mergedNodeId : graph.mergedNodeIdsForNodeId(elementId))
+                    fn(mergedNodeId);
+            }
+            else
+            {
+                for(auto mergedEdgeId : graph.mergedEdgeIdsForEdgeId(elementId))
+                    fn(mergedEdgeId);
+            }
+        };
+
+        if constexpr(std::is_same_v<E, NodeId>)
+        {
+            for(auto nodeId : graph.nodeIds())
+                visit(nodeId);
+        }
+        else
+        {
+            for(auto edgeId : graph.edgeIds())
+                visit(edgeId);
+        }
+    }
+
+public:
+    AttributeColumn(const Graph& graph, const Attribute& attribute, uint64_t version) :
+        _valueType(attribute.valueType()), _version(version), _valueMissing(graph, false)
+    {
+        Q_ASSERT(attribute.isOfElementType<E>());
+
+        switch(_valueType)
+        {
+        case ValueType::Int:
+        case ValueType::Float:
+            _numericValues = std::make_unique<ElementIdArray<E, double>>(graph);
+            forEachElementId(graph, [this, &attribute](E elementId)
+            {
+                (*_numericValues)[elementId] = attribute.numericValueOf(elementId);
+                _valueMissing.set(elementId, attribute.valueMissingOf(elementId));
+            });
+            break;
+
+        case ValueType::String:
+            _stringValues = std::make_unique<ElementIdArray<E, QString>>(graph);
+            forEachElementId(graph, [this, &attribute](E elementId)
+            {
+                (*_stringValues)[elementId] = attribute.stringValueOf(elementId);
+                _valueMissing.set(elementId, attribute.valueMissingOf(elementId));
+            });
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    ValueType valueType() const { return _valueType; }
+    uint64_t version() const { return _version; }
+
+    double numericValueOf(E elementId) const
+    {
+        if(_numericValues != nullptr)
+            return _numericValues->get(elementId);
+
+        if(_stringValues != nullptr)
+            return _stringValues->get(elementId).toDouble();
+
+        return {};
+    }
+
+    QString stringValueOf(E elementId) const
+    {
+        if(_stringValues != nullptr)
+            return _stringValues->get(elementId);
+
+        if(_numericValues == nullptr)
+            return {};
+
+        auto value = _numericValues->get(elementId);
+
+        if(_valueType == ValueType::Int)
+            return QString::number(static_cast<int>(value));
+
+        return QString::number(value);
+    }
+
+    bool valueMissingOf(E elementId) const
+    {
+        return _valueMissing.get(elementId);
+    }
+
+    u::Statistics findStatisticsforElements(const std::vector<E>& elementIds,
+        bool storeValues = false) const
+    {
+        return u::findStatisticsFor(elementIds,
+        [this](E elementId)
+        {
+            return numericValueOf(elementId);
+        }, storeValues);
+    }
+};
+
+#endif // ATTRIBUTECOLUMN_H
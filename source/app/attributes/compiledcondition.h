@@ -0,0 +1,604 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPILEDCONDITION_H
+#define COMPILEDCONDITION_H
+
+#include "conditionfncreator.h"
+
+#include <boost/variant/static_visitor.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+#include <QString>
+#include <QRegularExpression>
+
+// Lowers a condition to a flat program, which is then evaluated over blocks of
+// elements at a time: each referenced attribute is read into a column once per
+// element, and each instruction is a simple loop over those columns, as opposed
+// to evaluating a tree of closures for every element
+// The results are identical to those of the CreateConditionFnFor equivalent
+template<typename E>
+class CompiledCondition
+{
+    static_assert(std::is_same_v<E, NodeId> || std::is_same_v<E, EdgeId>,
+        "CompiledCondition only supports NodeId and EdgeId");
+
+private:
+    enum class ColumnType
+    {
+        Numeric,
+        String,
+        Missing
+    };
+
+    struct Column
+    {
+        QString _attributeName;
+        Attribute _attribute;
+        ColumnType _type;
+    };
+
+    enum class Opcode
+    {
+        Constant,
+        Closure,
+        HasValue,
+        CompareNumbers,
+        CompareStrings,
+        TestString,
+        MatchRegex,
+        And,
+        Or
+    };
+
+    enum class Comparison
+    {
+        Equal,
+        NotEqual,
+        LessThan,
+        GreaterThan,
+        LessThanOrEqual,
+        GreaterThanOrEqual
+    };
+
+    struct Instruction
+    {
+        Opcode _opcode = Opcode::Constant;
+
+        // Column indices, or for And/Or instruction indices; a
+        // negative _rhs indicates comparison with a constant
+        int _lhs = -1;
+        int _rhs = -1;
+
+        Comparison _comparison = Comparison::Equal;
+        ConditionFnOp::String _stringOp = ConditionFnOp::String::Includes;
+
+        bool _boolean = false;
+        double _number = 0.0;
+        QString _string;
+        QRegularExpression _re;
+
+        // Used for anything that doesn't have a more specific implementation
+        ElementConditionFn<E> _fn;
+    };
+
+    const GraphModel* _graphModel;
+    std::vector<Column> _columns;
+    std::vector<Instruction> _program;
+    bool _valid = false;
+
+    static bool isAttributeName(const GraphTransformConfig::TerminalValue& terminalValue)
+    {
+        const auto* string = std::get_if<QString>(&terminalValue);
+        return string != nullptr && GraphTransformConfigParser::isAttributeName(*string);
+    }
+
+    static QString toString(const GraphTransformConfig::TerminalValue& terminalValue)
+    {
+        if(const auto* v = std::get_if<double>(&terminalValue))
+            return QString::number(*v);
+
+        if(const auto* v = std::get_if<int>(&terminalValue))
+            return QString::number(*v);
+
+        return std::get<QString>(terminalValue);
+    }
+
+    static double toDouble(const GraphTransformConfig::TerminalValue& terminalValue)
+    {
+        if(const auto* v = std::get_if<double>(&terminalValue))
+            return *v;
+
+        if(const auto* v = std::get_if<int>(&terminalValue))
+            return static_cast<double>(*v);
+
+        return std::get<QString>(terminalValue).toDouble();
+    }
+
+    static ValueType typeOf(const GraphTransformConfig::TerminalValue& terminalValue)
+    {
+        if(std::holds_alternative<double>(terminalValue))
+            return ValueType::Float;
+
+        if(std::holds_alternative<int>(terminalValue))
+            return ValueType::Int;
+
+        return ValueType::String;
+    }
+
+    static Comparison comparisonFor(ConditionFnOp::Equality op)
+    {
+        return op == ConditionFnOp::Equality::Equal ? Comparison::Equal : Comparison::NotEqual;
+    }
+
+    static Comparison comparisonFor(ConditionFnOp::Numerical op)
+    {
+        switch(op)
+        {
+        case ConditionFnOp::Numerical::LessThan:            return Comparison::LessThan;
+        case ConditionFnOp::Numerical::GreaterThan:         return Comparison::GreaterThan;
+        case ConditionFnOp::Numerical::LessThanOrEqual:     return Comparison::LessThanOrEqual;
+        case ConditionFnOp::Numerical::GreaterThanOrEqual:  return Comparison::GreaterThanOrEqual;
+        }
+
+        return Comparison::Equal;
+    }
+
+    int columnFor(const QString& attributeName, ColumnType type)
+    {
+        auto it = std::find_if(_columns.begin(), _columns.end(), [&](const auto& column)
+        {
+            return column._attributeName == attributeName && column._type == type;
+        });
+
+        if(it != _columns.end())
+            return static_cast<int>(std::distance(_columns.begin(), it));
+
+        _columns.push_back({attributeName, _graphModel->attributeValueByName(attributeName), type});
+        return static_cast<int>(_columns.size()) - 1;
+    }
+
+    int add(Instruction&& instruction)
+    {
+        _program.emplace_back(std::move(instruction));
+        return static_cast<int>(_program.size()) - 1;
+    }
+
+    int compileAttributes(const GraphTransformConfig::TerminalCondition& terminalCondition,
+        const ElementConditionFn<E>& fn)
+    {
+        const auto& lhsName = std::get<QString>(terminalCondition._lhs);
+        const auto& rhsName = std::get<QString>(terminalCondition._rhs);
+        auto lhsType = _graphModel->attributeValueByName(lhsName).valueType();
+        auto rhsType = _graphModel->attributeValueByName(rhsName).valueType();
+
+        Instruction instruction;
+
+        if(const auto* op = std::get_if<ConditionFnOp::Equality>(&terminalCondition._op))
+        {
+            instruction._comparison = comparisonFor(*op);
+
+            if(lhsType == rhsType && lhsType != ValueType::String)
+            {
+                instruction._opcode = Opcode::CompareNumbers;
+                instruction._lhs = columnFor(lhsName, ColumnType::Numeric);
+                instruction._rhs = columnFor(rhsName, ColumnType::Numeric);
+            }
+            else
+            {
+                instruction._opcode = Opcode::CompareStrings;
+                instruction._lhs = columnFor(lhsName, ColumnType::String);
+                instruction._rhs = columnFor(rhsName, ColumnType::String);
+            }
+        }
+        else if(const auto* op = std::get_if<ConditionFnOp::Numerical>(&terminalCondition._op))
+        {
+            instruction._opcode = Opcode::CompareNumbers;
+            instruction._comparison = comparisonFor(*op);
+            instruction._lhs = columnFor(lhsName, ColumnType::Numeric);
+            instruction._rhs = columnFor(rhsName, ColumnType::Numeric);
+        }
+        else
+        {
+            instruction._opcode = Opcode::Closure;
+            instruction._fn = fn;
+        }
+
+        return add(std::move(instruction));
+    }
+
+    int compileAttributeValue(const QString& attributeName,
+        const GraphTransformConfig::TerminalValue& value,
+        const GraphTransformConfig::TerminalOp& terminalOp, bool operandsAreSwitched)
+    {
+        auto attributeType = _graphModel->attributeValueByName(attributeName).valueType();
+
+        Instruction instruction;
+
+        if(const auto* op = std::get_if<ConditionFnOp::Equality>(&terminalOp))
+        {
+            instruction._comparison = comparisonFor(*op);
+
+            if(attributeType == typeOf(value) && attributeType != ValueType::String)
+            {
+                instruction._opcode = Opcode::CompareNumbers;
+                instruction._lhs = columnFor(attributeName, ColumnType::Numeric);
+                instruction._number = toDouble(value);
+            }
+            else
+            {
+                instruction._opcode = Opcode::CompareStrings;
+                instruction._lhs = columnFor(attributeName, ColumnType::String);
+                instruction._string = toString(value);
+            }
+        }
+        else if(const auto* numericalOp = std::get_if<ConditionFnOp::Numerical>(&terminalOp))
+        {
+            auto op = *numericalOp;
+
+            if(operandsAreSwitched)
+            {
+                // Mirrors CreateConditionFnFor
+                switch(op)
+                {
+                case ConditionFnOp::Numerical::LessThan:            op = ConditionFnOp::Numerical::GreaterThanOrEqual; break;
+                case ConditionFnOp::Numerical::GreaterThan:         op = ConditionFnOp::Numerical::LessThanOrEqual; break;
+                case ConditionFnOp::Numerical::LessThanOrEqual:     op = ConditionFnOp::Numerical::GreaterThan; break;
+                case ConditionFnOp::Numerical::GreaterThanOrEqual:  op = ConditionFnOp::Numerical::LessThan; break;
+                }
+            }
+
+            instruction._opcode = Opcode::CompareNumbers;
+            instruction._comparison = comparisonFor(op);
+            instruction._lhs = columnFor(attributeName, ColumnType::Numeric);
+            instruction._number = toDouble(value);
+
+            // Integer attributes are compared with the truncated value
+            if(attributeType == ValueType::Int && typeOf(value) != ValueType::Int)
+                instruction._number = static_cast<int>(instruction._number);
+        }
+        else
+        {
+            auto op = std::get<ConditionFnOp::String>(terminalOp);
+
+            instruction._lhs = columnFor(attributeName, ColumnType::String);
+            instruction._string = toString(value);
+
+            if(op == ConditionFnOp::String::MatchesRegex || op == ConditionFnOp::String::MatchesRegexCaseInsensitive)
+            {
+                auto reOption = op == ConditionFnOp::String::MatchesRegexCaseInsensitive ?
+                            QRegularExpression::CaseInsensitiveOption :
+                            QRegularExpression::NoPatternOption;
+
+                instruction._opcode = Opcode::MatchRegex;
+                instruction._re = QRegularExpression(instruction._string, reOption);
+                instruction._re.optimize();
+            }
+            else
+            {
+                instruction._opcode = Opcode::TestString;
+                instruction._stringOp = op;
+            }
+        }
+
+        return add(std::move(instruction));
+    }
+
+    struct Compiler : public boost::static_visitor<int>
+    {
+        CompiledCondition* _this;
+
+        explicit Compiler(CompiledCondition* compiledCondition) :
+            _this(compiledCondition)
+        {}
+
+        int operator()(GraphTransformConfig::NoCondition) const
+        {
+            return -1;
+        }
+
+        int operator()(const GraphTransformConfig::TerminalCondition& terminalCondition) const
+        {
+            // The closure is only used to validate the condition and
+            // evaluate anything that isn't otherwise handled
+            auto fn = CreateConditionFnFor::elementType<E>(*_this->_graphModel,
+                GraphTransformConfig::Condition(terminalCondition));
+
+            if(fn == nullptr)
+                return -1;
+
+            bool lhsIsAttribute = isAttributeName(terminalCondition._lhs);
+            bool rhsIsAttribute = isAttributeName(terminalCondition._rhs);
+
+            if(lhsIsAttribute && rhsIsAttribute)
+                return _this->compileAttributes(terminalCondition, fn);
+
+            if(lhsIsAttribute)
+            {
+                return _this->compileAttributeValue(std::get<QString>(terminalCondition._lhs),
+                    terminalCondition._rhs, terminalCondition._op, false);
+            }
+
+            if(rhsIsAttribute)
+            {
+                return _this->compileAttributeValue(std::get<QString>(terminalCondition._rhs),
+                    terminalCondition._lhs, terminalCondition._op, true);
+            }
+
+            // Neither side is an attribute, so the result is constant
+            Instruction instruction;
+            instruction._opcode = Opcode::Constant;
+            instruction._boolean = fn(E());
+            return _this->add(std::move(instruction));
+        }
+
+        int operator()(const GraphTransformConfig::UnaryCondition& unaryCondition) const
+        {
+            auto fn = CreateConditionFnFor::elementType<E>(*_this->_graphModel,
+                GraphTransformConfig::Condition(unaryCondition));
+
+            if(fn == nullptr)
+                return -1;
+
+            Instruction instruction;
+            instruction._opcode = Opcode::HasValue;
+            instruction._lhs = _this->columnFor(std::get<QString>(unaryCondition._lhs), ColumnType::Missing);
+            return _this->add(std::move(instruction));
+        }
+
+        int operator()(const GraphTransformConfig::CompoundCondition& compoundCondition) const
+        {
+            auto lhs = boost::apply_visitor(*this, compoundCondition._lhs);
+            auto rhs = boost::apply_visitor(*this, compoundCondition._rhs);
+
+            if(lhs < 0 || rhs < 0)
+                return -1;
+
+            Instruction instruction;
+            instruction._opcode = compoundCondition._op == ConditionFnOp::Logical::And ?
+                Opcode::And : Opcode::Or;
+            instruction._lhs = lhs;
+            instruction._rhs = rhs;
+            return _this->add(std::move(instruction));
+        }
+    };
+
+    template<typename L, typename R>
+    static void compare(Comparison comparison, L lhs, R rhs, std::vector<uint8_t>& out)
+    {
+        auto size = out.size();
+
+        switch(comparison)
+        {
+        case Comparison::Equal:
+            for(size_t i = 0; i < size; i++) out[i] = lhs(i) == rhs(i);
+            break;
+        case Comparison::NotEqual:
+            for(size_t i = 0; i < size; i++) out[i] = lhs(i) != rhs(i);
+            break;
+        case Comparison::LessThan:
+            for(size_t i = 0; i < size; i++) out[i] = lhs(i) < rhs(i);
+            break;
+        case Comparison::GreaterThan:
+            for(size_t i = 0; i < size; i++) out[i] = lhs(i) > rhs(i);
+            break;
+        case Comparison::LessThanOrEqual:
+            for(size_t i = 0; i < size; i++) out[i] = lhs(i) <= rhs(i);
+            break;
+        case Comparison::GreaterThanOrEqual:
+            for(size_t i = 0; i < size; i++) out[i] = lhs(i) >= rhs(i);
+            break;
+        }
+    }
+
+public:
+    CompiledCondition(const GraphModel& graphModel, const GraphTransformConfig::Condition& condition) :
+        _graphModel(&graphModel)
+    {
+        // Validity is determined in exactly the same way as CreateConditionFnFor
+        if(CreateConditionFnFor::elementType<E>(graphModel, condition) == nullptr)
+            return;
+
+        _valid = boost::apply_visitor(Compiler(this), condition) >= 0;
+    }
+
+    bool isValid() const { return _valid; }
+
+    // Returns, for each of elementIds, non-zero if the condition holds
+    std::vector<uint8_t> evaluate(const std::vector<E>& elementIds) const
+    {
+        Q_ASSERT(_valid);
+
+        const size_t BlockSize = 4096;
+
+        std::vector<uint8_t> results(elementIds.size(), 0);
+        std::vector<std::vector<double>> numbers(_columns.size());
+        std::vector<std::vector<QString>> strings(_columns.size());
+        std::vector<std::vector<uint8_t>> missing(_columns.size());
+        std::vector<std::vector<uint8_t>> registers(_program.size());
+
+        for(size_t begin = 0; begin < elementIds.size(); begin += BlockSize)
+        {
+            auto size = std::min(BlockSize, elementIds.size() - begin);
+
+            // Read the attribute values into columns
+            for(size_t c = 0; c < _columns.size(); c++)
+            {
+                const auto& column = _columns.at(c);
+
+                switch(column._type)
+                {
+                case ColumnType::Numeric:
+                    numbers[c].resize(size);
+                    for(size_t i = 0; i < size; i++)
+                    {
+                        auto elementId = elementIds[begin + i];
+                        numbers[c][i] = column._attribute.template numericValueOf<E>(elementId);
+                    }
+                    break;
+
+                case ColumnType::String:
+                    strings[c].resize(size);
+                    for(size_t i = 0; i < size; i++)
+                    {
+                        auto elementId = elementIds[begin + i];
+                        strings[c][i] = column._attribute.stringValueOf(elementId);
+                    }
+                    break;
+
+                case ColumnType::Missing:
+                    missing[c].resize(size);
+                    for(size_t i = 0; i < size; i++)
+                    {
+                        auto elementId = elementIds[begin + i];
+                        missing[c][i] = column._attribute.valueMissingOf(elementId) ? 1 : 0;
+                    }
+                    break;
+                }
+            }
+
+            // Execute the program
+            for(size_t p = 0; p < _program.size(); p++)
+            {
+                const auto& instruction = _program.at(p);
+                auto& out = registers[p];
+                out.resize(size);
+
+                switch(instruction._opcode)
+                {
+                case Opcode::Constant:
+                    std::fill(out.begin(), out.end(), instruction._boolean ? 1 : 0);
+                    break;
+
+                case Opcode::Closure:
+                    for(size_t i = 0; i < size; i++)
+                        out[i] = instruction._fn(elementIds[begin + i]) ? 1 : 0;
+                    break;
+
+                case Opcode::HasValue:
+                {
+                    const auto& lhs = missing[instruction._lhs];
+                    for(size_t i = 0; i < size; i++)
+                        out[i] = lhs[i] ^ 1;
+                    break;
+                }
+
+                case Opcode::CompareNumbers:
+                {
+                    const auto* lhs = numbers[instruction._lhs].data();
+                    auto lhsFn = [lhs](size_t i) { return lhs[i]; };
+
+                    if(instruction._rhs >= 0)
+                    {
+                        const auto* rhs = numbers[instruction._rhs].data();
+                        compare(instruction._comparison, lhsFn, [rhs](size_t i) { return rhs[i]; }, out);
+                    }
+                    else
+                    {
+                        auto value = instruction._number;
+                        compare(instruction._comparison, lhsFn, [value](size_t) { return value; }, out);
+                    }
+                    break;
+                }
+
+                case Opcode::CompareStrings:
+                {
+                    const auto& lhs = strings[instruction._lhs];
+                    auto lhsFn = [&lhs](size_t i) -> const QString& { return lhs[i]; };
+
+                    if(instruction._rhs >= 0)
+                    {
+                        const auto& rhs = strings[instruction._rhs];
+                        compare(instruction._comparison, lhsFn, [&rhs](size_t i) -> const QString& { return rhs[i]; }, out);
+                    }
+                    else
+                    {
+                        const auto& value = instruction._string;
+                        compare(instruction._comparison, lhsFn, [&value](size_t) -> const QString& { return value; }, out);
+                    }
+                    break;
+                }
+
+                case Opcode::TestString:
+                {
+                    const auto& lhs = strings[instruction._lhs];
+                    const auto& value = instruction._string;
+
+                    switch(instruction._stringOp)
+                    {
+                    case ConditionFnOp::String::Includes:
+                        for(size_t i = 0; i < size; i++) out[i] = lhs[i].contains(value) ? 1 : 0;
+                        break;
+                    case ConditionFnOp::String::Excludes:
+                        for(size_t i = 0; i < size; i++) out[i] = lhs[i].contains(value) ? 0 : 1;
+                        break;
+                    case ConditionFnOp::String::Starts:
+                        for(size_t i = 0; i < size; i++) out[i] = lhs[i].startsWith(value) ? 1 : 0;
+                        break;
+                    case ConditionFnOp::String::Ends:
+                        for(size_t i = 0; i < size; i++) out[i] = lhs[i].endsWith(value) ? 1 : 0;
+                        break;
+                    default:
+                        break;
+                    }
+                    break;
+                }
+
+                case Opcode::MatchRegex:
+                {
+                    const auto& lhs = strings[instruction._lhs];
+                    for(size_t i = 0; i < size; i++)
+                        out[i] = instruction._re.match(lhs[i]).hasMatch() ? 1 : 0;
+                    break;
+                }
+
+                case Opcode::And:
+                case Opcode::Or:
+                {
+                    const auto& lhs = registers[instruction._lhs];
+                    const auto& rhs = registers[instruction._rhs];
+
+                    if(instruction._opcode == Opcode::And)
+                    {
+                        for(size_t i = 0; i < size; i++)
+                            out[i] = lhs[i] & rhs[i];
+                    }
+                    else
+                    {
+                        for(size_t i = 0; i < size; i++)
+                            out[i] = lhs[i] | rhs[i];
+                    }
+                    break;
+                }
+                }
+            }
+
+            // The last instruction is the root of the condition
+            const auto& result = registers.back();
+            std::copy(result.begin(), result.end(), results.begin() + static_cast<std::ptrdiff_t>(begin));
+        }
+
+        return results;
+    }
+};
+
+#endif // COMPILEDCONDITION_H
@@ -53,20 +53,28 @@ QString DeleteNodesCommand::pastParticiple() const
 
 bool DeleteNodesCommand::execute()
 {
-    _edges = _graphModel->mutableGraph().edgesForNodeIds(_nodeIds);
+    auto& mutableGraph = _graphModel->mutableGraph();
+
     _selectionManager->deselectNodes(_nodeIds);
-    _graphModel->mutableGraph().removeNodes(_nodeIds);
+
+    // When redoing, replaying the recorded changes restores the graph's
+    // revision too, so cached transform results can be reused
+    if(!_journal.empty())
+    {
+        mutableGraph.replay(_journal);
+        return true;
+    }
+
+    mutableGraph.beginJournal(true);
+    mutableGraph.removeNodes(_nodeIds);
+    _journal = mutableGraph.endJournal();
+
     return true;
 }
 
 void DeleteNodesCommand::undo()
 {
-    _graphModel->mutableGraph().performTransaction(
-        [this](IMutableGraph& graph)
-        {
-            graph.addNodes(_nodeIds);
-            graph.addEdges(_edges);
-        });
+    _graphModel->mutableGraph().replay(_journal.inverse());
 
     _selectionManager->selectNodes(_selectedNodeIds);
 }
@@ -22,8 +22,7 @@
 #include "shared/commands/icommand.h"
 
 #include "graph/graph.h"
-
-#include <vector>
+#include "graph/mutablegraph.h"
 
 class GraphModel;
 class SelectionManager;
@@ -37,7 +36,9 @@ private:
     bool _multipleNodes = false;
     const NodeIdSet _selectedNodeIds;
     const NodeIdSet _nodeIds;
-    std::vector<Edge> _edges;
+
+    // The changes made by the deletion, and what's needed to undo them
+    MutableGraph::Journal _journal;
 
 public:
     DeleteNodesCommand(GraphModel* graphModel,
@@ -26,14 +26,30 @@
 #include "graphcomponent.h"
 
 #include <map>
+#include <set>
 #include <queue>
+#include <numeric>
+#include <optional>
+#include <algorithm>
+
+namespace
+{
+template<typename T>
+std::vector<T> sortedUnique(std::vector<T> elementIds)
+{
+    std::sort(elementIds.begin(), elementIds.end());
+    elementIds.erase(std::unique(elementIds.begin(), elementIds.end()), elementIds.end());
+    return elementIds;
+}
+} // namespace
 
 ComponentManager::ComponentManager(Graph& graph,
                                    const NodeConditionFn& nodeFilter,
                                    const EdgeConditionFn& edgeFilter) :
     _nextComponentId(0),
     _nodesComponentId(graph),
-    _edgesComponentId(graph)
+    _edgesComponentId(graph),
+    _edgesNodeIds(graph)
 {
     // Ignore all multi-elements
     addNodeFilter([&graph](NodeId nodeId) { return graph.typeOf(nodeId) == MultiElementType::Tail; });
@@ -45,6 +61,18 @@ ComponentManager::ComponentManager(Graph& graph,
     if(edgeFilter)
         addEdgeFilter(edgeFilter);
 
+    _hasCustomFilters = nodeFilter != nullptr || edgeFilter != nullptr;
+
+    // Record what changes, so that subsequent updates need only consider the affected components
+    connect(&graph, &Graph::nodeAdded, this, [this](const Graph*, NodeId nodeId)
+        { _addedNodeIds.push_back(nodeId); }, Qt::DirectConnection);
+    connect(&graph, &Graph::nodeRemoved, this, [this](const Graph*, NodeId nodeId)
+        { _removedNodeIds.push_back(nodeId); }, Qt::DirectConnection);
+    connect(&graph, &Graph::edgeAdded, this, [this](const Graph*, EdgeId edgeId)
+        { _addedEdgeIds.push_back(edgeId); }, Qt::DirectConnection);
+    connect(&graph, &Graph::edgeRemoved, this, [this](const Graph*, EdgeId edgeId)
+        { _removedEdgeIds.push_back(edgeId); }, Qt::DirectConnection);
+
     connect(&graph, &Graph::graphChanged, this, &ComponentManager::onGraphChanged, Qt::DirectConnection);
 
     graph.update();
@@ -101,6 +129,198 @@ ComponentIdSet ComponentManager::assignConnectedElementsComponentId(const Graph*
     return oldComponentIdsAffected;
 }
 
+ComponentId ComponentManager::newComponentIdOf(NodeId nodeId, const ComponentIdChanges& componentIdChanges) const
+{
+    auto it = componentIdChanges._nodes.find(nodeId);
+    return it != componentIdChanges._nodes.end() ? it->second : _nodesComponentId[nodeId];
+}
+
+ComponentId ComponentManager::newComponentIdOf(EdgeId edgeId, const ComponentIdChanges& componentIdChanges) const
+{
+    auto it = componentIdChanges._edges.find(edgeId);
+    return it != componentIdChanges._edges.end() ? it->second : _edgesComponentId[edgeId];
+}
+
+void ComponentManager::assignLocalElementsComponentId(const Graph* graph, NodeId rootId,
+    ComponentId componentId, const std::vector<NodeId>& addedNodeIds,
+    ComponentIdChanges& componentIdChanges,
+    ComponentUpdate& componentUpdate,
+    std::vector<EdgeId>& bridgeEdgeIds)
+{
+    std::queue<NodeId> nodeIds;
+
+    auto assignNodeId = [&](NodeId nodeId)
+    {
+        if(graph->typeOf(nodeId) == MultiElementType::Head)
+        {
+            for(auto mergedNodeId : graph->mergedNodeIdsForNodeId(nodeId))
+                componentIdChanges._nodes[mergedNodeId] = componentId;
+
+            // Merged nodes can subsequently change without notification
+            _incrementalUpdatePossible = false;
+        }
+        else
+            componentIdChanges._nodes[nodeId] = componentId;
+
+        componentUpdate._nodeIds.push_back(nodeId);
+        nodeIds.push(nodeId);
+    };
+
+    assignNodeId(rootId);
+
+    while(!nodeIds.empty())
+    {
+        auto nodeId = nodeIds.front();
+        nodeIds.pop();
+
+        for(auto edgeId : graph->edgeIdsForNodeId(nodeId))
+        {
+            if(edgeIdFiltered(edgeId))
+                continue;
+
+            auto oppositeNodeId = graph->edgeById(edgeId).oppositeId(nodeId);
+
+            // Only traverse nodes that are new and not yet reached
+            if(newComponentIdOf(oppositeNodeId, componentIdChanges).isNull() &&
+                std::binary_search(addedNodeIds.begin(), addedNodeIds.end(), oppositeNodeId))
+            {
+                assignNodeId(oppositeNodeId);
+            }
+
+            if(newComponentIdOf(oppositeNodeId, componentIdChanges) != componentId)
+            {
+                // The edge leads to another component, with which we may merge
+                bridgeEdgeIds.push_back(edgeId);
+                continue;
+            }
+
+            if(newComponentIdOf(edgeId, componentIdChanges).isNull())
+            {
+                for(auto mergedEdgeId : graph->mergedEdgeIdsForEdgeId(edgeId))
+                    componentIdChanges._edges[mergedEdgeId] = componentId;
+
+                componentUpdate._edgeIds.push_back(edgeId);
+            }
+        }
+    }
+}
+
+std::vector<std::vector<NodeId>> ComponentManager::findSplitOffNodeIds(const Graph* graph,
+    const std::vector<NodeId>& seedNodeIds, const NodeConditionFn& isMember) const
+{
+    // Search outwards from every seed at once, merging searches that meet; once at most
+    // one group of searches is still growing, every other group has found the whole of
+    // its piece, so the cost is bounded by the pieces that split off, not the component
+    NodeIdMap<size_t> searchIndices;
+    std::vector<std::queue<NodeId>> frontiers;
+    std::vector<size_t> searchParents;
+
+    for(auto nodeId : seedNodeIds)
+    {
+        if(u::contains(searchIndices, nodeId))
+            continue;
+
+        searchIndices.emplace(nodeId, frontiers.size());
+        searchParents.push_back(frontiers.size());
+        frontiers.emplace_back().push(nodeId);
+    }
+
+    auto findGroup = [&searchParents](size_t search)
+    {
+        while(searchParents[search] != search)
+            search = searchParents[search] = searchParents[searchParents[search]];
+
+        return search;
+    };
+
+    std::vector<size_t> activeSearches(frontiers.size());
+    std::iota(activeSearches.begin(), activeSearches.end(), 0);
+    auto numGroups = frontiers.size();
+    std::set<size_t> growingGroups;
+
+    while(numGroups > 1)
+    {
+        activeSearches.erase(std::remove_if(activeSearches.begin(), activeSearches.end(),
+            [&frontiers](auto search) { return frontiers[search].empty(); }), activeSearches.end());
+
+        growingGroups.clear();
+        for(auto search : activeSearches)
+            growingGroups.insert(findGroup(search));
+
+        if(growingGroups.size() <= 1)
+            break;
+
+        for(auto search : activeSearches)
+        {
+            auto& frontier = frontiers[search];
+            auto nodeId = frontier.front();
+            frontier.pop();
+
+            for(auto edgeId : graph->edgeIdsForNodeId(nodeId))
+            {
+                if(edgeIdFiltered(edgeId))
+                    continue;
+
+                // New edges are followed too, as long as they stay within the component;
+                // one may have replaced an old edge as the head of a multi-edge
+                auto oppositeNodeId = graph->edgeById(edgeId).oppositeId(nodeId);
+                if(!isMember(oppositeNodeId))
+                    continue;
+
+                auto it = searchIndices.find(oppositeNodeId);
+
+                if(it == searchIndices.end())
+                {
+                    searchIndices.emplace(oppositeNodeId, search);
+                    frontier.push(oppositeNodeId);
+                    continue;
+                }
+
+                auto group = findGroup(search);
+                auto otherGroup = findGroup(it->second);
+
+                if(group != otherGroup)
+                {
+                    searchParents[group] = otherGroup;
+                    numGroups--;
+                }
+            }
+        }
+    }
+
+    if(numGroups <= 1)
+        return {};
+
+    std::map<size_t, std::vector<NodeId>> groupNodeIds;
+    for(const auto& [nodeId, search] : searchIndices)
+        groupNodeIds[findGroup(search)].push_back(nodeId);
+
+    // The group that is still growing keeps the original ID, as does
+    // the largest piece if they have all been found
+    auto keptGroup = std::max_element(groupNodeIds.begin(), groupNodeIds.end(),
+    [&growingGroups](const auto& a, const auto& b)
+    {
+        if(u::contains(growingGroups, a.first) != u::contains(growingGroups, b.first))
+            return u::contains(growingGroups, b.first);
+
+        return a.second.size() < b.second.size();
+    })->first;
+
+    std::vector<std::vector<NodeId>> splitOffNodeIds;
+
+    for(auto& [group, nodeIds] : groupNodeIds)
+    {
+        if(group == keptGroup)
+            continue;
+
+        // Keep the order stable, as it determines the order of the component's elements
+        std::sort(nodeIds.begin(), nodeIds.end());
+        splitOffNodeIds.push_back(std::move(nodeIds));
+    }
+
+    return splitOffNodeIds;
+}
+
 void ComponentManager::insertComponentArray(IGraphArray* componentArray)
 {
     std::unique_lock<std::mutex> lock(_componentArraysMutex);
@@ -113,26 +333,23 @@ void ComponentManager::eraseComponentArray(IGraphArray* componentArray)
     _componentArrays.erase(componentArray);
 }
 
-void ComponentManager::update(const Graph* graph)
+void ComponentManager::findChanges(const Graph* graph, Changes& changes,
+                                   NodeArray<ComponentId>& newNodesComponentId,
+                                   EdgeArray<ComponentId>& newEdgesComponentId)
 {
-    if(_debug) qDebug() << "ComponentManager::update begins" << this;
-
-    std::unique_lock<std::recursive_mutex> lock(_updateMutex);
-
-    std::map<ComponentId, ComponentIdSet> splitComponents;
-    ComponentIdSet splitComponentIds;
-    std::map<ComponentId, ComponentIdSet> mergedComponents;
-    ComponentIdSet mergedComponentIds;
     ComponentIdSet componentIds;
-
-    NodeArray<ComponentId> newNodesComponentId(*graph);
-    EdgeArray<ComponentId> newEdgesComponentId(*graph);
+    bool mergedNodesFound = false;
 
     // Search for mergers and splitters
     for(auto nodeId : graph->nodeIds())
     {
         if(nodeIdFiltered(nodeId))
+        {
+            if(graph->typeOf(nodeId) == MultiElementType::Tail)
+                mergedNodesFound = true;
+
             continue;
+        }
 
         auto oldComponentId = _nodesComponentId[nodeId];
 
@@ -149,9 +366,9 @@ void ComponentManager::update(const Graph* graph)
                 queueGraphComponentUpdate(graph, oldComponentId);
                 queueGraphComponentUpdate(graph, newComponentId);
 
-                splitComponents[oldComponentId].insert(oldComponentId);
-                splitComponents[oldComponentId].insert(newComponentId);
-                splitComponentIds.insert(newComponentId);
+                changes._splitComponents[oldComponentId].insert(oldComponentId);
+                changes._splitComponents[oldComponentId].insert(newComponentId);
+                changes._splitComponentIds.insert(newComponentId);
             }
             else
             {
@@ -163,9 +380,9 @@ void ComponentManager::update(const Graph* graph)
                 if(componentIdsAffected.size() > 1)
                 {
                     // More than one old component IDs were observed so components have merged
-                    mergedComponents[oldComponentId].insert(componentIdsAffected.begin(), componentIdsAffected.end());
+                    changes._mergedComponents[oldComponentId].insert(componentIdsAffected.begin(), componentIdsAffected.end());
                     componentIdsAffected.erase(oldComponentId);
-                    mergedComponentIds.insert(componentIdsAffected.begin(), componentIdsAffected.end());
+                    changes._mergedComponentIds.insert(componentIdsAffected.begin(), componentIdsAffected.end());
                 }
             }
         }
@@ -186,71 +403,615 @@ void ComponentManager::update(const Graph* graph)
         }
     }
 
-    // Resize the component arrays
-    for(auto* componentArray : _componentArrays)
-        componentArray->resize(componentArrayCapacity());
-
     // Search for added or removed components
-    auto componentIdsToBeAdded = u::setDifference(componentIds, _componentIds);
-    auto componentIdsToBeRemoved = u::setDifference(_componentIds, componentIds);
+    changes._componentIdsToBeAdded = u::setDifference(componentIds, _componentIds);
+    changes._componentIdsToBeRemoved = u::setDifference(_componentIds, componentIds);
 
     // Find nodes and edges that have been added or removed
-    std::map<ComponentId, std::vector<NodeId>> nodeIdAdds;
-    std::map<ComponentId, std::vector<EdgeId>> edgeIdAdds;
-    std::map<ComponentId, std::vector<NodeId>> nodeIdRemoves;
-    std::map<ComponentId, std::vector<EdgeId>> edgeIdRemoves;
-
     auto maxNumNodes = std::max(_nodesComponentId.size(), newNodesComponentId.size());
     for(NodeId nodeId(0); nodeId < maxNumNodes; ++nodeId)
     {
         if(_nodesComponentId[nodeId].isNull() && !newNodesComponentId[nodeId].isNull())
-            nodeIdAdds[newNodesComponentId[nodeId]].emplace_back(nodeId);
+            changes._nodeIdAdds[newNodesComponentId[nodeId]].emplace_back(nodeId);
         else if(!_nodesComponentId[nodeId].isNull() && newNodesComponentId[nodeId].isNull())
-            nodeIdRemoves[_nodesComponentId[nodeId]].emplace_back(nodeId);
+            changes._nodeIdRemoves[_nodesComponentId[nodeId]].emplace_back(nodeId);
     }
 
     auto maxNumEdges = std::max(_edgesComponentId.size(), newEdgesComponentId.size());
     for(EdgeId edgeId(0); edgeId < maxNumEdges; ++edgeId)
     {
         if(_edgesComponentId[edgeId].isNull() && !newEdgesComponentId[edgeId].isNull())
-            edgeIdAdds[newEdgesComponentId[edgeId]].emplace_back(edgeId);
+            changes._edgeIdAdds[newEdgesComponentId[edgeId]].emplace_back(edgeId);
         else if(!_edgesComponentId[edgeId].isNull() && newEdgesComponentId[edgeId].isNull())
-            edgeIdRemoves[_edgesComponentId[edgeId]].emplace_back(edgeId);
+            changes._edgeIdRemoves[_edgesComponentId[edgeId]].emplace_back(edgeId);
+    }
+
+    for(auto edgeId : graph->edgeIds())
+    {
+        const auto& edge = graph->edgeById(edgeId);
+        _edgesNodeIds[edgeId] = {edge.sourceId(), edge.targetId()};
+    }
+
+    _incrementalUpdatePossible = !_hasCustomFilters && !mergedNodesFound;
+}
+
+bool ComponentManager::findChangesIncrementally(const Graph* graph, Changes& changes,
+                                                ComponentIdChanges& componentIdChanges,
+                                                ComponentUpdates& componentUpdates)
+{
+    if(!_incrementalUpdatePossible)
+        return false;
+
+    auto numChanges = _addedNodeIds.size() + _removedNodeIds.size() +
+        _addedEdgeIds.size() + _removedEdgeIds.size();
+
+    // When a large proportion of the graph has changed, it's quicker to start from scratch
+    if(numChanges > static_cast<size_t>(graph->numNodes() + graph->numEdges()) / 4)
+        return false;
+
+    auto addedNodeIds = sortedUnique(_addedNodeIds);
+    auto removedNodeIds = sortedUnique(_removedNodeIds);
+    auto addedEdgeIds = sortedUnique(_addedEdgeIds);
+    auto removedEdgeIds = sortedUnique(_removedEdgeIds);
+
+    // Nodes being merged or unmerged can't be tracked incrementally
+    for(auto nodeId : addedNodeIds)
+    {
+        if(graph->containsNodeId(nodeId) && graph->typeOf(nodeId) != MultiElementType::Not)
+            return false;
+    }
+
+    for(auto edgeId : addedEdgeIds)
+    {
+        if(!graph->containsEdgeId(edgeId))
+            continue;
+
+        const auto& edge = graph->edgeById(edgeId);
+
+        if(graph->typeOf(edge.sourceId()) != MultiElementType::Not ||
+            graph->typeOf(edge.targetId()) != MultiElementType::Not)
+        {
+            return false;
+        }
+    }
+
+    // A removed ID that has since been reused refers to a new element, so only IDs that
+    // were neither removed nor added refer to elements that existed before and still do
+    auto isSurvivingNodeId = [&](NodeId nodeId, ComponentId componentId)
+    {
+        return graph->containsNodeId(nodeId) && !nodeIdFiltered(nodeId) &&
+            _nodesComponentId[nodeId] == componentId &&
+            !std::binary_search(removedNodeIds.begin(), removedNodeIds.end(), nodeId);
+    };
+
+    auto isSurvivingEdgeId = [&](EdgeId edgeId)
+    {
+        return !edgeIdFiltered(edgeId) &&
+            !std::binary_search(removedEdgeIds.begin(), removedEdgeIds.end(), edgeId) &&
+            !std::binary_search(addedEdgeIds.begin(), addedEdgeIds.end(), edgeId);
+    };
+
+    // Removals may split the components they were part of; any piece that splits off
+    // must contain one of the surviving ends of the removed edges
+    std::map<ComponentId, std::vector<NodeId>> componentSeedNodeIds;
+
+    for(auto nodeId : removedNodeIds)
+    {
+        auto componentId = _nodesComponentId[nodeId];
+
+        if(!componentId.isNull())
+            componentSeedNodeIds[componentId];
+    }
+
+    for(auto edgeId : removedEdgeIds)
+    {
+        auto componentId = _edgesComponentId[edgeId];
+
+        if(componentId.isNull())
+            continue;
+
+        auto& seedNodeIds = componentSeedNodeIds[componentId];
+        const auto& [sourceId, targetId] = _edgesNodeIds[edgeId];
+
+        for(auto nodeId : {sourceId, targetId})
+        {
+            if(isSurvivingNodeId(nodeId, componentId))
+                seedNodeIds.push_back(nodeId);
+        }
+    }
+
+    if(!std::all_of(componentSeedNodeIds.begin(), componentSeedNodeIds.end(),
+        [this](const auto& seedNodeIds) { return u::contains(_componentsMap, seedNodeIds.first); }))
+    {
+        return false;
+    }
+
+    // Every element that was added or removed starts out unassigned
+    for(auto nodeId : addedNodeIds)
+        componentIdChanges._nodes[nodeId].setToNull();
+
+    for(auto nodeId : removedNodeIds)
+        componentIdChanges._nodes[nodeId].setToNull();
+
+    for(auto edgeId : addedEdgeIds)
+        componentIdChanges._edges[edgeId].setToNull();
+
+    for(auto edgeId : removedEdgeIds)
+        componentIdChanges._edges[edgeId].setToNull();
+
+    ComponentIdSet newComponentIds;
+    std::map<ComponentId, std::vector<ComponentId>> componentPieces;
+
+    // The components whose existing elements must be filtered, once all the changes are known
+    std::set<ComponentId> componentIdsToPrune;
+
+    for(const auto& componentSeeds : componentSeedNodeIds)
+    {
+        auto componentId = componentSeeds.first;
+        componentIdsToPrune.insert(componentId);
+
+        auto splitOffNodeIds = findSplitOffNodeIds(graph, componentSeeds.second,
+            [&](NodeId nodeId) { return isSurvivingNodeId(nodeId, componentId); });
+
+        if(splitOffNodeIds.empty())
+            continue;
+
+        auto& pieces = componentPieces[componentId];
+        pieces.push_back(componentId);
+
+        for(const auto& nodeIds : splitOffNodeIds)
+        {
+            auto pieceComponentId = generateComponentId();
+            newComponentIds.insert(pieceComponentId);
+            pieces.push_back(pieceComponentId);
+
+            auto& componentUpdate = componentUpdates[pieceComponentId];
+            componentUpdate._replace = true;
+
+            for(auto nodeId : nodeIds)
+            {
+                componentIdChanges._nodes[nodeId] = pieceComponentId;
+                componentUpdate._nodeIds.push_back(nodeId);
+
+                for(auto edgeId : graph->edgeIdsForNodeId(nodeId))
+                {
+                    if(!isSurvivingEdgeId(edgeId) ||
+                        newComponentIdOf(edgeId, componentIdChanges) == pieceComponentId)
+                    {
+                        continue;
+                    }
+
+                    for(auto mergedEdgeId : graph->mergedEdgeIdsForEdgeId(edgeId))
+                        componentIdChanges._edges[mergedEdgeId] = pieceComponentId;
+
+                    componentUpdate._edgeIds.push_back(edgeId);
+                }
+            }
+        }
+    }
+
+    // Removing the head of a multi-edge promotes another of its edges without notification
+    EdgeIdSet promotedEdgeIds;
+    for(auto edgeId : removedEdgeIds)
+    {
+        auto componentId = _edgesComponentId[edgeId];
+        const auto& [sourceId, targetId] = _edgesNodeIds[edgeId];
+
+        if(componentId.isNull() || !isSurvivingNodeId(sourceId, componentId) ||
+            !isSurvivingNodeId(targetId, componentId))
+        {
+            continue;
+        }
+
+        for(auto parallelEdgeId : graph->edgeIdsBetween(sourceId, targetId))
+        {
+            // Edges that have been relabelled are already part of a piece
+            if(!isSurvivingEdgeId(parallelEdgeId) || u::contains(componentIdChanges._edges, parallelEdgeId))
+                continue;
+
+            if(promotedEdgeIds.insert(parallelEdgeId).second)
+                componentUpdates[componentId]._edgeIds.push_back(parallelEdgeId);
+        }
+    }
+
+    std::vector<EdgeId> bridgeEdgeIds;
+
+    // New nodes form new components, at least initially
+    for(auto nodeId : addedNodeIds)
+    {
+        if(!graph->containsNodeId(nodeId) || nodeIdFiltered(nodeId) ||
+            !newComponentIdOf(nodeId, componentIdChanges).isNull())
+        {
+            continue;
+        }
+
+        auto newComponentId = generateComponentId();
+        newComponentIds.insert(newComponentId);
+
+        auto& componentUpdate = componentUpdates[newComponentId];
+        componentUpdate._replace = true;
+        assignLocalElementsComponentId(graph, nodeId, newComponentId, addedNodeIds,
+            componentIdChanges, componentUpdate, bridgeEdgeIds);
+    }
+
+    // Union the components that are joined by new edges
+    bridgeEdgeIds.insert(bridgeEdgeIds.end(), addedEdgeIds.begin(), addedEdgeIds.end());
+
+    std::map<ComponentId, ComponentId> parents;
+    auto findRoot = [&parents](ComponentId componentId)
+    {
+        while(u::contains(parents, componentId))
+            componentId = parents.at(componentId);
+
+        return componentId;
+    };
+
+    for(auto edgeId : bridgeEdgeIds)
+    {
+        if(!graph->containsEdgeId(edgeId) || edgeIdFiltered(edgeId) ||
+            !newComponentIdOf(edgeId, componentIdChanges).isNull())
+        {
+            continue;
+        }
+
+        const auto& edge = graph->edgeById(edgeId);
+        auto sourceRootId = findRoot(newComponentIdOf(edge.sourceId(), componentIdChanges));
+        auto targetRootId = findRoot(newComponentIdOf(edge.targetId(), componentIdChanges));
+        Q_ASSERT(!sourceRootId.isNull() && !targetRootId.isNull());
+
+        if(sourceRootId != targetRootId)
+            parents[sourceRootId] = targetRootId;
+    }
+
+    std::map<ComponentId, ComponentIdSet> unions;
+    for(const auto& parent : parents)
+    {
+        auto rootId = findRoot(parent.first);
+        unions[rootId].insert(parent.first);
+        unions[rootId].insert(rootId);
+    }
+
+    auto componentSize = [&](ComponentId componentId)
+    {
+        size_t size = 0;
+
+        if(u::contains(componentUpdates, componentId))
+        {
+            const auto& componentUpdate = componentUpdates.at(componentId);
+            size += componentUpdate._nodeIds.size();
+
+            if(componentUpdate._replace)
+                return size;
+        }
+
+        if(u::contains(_componentsMap, componentId))
+            size += _componentsMap.at(componentId)->_nodeIds.size();
+
+        return size;
+    };
+
+    auto isNewComponentId = [&newComponentIds](ComponentId componentId)
+    {
+        return u::contains(newComponentIds, componentId);
+    };
+
+    // Turns an update into the complete contents of an existing component, by keeping
+    // whichever of its current elements haven't been removed or moved elsewhere
+    auto completeUpdate = [&](ComponentId componentId, ComponentUpdate& componentUpdate)
+    {
+        if(componentUpdate._replace)
+            return;
+
+        const auto* component = _componentsMap.at(componentId).get();
+        NodeIdSet updateNodeIds(componentUpdate._nodeIds.begin(), componentUpdate._nodeIds.end());
+        EdgeIdSet updateEdgeIds(componentUpdate._edgeIds.begin(), componentUpdate._edgeIds.end());
+
+        std::vector<NodeId> nodeIds;
+        nodeIds.reserve(component->_nodeIds.size() + componentUpdate._nodeIds.size());
+        for(auto nodeId : component->_nodeIds)
+        {
+            if(newComponentIdOf(nodeId, componentIdChanges) == componentId && !u::contains(updateNodeIds, nodeId))
+                nodeIds.push_back(nodeId);
+        }
+
+        std::vector<EdgeId> edgeIds;
+        edgeIds.reserve(component->_edgeIds.size() + componentUpdate._edgeIds.size());
+        for(auto edgeId : component->_edgeIds)
+        {
+            if(newComponentIdOf(edgeId, componentIdChanges) == componentId &&
+                !edgeIdFiltered(edgeId) && !u::contains(updateEdgeIds, edgeId))
+            {
+                edgeIds.push_back(edgeId);
+            }
+        }
+
+        nodeIds.insert(nodeIds.end(), componentUpdate._nodeIds.begin(), componentUpdate._nodeIds.end());
+        edgeIds.insert(edgeIds.end(), componentUpdate._edgeIds.begin(), componentUpdate._edgeIds.end());
+
+        componentUpdate._replace = true;
+        componentUpdate._nodeIds = std::move(nodeIds);
+        componentUpdate._edgeIds = std::move(edgeIds);
+    };
+
+    // Moves everything in one component to another
+    auto absorbComponent = [&](ComponentId fromComponentId, ComponentId toComponentId)
+    {
+        ComponentUpdate from;
+
+        if(u::contains(componentUpdates, fromComponentId))
+        {
+            from = std::move(componentUpdates.at(fromComponentId));
+            componentUpdates.erase(fromComponentId);
+        }
+
+        completeUpdate(fromComponentId, from);
+
+        for(auto nodeId : from._nodeIds)
+        {
+            for(auto mergedNodeId : graph->mergedNodeIdsForNodeId(nodeId))
+                componentIdChanges._nodes[mergedNodeId] = toComponentId;
+        }
+
+        for(auto edgeId : from._edgeIds)
+        {
+            for(auto mergedEdgeId : graph->mergedEdgeIdsForEdgeId(edgeId))
+                componentIdChanges._edges[mergedEdgeId] = toComponentId;
+        }
+
+        auto& to = componentUpdates[toComponentId];
+        to._nodeIds.insert(to._nodeIds.end(), from._nodeIds.begin(), from._nodeIds.end());
+        to._edgeIds.insert(to._edgeIds.end(), from._edgeIds.begin(), from._edgeIds.end());
+    };
+
+    std::map<ComponentId, ComponentId> mergedInto;
+    for(const auto& componentUnion : unions)
+    {
+        const auto& componentIds = componentUnion.second;
+
+        // Prefer to keep an existing component, and the largest one, as it requires the least relabelling
+        auto survivingComponentId = *std::max_element(componentIds.begin(), componentIds.end(),
+        [&](auto a, auto b)
+        {
+            if(isNewComponentId(a) != isNewComponentId(b))
+                return isNewComponentId(a);
+
+            return componentSize(a) < componentSize(b);
+        });
+
+        ComponentIdSet mergers;
+
+        for(auto componentId : componentIds)
+        {
+            if(!isNewComponentId(componentId))
+                mergers.insert(componentId);
+
+            if(componentId == survivingComponentId)
+                continue;
+
+            absorbComponent(componentId, survivingComponentId);
+            mergedInto[componentId] = survivingComponentId;
+
+            if(isNewComponentId(componentId))
+            {
+                // Never announced, so can be reused immediately
+                _vacatedComponentIdQueue.push(componentId);
+            }
+            else
+            {
+                changes._mergedComponentIds.insert(componentId);
+                changes._componentIdsToBeRemoved.push_back(componentId);
+            }
+        }
+
+        if(mergers.size() > 1)
+            changes._mergedComponents[survivingComponentId] = std::move(mergers);
     }
 
+    // Assign the new edges that weren't reached by any of the traversals
+    for(auto edgeId : bridgeEdgeIds)
+    {
+        if(!graph->containsEdgeId(edgeId) || !newComponentIdOf(edgeId, componentIdChanges).isNull())
+            continue;
+
+        const auto& edge = graph->edgeById(edgeId);
+        auto componentId = newComponentIdOf(edge.sourceId(), componentIdChanges);
+
+        if(componentId.isNull())
+            continue;
+
+        if(edgeIdFiltered(edgeId))
+        {
+            componentIdChanges._edges[edgeId] = componentId;
+            continue;
+        }
+
+        for(auto mergedEdgeId : graph->mergedEdgeIdsForEdgeId(edgeId))
+            componentIdChanges._edges[mergedEdgeId] = componentId;
+
+        componentUpdates[componentId]._edgeIds.push_back(edgeId);
+
+        // Adding to a multi-edge may change which of its edges is the head
+        if(graph->typeOf(edgeId) != MultiElementType::Not)
+            componentIdsToPrune.insert(componentId);
+    }
+
+    for(auto componentId : componentIdsToPrune)
+    {
+        // Absorbed components have already been dealt with
+        if(u::contains(mergedInto, componentId))
+            continue;
+
+        auto& componentUpdate = componentUpdates[componentId];
+        completeUpdate(componentId, componentUpdate);
+
+        if(componentUpdate._nodeIds.empty())
+        {
+            componentUpdates.erase(componentId);
+            changes._componentIdsToBeRemoved.push_back(componentId);
+        }
+    }
+
+    auto resolve = [&mergedInto](ComponentId componentId)
+    {
+        return u::contains(mergedInto, componentId) ? mergedInto.at(componentId) : componentId;
+    };
+
+    for(auto componentId : newComponentIds)
+    {
+        if(!u::contains(mergedInto, componentId))
+            changes._componentIdsToBeAdded.push_back(componentId);
+    }
+
+    for(const auto& [componentId, pieces] : componentPieces)
+    {
+        if(pieces.size() < 2 || u::contains(mergedInto, componentId))
+            continue;
+
+        ComponentIdSet splitters;
+
+        for(auto pieceComponentId : pieces)
+        {
+            auto resolvedComponentId = resolve(pieceComponentId);
+
+            if(resolvedComponentId == componentId || isNewComponentId(resolvedComponentId))
+                splitters.insert(resolvedComponentId);
+        }
+
+        if(splitters.size() > 1)
+        {
+            for(auto splitter : splitters)
+            {
+                if(splitter != componentId)
+                    changes._splitComponentIds.insert(splitter);
+            }
+
+            changes._splitComponents[componentId] = std::move(splitters);
+        }
+    }
+
+    // Only elements that have been added or removed can have gained or lost their component
+    std::vector<NodeId> changedNodeIds;
+    std::set_union(addedNodeIds.begin(), addedNodeIds.end(),
+        removedNodeIds.begin(), removedNodeIds.end(), std::back_inserter(changedNodeIds));
+    for(auto nodeId : changedNodeIds)
+    {
+        auto oldComponentId = _nodesComponentId[nodeId];
+        auto newComponentId = newComponentIdOf(nodeId, componentIdChanges);
+
+        if(oldComponentId.isNull() && !newComponentId.isNull())
+            changes._nodeIdAdds[newComponentId].emplace_back(nodeId);
+        else if(!oldComponentId.isNull() && newComponentId.isNull())
+            changes._nodeIdRemoves[oldComponentId].emplace_back(nodeId);
+    }
+
+    std::vector<EdgeId> changedEdgeIds;
+    std::set_union(addedEdgeIds.begin(), addedEdgeIds.end(),
+        removedEdgeIds.begin(), removedEdgeIds.end(), std::back_inserter(changedEdgeIds));
+    for(auto edgeId : changedEdgeIds)
+    {
+        auto oldComponentId = _edgesComponentId[edgeId];
+        auto newComponentId = newComponentIdOf(edgeId, componentIdChanges);
+
+        if(oldComponentId.isNull() && !newComponentId.isNull())
+            changes._edgeIdAdds[newComponentId].emplace_back(edgeId);
+        else if(!oldComponentId.isNull() && newComponentId.isNull())
+            changes._edgeIdRemoves[oldComponentId].emplace_back(edgeId);
+    }
+
+    // Remember where the new edges are, in case they are later removed
+    for(auto edgeId : addedEdgeIds)
+    {
+        if(graph->containsEdgeId(edgeId))
+        {
+            const auto& edge = graph->edgeById(edgeId);
+            _edgesNodeIds[edgeId] = {edge.sourceId(), edge.targetId()};
+        }
+    }
+
+    return true;
+}
+
+void ComponentManager::clearGraphChanges()
+{
+    _addedNodeIds.clear();
+    _removedNodeIds.clear();
+    _addedEdgeIds.clear();
+    _removedEdgeIds.clear();
+}
+
+void ComponentManager::update(const Graph* graph)
+{
+    if(_debug) qDebug() << "ComponentManager::update begins" << this;
+
+    std::unique_lock<std::recursive_mutex> lock(_updateMutex);
+
+    Changes changes;
+    ComponentIdChanges componentIdChanges;
+    ComponentUpdates componentUpdates;
+
+    // An incremental update only records the component IDs that change, whereas a full
+    // update assigns them all afresh
+    std::optional<NodeArray<ComponentId>> newNodesComponentId;
+    std::optional<EdgeArray<ComponentId>> newEdgesComponentId;
+
+    if(!findChangesIncrementally(graph, changes, componentIdChanges, componentUpdates))
+    {
+        newNodesComponentId.emplace(*graph);
+        newEdgesComponentId.emplace(*graph);
+        findChanges(graph, changes, *newNodesComponentId, *newEdgesComponentId);
+    }
+
+    clearGraphChanges();
+
+    // Resize the component arrays
+    for(auto* componentArray : _componentArrays)
+        componentArray->resize(componentArrayCapacity());
+
     // Notify all the merges
-    for(auto& mergee : mergedComponents)
+    for(auto& mergee : changes._mergedComponents)
     {
         if(_debug) qDebug() << "componentsWillMerge" << mergee.second << "->" << mergee.first;
         emit componentsWillMerge(graph, ComponentMergeSet(std::move(mergee.second), mergee.first));
     }
 
     // Removed components
-    for(auto componentId : componentIdsToBeRemoved)
+    for(auto componentId : changes._componentIdsToBeRemoved)
     {
         Q_ASSERT(!componentId.isNull());
         if(_debug) qDebug() << "componentWillBeRemoved" << componentId;
-        bool hasMerged = u::contains(mergedComponentIds, componentId);
+        bool hasMerged = u::contains(changes._mergedComponentIds, componentId);
         emit componentWillBeRemoved(graph, componentId, hasMerged);
 
         if(!hasMerged)
         {
-            nodeIdRemoves.erase(componentId);
-            edgeIdRemoves.erase(componentId);
+            changes._nodeIdRemoves.erase(componentId);
+            changes._edgeIdRemoves.erase(componentId);
         }
 
         u::removeByValue(_componentIds, componentId);
         removeGraphComponent(componentId);
     }
 
-    _nodesComponentId = std::move(newNodesComponentId);
-    _edgesComponentId = std::move(newEdgesComponentId);
+    if(newNodesComponentId && newEdgesComponentId)
+    {
+        _nodesComponentId = std::move(*newNodesComponentId);
+        _edgesComponentId = std::move(*newEdgesComponentId);
+    }
+    else
+    {
+        for(const auto& [nodeId, componentId] : componentIdChanges._nodes)
+            _nodesComponentId[nodeId] = componentId;
+
+        for(const auto& [edgeId, componentId] : componentIdChanges._edges)
+            _edgesComponentId[edgeId] = componentId;
+    }
 
     updateGraphComponents(graph);
+    applyComponentUpdates(graph, componentUpdates);
 
     _updatesRequired.clear();
 
-    std::copy(componentIdsToBeAdded.begin(), componentIdsToBeAdded.end(),
+    std::copy(changes._componentIdsToBeAdded.begin(), changes._componentIdsToBeAdded.end(),
         std::back_inserter(_componentIds));
 
     std::stable_sort(_componentIds.begin(), _componentIds.end(),
@@ -268,47 +1029,47 @@ void ComponentManager::update(const Graph* graph)
     lock.unlock();
 
     // Notify all the new components
-    for(auto componentId : componentIdsToBeAdded)
+    for(auto componentId : changes._componentIdsToBeAdded)
     {
         Q_ASSERT(!componentId.isNull());
         if(_debug) qDebug() << "componentAdded" << componentId;
-        bool hasSplit = u::contains(splitComponentIds, componentId);
+        bool hasSplit = u::contains(changes._splitComponentIds, componentId);
         emit componentAdded(graph, componentId, hasSplit);
 
         if(!hasSplit)
         {
-            nodeIdAdds.erase(componentId);
-            edgeIdAdds.erase(componentId);
+            changes._nodeIdAdds.erase(componentId);
+            changes._edgeIdAdds.erase(componentId);
         }
     }
 
     // Notify all the splits
-    for(auto& splitee : splitComponents)
+    for(auto& splitee : changes._splitComponents)
     {
         if(_debug) qDebug() << "componentSplit" << splitee.first << "->" << splitee.second;
         emit componentSplit(graph, ComponentSplitSet(splitee.first, std::move(splitee.second)));
     }
 
     // Notify node adds and removes
-    for(auto& nodeIdAdd : nodeIdAdds)
+    for(auto& nodeIdAdd : changes._nodeIdAdds)
     {
         for(auto nodeId : nodeIdAdd.second)
             emit nodeAddedToComponent(graph, nodeId, nodeIdAdd.first);
     }
 
-    for(auto& edgeIdAdd : edgeIdAdds)
+    for(auto& edgeIdAdd : changes._edgeIdAdds)
     {
         for(auto edgeId : edgeIdAdd.second)
             emit edgeAddedToComponent(graph, edgeId, edgeIdAdd.first);
     }
 
-    for(auto& nodeIdRemove : nodeIdRemoves)
+    for(auto& nodeIdRemove : changes._nodeIdRemoves)
     {
         for(auto nodeId : nodeIdRemove.second)
             emit nodeRemovedFromComponent(graph, nodeId, nodeIdRemove.first);
     }
 
-    for(auto& edgeIdRemove : edgeIdRemoves)
+    for(auto& edgeIdRemove : changes._edgeIdRemoves)
     {
         for(auto edgeId : edgeIdRemove.second)
             emit edgeRemovedFromComponent(graph, edgeId, edgeIdRemove.first);
@@ -345,6 +1106,9 @@ void ComponentManager::queueGraphComponentUpdate(const Graph* graph, ComponentId
 
 void ComponentManager::updateGraphComponents(const Graph* graph)
 {
+    if(_updatesRequired.empty())
+        return;
+
     for(auto& graphComponent : _componentsMap)
     {
         if(u::contains(_updatesRequired, graphComponent.first))
@@ -377,6 +1141,30 @@ void ComponentManager::updateGraphComponents(const Graph* graph)
     }
 }
 
+void ComponentManager::applyComponentUpdates(const Graph* graph, ComponentUpdates& componentUpdates)
+{
+    for(auto& [componentId, componentUpdate] : componentUpdates)
+    {
+        auto& graphComponent = _componentsMap[componentId];
+
+        if(graphComponent == nullptr)
+            graphComponent = std::make_unique<GraphComponent>(graph);
+
+        if(componentUpdate._replace)
+        {
+            graphComponent->_nodeIds = std::move(componentUpdate._nodeIds);
+            graphComponent->_edgeIds = std::move(componentUpdate._edgeIds);
+        }
+        else
+        {
+            graphComponent->_nodeIds.insert(graphComponent->_nodeIds.end(),
+                componentUpdate._nodeIds.begin(), componentUpdate._nodeIds.end());
+            graphComponent->_edgeIds.insert(graphComponent->_edgeIds.end(),
+                componentUpdate._edgeIds.begin(), componentUpdate._edgeIds.end());
+        }
+    }
+}
+
 void ComponentManager::removeGraphComponent(ComponentId componentId)
 {
     if(u::contains(_componentsMap, componentId))
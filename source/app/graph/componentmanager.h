@@ -27,6 +27,7 @@
 #include <queue>
 #include <mutex>
 #include <vector>
+#include <utility>
 #include <functional>
 #include <algorithm>
 #include <memory>
@@ -87,6 +88,40 @@ public:
     ~ComponentManager() override;
 
 private:
+    // What changed as the result of an update, in terms of the signals to be emitted
+    struct Changes
+    {
+        std::map<ComponentId, ComponentIdSet> _splitComponents;
+        ComponentIdSet _splitComponentIds;
+        std::map<ComponentId, ComponentIdSet> _mergedComponents;
+        ComponentIdSet _mergedComponentIds;
+
+        std::vector<ComponentId> _componentIdsToBeAdded;
+        std::vector<ComponentId> _componentIdsToBeRemoved;
+
+        std::map<ComponentId, std::vector<NodeId>> _nodeIdAdds;
+        std::map<ComponentId, std::vector<EdgeId>> _edgeIdAdds;
+        std::map<ComponentId, std::vector<NodeId>> _nodeIdRemoves;
+        std::map<ComponentId, std::vector<EdgeId>> _edgeIdRemoves;
+    };
+
+    // The new contents of a component, either replacing or appended to its existing contents
+    struct ComponentUpdate
+    {
+        bool _replace = false;
+        std::vector<NodeId> _nodeIds;
+        std::vector<EdgeId> _edgeIds;
+    };
+
+    using ComponentUpdates = std::map<ComponentId, ComponentUpdate>;
+
+    // The elements whose component an incremental update changes, and their new component
+    struct ComponentIdChanges
+    {
+        NodeIdMap<ComponentId> _nodes;
+        EdgeIdMap<ComponentId> _edges;
+    };
+
     std::vector<ComponentId> _componentIds;
     ComponentId _nextComponentId;
     std::queue<ComponentId> _vacatedComponentIdQueue;
@@ -95,6 +130,9 @@ private:
     NodeArray<ComponentId> _nodesComponentId;
     EdgeArray<ComponentId> _edgesComponentId;
 
+    // The ends of each edge as of the last update, which are otherwise lost when it's removed
+    EdgeArray<std::pair<NodeId, NodeId>> _edgesNodeIds;
+
     mutable std::recursive_mutex _updateMutex;
 
     std::mutex _componentArraysMutex;
@@ -103,16 +141,48 @@ private:
     bool _enabled = true;
     bool _debug = false;
 
+    // The changes to the graph since the last update
+    std::vector<NodeId> _addedNodeIds;
+    std::vector<NodeId> _removedNodeIds;
+    std::vector<EdgeId> _addedEdgeIds;
+    std::vector<EdgeId> _removedEdgeIds;
+
+    // Merged nodes and custom filters can change connectivity without any
+    // corresponding change signals, in which case a full update is required
+    bool _hasCustomFilters = false;
+    bool _incrementalUpdatePossible = false;
+
     ComponentId generateComponentId();
     void queueGraphComponentUpdate(const Graph* graph, ComponentId componentId);
     void updateGraphComponents(const Graph* graph);
     void removeGraphComponent(ComponentId componentId);
 
+    void applyComponentUpdates(const Graph* graph, ComponentUpdates& componentUpdates);
+
     void update(const Graph* graph);
+    void findChanges(const Graph* graph, Changes& changes,
+                     NodeArray<ComponentId>& newNodesComponentId,
+                     EdgeArray<ComponentId>& newEdgesComponentId);
+    bool findChangesIncrementally(const Graph* graph, Changes& changes,
+                                  ComponentIdChanges& componentIdChanges,
+                                  ComponentUpdates& componentUpdates);
+    void clearGraphChanges();
+
     int componentArrayCapacity() const { return static_cast<int>(_nextComponentId); }
     ComponentIdSet assignConnectedElementsComponentId(const Graph* graph, NodeId rootId, ComponentId componentId,
                                                       NodeArray<ComponentId>& nodesComponentId,
                                                       EdgeArray<ComponentId>& edgesComponentId);
+    // Returns the pieces of a component that no longer connect to the rest of it, starting
+    // from the seeds, which must include a node of each piece; the remainder isn't returned
+    std::vector<std::vector<NodeId>> findSplitOffNodeIds(const Graph* graph,
+        const std::vector<NodeId>& seedNodeIds, const NodeConditionFn& isMember) const;
+    ComponentId newComponentIdOf(NodeId nodeId, const ComponentIdChanges& componentIdChanges) const;
+    ComponentId newComponentIdOf(EdgeId edgeId, const ComponentIdChanges& componentIdChanges) const;
+    void assignLocalElementsComponentId(const Graph* graph, NodeId rootId, ComponentId componentId,
+                                        const std::vector<NodeId>& addedNodeIds,
+                                        ComponentIdChanges& componentIdChanges,
+                                        ComponentUpdate& componentUpdate,
+                                        std::vector<EdgeId>& bridgeEdgeIds);
 
     void insertComponentArray(IGraphArray* componentArray);
     void eraseComponentArray(IGraphArray* componentArray);
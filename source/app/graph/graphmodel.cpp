@@ -23,8 +23,10 @@
 
 #include "graph/mutablegraph.h"
 #include "shared/graph/grapharray.h"
+#include "shared/graph/elementid_bitset.h"
 
 #include "layout/nodepositions.h"
+#include "layout/nodebvh.h"
 
 #include "ui/selectionmanager.h"
 #include "ui/searchmanager.h"
@@ -73,6 +75,8 @@
 #include <QRegularExpression>
 
 #include <utility>
+#include <mutex>
+#include <atomic>
 
 using NodeVisuals = NodeArray<ElementVisual>;
 using EdgeVisuals = EdgeArray<ElementVisual>;
@@ -118,11 +122,99 @@ private:
     // corresponding visualisation
     bool _hasValidEdgeTextVisualisation = false;
 
-    NodeIdSet _selectedNodeIds;
-    NodeIdSet _foundNodeIds;
-    NodeIdSet _highlightedNodeIds;
+    NodeIdBitSet _selectedNodeIds;
+    NodeIdBitSet _foundNodeIds;
+    NodeIdBitSet _highlightedNodeIds;
 
     bool _nodesMaskActive = false;
+
+    // When set, every visual is recalculated by the next update, otherwise
+    // only the states of stale nodes (and their edges) are recalculated
+    bool _visualsRequireFullUpdate = true;
+    NodeIdBitSet _nodesWithStaleVisualState;
+
+    Flags<VisualFlags> nodeVisualState(NodeId nodeId) const
+    {
+        Flags<VisualFlags> state;
+
+        auto nodeIsSelected = _selectedNodeIds.contains(nodeId);
+        state.setState(VisualFlags::Selected, nodeIsSelected);
+
+        auto isNotFound = !_foundNodeIds.empty() && !_foundNodeIds.contains(nodeId);
+        auto isNotHighlighted = !_highlightedNodeIds.empty() && nodeIsSelected &&
+            !_highlightedNodeIds.contains(nodeId);
+
+        state.setState(VisualFlags::Unhighlighted, (isNotFound && _nodesMaskActive) || isNotHighlighted);
+
+        return state;
+    }
+
+    // Materialised attribute values, which are only valid while their
+    // version matches the current _attributeValuesVersion
+    std::mutex _attributeColumnsMutex;
+    uint64_t _attributeValuesVersion = 0;
+    std::map<QString, std::shared_ptr<const AttributeColumn<NodeId>>> _nodeAttributeColumns;
+    std::map<QString, std::shared_ptr<const AttributeColumn<EdgeId>>> _edgeAttributeColumns;
+
+public:
+    template<typename E>
+    std::shared_ptr<const AttributeColumn<E>> materialise(const Attribute& attribute, const QString& name,
+        std::map<QString, std::shared_ptr<const AttributeColumn<E>>>& columns)
+    {
+        std::unique_lock<std::mutex> lock(_attributeColumnsMutex);
+
+        auto it = columns.find(name);
+        if(it != columns.end() && it->second->version() == _attributeValuesVersion)
+            return it->second;
+
+        auto column = std::make_shared<const AttributeColumn<E>>(
+            _transformedGraph, attribute, _attributeValuesVersion);
+        columns[name] = column;
+
+        return column;
+    }
+
+    // Spatial indexes, which are refitted whenever the positions have
+    // changed since they were last used, and discarded when the graph changes
+    std::mutex _nodeBVHsMutex;
+    std::map<ComponentId, std::shared_ptr<NodeBVH>> _nodeBVHs;
+
+    std::shared_ptr<const NodeBVH> nodeBVH(ComponentId componentId)
+    {
+        std::unique_lock<std::mutex> lock(_nodeBVHsMutex);
+        std::unique_lock<NodePositions> nodePositionsLock(_nodePositions);
+
+        auto& bvh = _nodeBVHs[componentId];
+
+        if(bvh != nullptr && bvh->epoch() != _nodePositions.epoch())
+        {
+            // Trees are only handed out while the mutex is held, so if no one else has
+            // a reference, no one can be querying it, and it's safe to refit in place
+            if(bvh.use_count() == 1)
+            {
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if(!bvh->refit(_nodePositions))
+                    bvh = nullptr;
+            }
+            else
+                bvh = bvh->refitted(_nodePositions);
+        }
+
+        if(bvh == nullptr)
+        {
+            const auto* component = _transformedGraph.componentById(componentId);
+            if(component == nullptr)
+            {
+                _nodeBVHs.erase(componentId);
+                return nullptr;
+            }
+
+            bvh = std::make_shared<NodeBVH>(component->nodeIds(), _nodePositions);
+        }
+
+        return bvh;
+    }
 };
 
 GraphModel::GraphModel(QString name, IPlugin* plugin) :
@@ -144,6 +236,8 @@ GraphModel::GraphModel(QString name, IPlugin* plugin) :
 
     connect(&_->_transformedGraph, &Graph::graphWillChange, this, &GraphModel::onTransformedGraphWillChange, Qt::DirectConnection);
     connect(&_->_transformedGraph, &Graph::graphChanged, this, &GraphModel::onTransformedGraphChanged, Qt::DirectConnection);
+    connect(&_->_transformedGraph, &TransformedGraph::attributeValuesChanged, this,
+        &GraphModel::invalidateAttributeColumns, Qt::DirectConnection);
     connect(&_->_transformedGraph, &TransformedGraph::attributeValuesChanged, this,
         &GraphModel::attributeValuesChanged, Qt::DirectConnection);
 
@@ -249,6 +343,21 @@ void GraphModel::removeDynamicAttributes()
         _->_attributes.erase(attributeName);
 }
 
+void GraphModel::invalidateAttributeColumns()
+{
+    std::unique_lock<std::mutex> lock(_->_attributeColumnsMutex);
+
+    _->_attributeValuesVersion++;
+    _->_nodeAttributeColumns.clear();
+    _->_edgeAttributeColumns.clear();
+}
+
+void GraphModel::invalidateNodeBVHs()
+{
+    std::unique_lock<std::mutex> lock(_->_nodeBVHsMutex);
+    _->_nodeBVHs.clear();
+}
+
 QString GraphModel::normalisedAttributeName(QString attribute) const
 {
     // Dots in attribute names are disallowed as they conflict with
@@ -291,11 +400,21 @@ const ElementVisual& GraphModel::edgeVisual(EdgeId edgeId) const { return _->_ed
 NodePositions& GraphModel::nodePositions() { return _->_nodePositions; }
 const NodePositions& GraphModel::nodePositions() const { return _->_nodePositions; }
 
+std::shared_ptr<const NodeBVH> GraphModel::nodeBVH(ComponentId componentId) const
+{
+    // The components can't be read consistently while the graph is changing
+    if(_transformedGraphIsChanging)
+        return nullptr;
+
+    return _->nodeBVH(componentId);
+}
+
 const NodeArray<QString>& GraphModel::nodeNames() const { return _->_nodeNames; }
 QString GraphModel::nodeName(NodeId nodeId) const { return _->_nodeNames[nodeId]; }
 void GraphModel::setNodeName(NodeId nodeId, const QString& name)
 {
     _->_nodeNames[nodeId] = name;
+    invalidateAttributeColumns();
     updateVisuals();
 }
 
@@ -634,11 +753,13 @@ void GraphModel::buildVisualisations(const QStringList& visualisations)
         switch(attribute.elementType())
         {
         case ElementType::Node:
-            nodeVisualisationsBuilder.build(attribute, *channel, visualisationConfig, index, info);
+            nodeVisualisationsBuilder.build(attribute, materialisedNodeAttribute(attributeName).get(),
+                *channel, visualisationConfig, index, info);
             break;
 
         case ElementType::Edge:
-            edgeVisualisationsBuilder.build(attribute, *channel, visualisationConfig, index, info);
+            edgeVisualisationsBuilder.build(attribute, materialisedEdgeAttribute(attributeName).get(),
+                *channel, visualisationConfig, index, info);
             break;
 
         default:
@@ -760,18 +881,23 @@ Attribute& GraphModel::createAttribute(QString name)
     if(_transformedGraphIsChanging)
         attribute.setFlag(AttributeFlag::Dynamic);
 
+    invalidateAttributeColumns();
+
     return attribute;
 }
 
 void GraphModel::addAttributes(const std::map<QString, Attribute>& attributes)
 {
     _->_attributes.insert(attributes.begin(), attributes.end());
+    invalidateAttributeColumns();
 }
 
 void GraphModel::removeAttribute(const QString& name)
 {
     if(u::contains(_->_attributes, name))
         _->_attributes.erase(name);
+
+    invalidateAttributeColumns();
 }
 
 const Attribute* GraphModel::attributeByName(const QString& name) const
@@ -831,6 +957,39 @@ Attribute GraphModel::attributeValueByName(const QString& name) const
     return attribute;
 }
 
+template<typename E>
+static std::shared_ptr<const AttributeColumn<E>> materialisedAttributeFor(const GraphModel& graphModel,
+    const QString& name, bool graphIsChanging, GraphModelImpl& impl,
+    std::map<QString, std::shared_ptr<const AttributeColumn<E>>>& columns)
+{
+    // The transformed graph can't be read consistently while it's changing
+    if(graphIsChanging || !graphModel.attributeExists(name))
+        return nullptr;
+
+    auto attribute = graphModel.attributeValueByName(name);
+
+    if(!attribute.isValid() || !attribute.isOfElementType<E>())
+        return nullptr;
+
+    return impl.materialise(attribute, name, columns);
+}
+
+std::shared_ptr<const AttributeColumn<NodeId>> GraphModel::materialisedNodeAttribute(const QString& name) const
+{
+    return materialisedAttributeFor<NodeId>(*this, name, _transformedGraphIsChanging, *_, _->_nodeAttributeColumns);
+}
+
+std::shared_ptr<const AttributeColumn<EdgeId>> GraphModel::materialisedEdgeAttribute(const QString& name) const
+{
+    return materialisedAttributeFor<EdgeId>(*this, name, _transformedGraphIsChanging, *_, _->_edgeAttributeColumns);
+}
+
+uint64_t GraphModel::attributeValuesVersion() const
+{
+    std::unique_lock<std::mutex> lock(_->_attributeColumnsMutex);
+    return _->_attributeValuesVersion;
+}
+
 static void calculateAttributeRanges(const Graph* graph,
     std::map<QString, Attribute>& attributes)
 {
@@ -888,8 +1047,11 @@ void GraphModel::clearHighlightedNodes()
     if(_->_highlightedNodeIds.empty())
         return;
 
+    // Only selected nodes can be unhighlighted
+    _->_nodesWithStaleVisualState |= _->_selectedNodeIds;
+
     _->_highlightedNodeIds.clear();
-    updateVisuals();
+    updateStaleVisuals();
 }
 
 void GraphModel::highlightNodes(const NodeIdSet& nodeIds)
@@ -897,8 +1059,10 @@ void GraphModel::highlightNodes(const NodeIdSet& nodeIds)
     if(_->_highlightedNodeIds.empty() && nodeIds.empty())
         return;
 
-    _->_highlightedNodeIds = nodeIds;
-    updateVisuals();
+    _->_nodesWithStaleVisualState |= _->_selectedNodeIds;
+
+    _->_highlightedNodeIds = NodeIdBitSet(nodeIds);
+    updateStaleVisuals();
 }
 
 void GraphModel::enableVisualUpdates()
@@ -919,12 +1083,44 @@ static float mappedSize(float min, float max, float user, float mapped)
 }
 
 void GraphModel::updateVisuals()
+{
+    _->_visualsRequireFullUpdate = true;
+    updateStaleVisuals();
+}
+
+void GraphModel::markAllNodeVisualStatesStale()
+{
+    _->_nodesWithStaleVisualState = NodeIdBitSet(graph().nodeIds());
+}
+
+void GraphModel::updateStaleVisuals()
 {
     if(!_visualUpdatesEnabled)
         return;
 
+    if(!_->_visualsRequireFullUpdate && _->_nodesWithStaleVisualState.empty())
+        return;
+
     emit visualsWillChange();
 
+    auto change = VisualChangeFlags::State;
+
+    if(_->_visualsRequireFullUpdate)
+    {
+        updateAllVisuals();
+        change = VisualChangeFlags::All;
+    }
+    else
+        updateVisualStates(_->_nodesWithStaleVisualState);
+
+    _->_visualsRequireFullUpdate = false;
+    _->_nodesWithStaleVisualState.clear();
+
+    emit visualsChanged(change);
+}
+
+void GraphModel::updateAllVisuals()
+{
     auto nodeColor      = u::pref("visuals/defaultNodeColor").value<QColor>();
     auto edgeColor      = u::pref("visuals/defaultEdgeColor").value<QColor>();
     auto multiColor     = u::pref("visuals/multiElementColor").value<QColor>();
@@ -964,28 +1160,13 @@ void GraphModel::updateVisuals()
         else
             _->_nodeVisuals[nodeId]._text = nodeName(nodeId);
 
-        auto nodeIsSelected = u::contains(_->_selectedNodeIds, nodeId);
-
-        _->_nodeVisuals[nodeId]._state.setState(VisualFlags::Selected, nodeIsSelected);
+        auto nodeState = _->nodeVisualState(nodeId);
+        _->_nodeVisuals[nodeId]._state = nodeState;
 
-        if(nodeIsSelected)
+        if(nodeState.anyOf(VisualFlags::Selected, VisualFlags::Unhighlighted))
         {
             for(auto edgeId : graph().edgeIdsForNodeId(nodeId))
-                _->_edgeVisuals[edgeId]._state.setState(VisualFlags::Selected, nodeIsSelected);
-        }
-
-        auto isNotFound = !_->_foundNodeIds.empty() && !u::contains(_->_foundNodeIds, nodeId);
-        auto isNotHighlighted = !_->_highlightedNodeIds.empty() && nodeIsSelected &&
-            !u::contains(_->_highlightedNodeIds, nodeId);
-
-        auto nodeUnhighlighted = (isNotFound && _->_nodesMaskActive) || isNotHighlighted;
-
-        _->_nodeVisuals[nodeId]._state.setState(VisualFlags::Unhighlighted, nodeUnhighlighted);
-
-        if(nodeUnhighlighted)
-        {
-            for(auto edgeId : graph().edgeIdsForNodeId(nodeId))
-                _->_edgeVisuals[edgeId]._state.set(VisualFlags::Unhighlighted);
+                _->_edgeVisuals[edgeId]._state.set(*nodeState);
         }
     }
 
@@ -1023,21 +1204,70 @@ void GraphModel::updateVisuals()
             _->_edgeVisuals[edgeId]._text.clear();
     }
 
-    emit visualsChanged();
+}
+
+void GraphModel::updateVisualStates(const NodeIdBitSet& nodeIds)
+{
+    EdgeIdBitSet edgeIds;
+
+    for(auto nodeId : nodeIds)
+    {
+        // The node may have been removed since it became stale
+        if(!graph().containsNodeId(nodeId))
+            continue;
+
+        _->_nodeVisuals[nodeId]._state = _->nodeVisualState(nodeId);
+
+        for(auto edgeId : graph().edgeIdsForNodeId(nodeId))
+            edgeIds.insert(edgeId);
+    }
+
+    // An edge takes on the states of both of its nodes
+    for(auto edgeId : edgeIds)
+    {
+        const auto& edge = graph().edgeById(edgeId);
+        auto sourceState = _->_nodeVisuals[edge.sourceId()]._state;
+        auto targetState = _->_nodeVisuals[edge.targetId()]._state;
+        auto& edgeState = _->_edgeVisuals[edgeId]._state;
+
+        edgeState.setState(VisualFlags::Selected,
+            sourceState.test(VisualFlags::Selected) || targetState.test(VisualFlags::Selected));
+        edgeState.setState(VisualFlags::Unhighlighted,
+            sourceState.test(VisualFlags::Unhighlighted) || targetState.test(VisualFlags::Unhighlighted));
+    }
 }
 
 void GraphModel::onSelectionChanged(const SelectionManager* selectionManager)
 {
-    _->_selectedNodeIds = selectionManager->selectedNodes();
-    _->_nodesMaskActive = selectionManager->nodesMaskActive();
+    const auto& selectedNodeIds = selectionManager->selectedNodeIds();
+    auto nodesMaskActive = selectionManager->nodesMaskActive();
+
+    if(nodesMaskActive != _->_nodesMaskActive)
+        markAllNodeVisualStatesStale();
+    else
+        _->_nodesWithStaleVisualState |= (_->_selectedNodeIds ^ selectedNodeIds);
+
+    _->_selectedNodeIds = selectedNodeIds;
+    _->_nodesMaskActive = nodesMaskActive;
     clearHighlightedNodes();
-    updateVisuals();
+    updateStaleVisuals();
 }
 
 void GraphModel::onFoundNodeIdsChanged(const SearchManager* searchManager)
 {
-    _->_foundNodeIds = searchManager->foundNodeIds();
-    updateVisuals();
+    const auto& foundNodeIds = searchManager->foundNodeIds();
+
+    // Found nodes only affect visuals when the mask is active
+    if(_->_nodesMaskActive)
+    {
+        if(_->_foundNodeIds.empty() != foundNodeIds.empty())
+            markAllNodeVisualStatesStale();
+        else
+            _->_nodesWithStaleVisualState |= (_->_foundNodeIds ^ foundNodeIds);
+    }
+
+    _->_foundNodeIds = foundNodeIds;
+    updateStaleVisuals();
 }
 
 void GraphModel::onPreferenceChanged(const QString& name, const QVariant&)
@@ -1050,6 +1280,7 @@ void GraphModel::onPreferenceChanged(const QString& name, const QVariant&)
 
 void GraphModel::onMutableGraphChanged(const Graph* graph)
 {
+    invalidateAttributeColumns();
     calculateAttributeRanges(graph, _->_attributes);
 }
 
@@ -1064,11 +1295,14 @@ void GraphModel::onTransformedGraphWillChange(const Graph*)
     removeDynamicAttributes();
 
     _transformedGraphIsChanging = true;
+    invalidateAttributeColumns();
+    invalidateNodeBVHs();
 }
 
 void GraphModel::onTransformedGraphChanged(const Graph* graph)
 {
     _transformedGraphIsChanging = false;
+    invalidateAttributeColumns();
 
     findSharedAttributeValues(graph, _->_attributes);
 
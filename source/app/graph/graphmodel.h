@@ -20,12 +20,16 @@
 #define GRAPHMODEL_H
 
 #include "shared/graph/elementid_containers.h"
+#include "shared/graph/elementid_bitset.h"
 #include "shared/graph/grapharray.h"
 #include "shared/graph/igraphmodel.h"
 
 #include "shared/utils/preferenceswatcher.h"
 
 #include "attributes/attribute.h"
+#include "attributes/attributecolumn.h"
+
+#include "ui/visualisations/elementvisual.h"
 
 #include <QString>
 #include <QStringList>
@@ -35,11 +39,13 @@
 #include <map>
 #include <vector>
 #include <atomic>
+#include <type_traits>
 
 class GraphModelImpl;
 class Graph;
 class MutableGraph;
 class NodePositions;
+class NodeBVH;
 
 class SelectionManager;
 class SearchManager;
@@ -47,7 +53,6 @@ class SearchManager;
 class ICommand;
 class IPlugin;
 
-struct ElementVisual;
 
 class TransformInfo;
 class VisualisationInfo;
@@ -75,6 +80,13 @@ private:
     PreferencesWatcher _preferencesWatcher;
 
     void removeDynamicAttributes();
+
+    void markAllNodeVisualStatesStale();
+    void updateStaleVisuals();
+    void updateAllVisuals();
+    void updateVisualStates(const NodeIdBitSet& nodeIds);
+    void invalidateAttributeColumns();
+    void invalidateNodeBVHs();
     QString normalisedAttributeName(QString attribute) const;
 
     IMutableGraph& mutableGraphImpl() override;
@@ -94,6 +106,10 @@ public:
     NodePositions& nodePositions();
     const NodePositions& nodePositions() const;
 
+    // A spatial index over the current positions of a component's nodes, cached
+    // until the graph changes; it is null while the graph is changing
+    std::shared_ptr<const NodeBVH> nodeBVH(ComponentId componentId) const;
+
     const NodeArray<QString>& nodeNames() const;
 
     QString nodeName(NodeId nodeId) const override;
@@ -151,6 +167,22 @@ public:
     bool attributeIsValid(const QString& name) const;
     Attribute attributeValueByName(const QString& name) const;
 
+    // Snapshots of attribute values, cached until the graph or any attribute value changes
+    std::shared_ptr<const AttributeColumn<NodeId>> materialisedNodeAttribute(const QString& name) const;
+    std::shared_ptr<const AttributeColumn<EdgeId>> materialisedEdgeAttribute(const QString& name) const;
+
+    template<typename E>
+    std::shared_ptr<const AttributeColumn<E>> materialisedAttribute(const QString& name) const
+    {
+        if constexpr(std::is_same_v<E, NodeId>)
+            return materialisedNodeAttribute(name);
+
+        if constexpr(std::is_same_v<E, EdgeId>)
+            return materialisedEdgeAttribute(name);
+    }
+
+    uint64_t attributeValuesVersion() const;
+
     void initialiseAttributeRanges();
     void initialiseUniqueAttributeValues();
 
@@ -176,7 +208,7 @@ private slots:
 
 signals:
     void visualsWillChange();
-    void visualsChanged();
+    void visualsChanged(VisualChangeFlags change);
     void attributesChanged(const QStringList& addedNames, const QStringList& removedNames);
     void attributeValuesChanged(const QStringList& attributeNames);
 };
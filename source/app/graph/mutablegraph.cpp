@@ -23,6 +23,30 @@
 
 #include "shared/utils/container.h"
 
+#include <algorithm>
+#include <atomic>
+
+// Only the outermost of any nested mutations is journalled,
+// as replaying it also reproduces those nested within it
+class MutableGraph::JournalScope
+{
+private:
+    MutableGraph* _graph;
+    bool _outermost;
+
+public:
+    explicit JournalScope(MutableGraph* graph) :
+        _graph(graph), _outermost(graph->_journalDepth++ == 0)
+    {}
+
+    JournalScope(const JournalScope&) = delete;
+    JournalScope& operator=(const JournalScope&) = delete;
+
+    ~JournalScope() { _graph->_journalDepth--; }
+
+    Journal* journal() const { return _outermost ? _graph->_journal.get() : nullptr; }
+};
+
 MutableGraph::MutableGraph(const MutableGraph& other)
 {
     clone(other);
@@ -36,6 +60,13 @@ MutableGraph::~MutableGraph()
 
 void MutableGraph::clear()
 {
+    JournalScope journalScope(this);
+    if(auto* journal = journalScope.journal())
+    {
+        journalInverseSnapshot(*journal);
+        journal->add(Journal::Operation::Clear);
+    }
+
     beginTransaction();
 
     bool changed = numNodes() > 0;
@@ -190,6 +221,10 @@ void MutableGraph::reserveNodeId(NodeId nodeId)
     if(nodeId < nextNodeId())
         return;
 
+    JournalScope journalScope(this);
+    if(auto* journal = journalScope.journal())
+        journal->add(Journal::Operation::ReserveNodeId, nodeId);
+
     auto unusedNodeId = nextNodeId();
 
     Graph::reserveNodeId(nodeId);
@@ -203,6 +238,7 @@ NodeId MutableGraph::addNode(NodeId nodeId)
 {
     Q_ASSERT(!nodeId.isNull());
 
+    JournalScope journalScope(this);
     beginTransaction();
 
     // The requested ID is not available or is out of range, so resize and append
@@ -218,6 +254,17 @@ NodeId MutableGraph::addNode(NodeId nodeId)
     node._inEdgeIds.setCollection(&_e._inEdgeIdsCollection);
     node._outEdgeIds.setCollection(&_e._outEdgeIdsCollection);
 
+    if(auto* journal = journalScope.journal())
+    {
+        journal->add(Journal::Operation::AddNode, nodeId);
+
+        if(journal->_invertible)
+        {
+            journal->beginInverse();
+            journal->addInverse(Journal::Operation::RemoveNode, nodeId);
+        }
+    }
+
     emit nodeAdded(this, nodeId);
     _updateRequired = true;
     endTransaction();
@@ -230,10 +277,58 @@ NodeId MutableGraph::addNode(const INode& node)
     return addNode(node.id());
 }
 
+NodeId MutableGraph::addNodesInBulk(int numNodes)
+{
+    if(numNodes <= 0)
+        return {};
+
+    JournalScope journalScope(this);
+    beginTransaction();
+
+    // Storage is grown once for the whole batch, rather than per node
+    auto firstNodeId = nextNodeId();
+    Graph::reserveNodeId(firstNodeId + (numNodes - 1));
+    _n.resize(static_cast<int>(nextNodeId()));
+
+    for(auto nodeId = firstNodeId; nodeId < nextNodeId(); ++nodeId)
+    {
+        claimNodeId(nodeId);
+        auto& node = nodeBy(nodeId);
+        node._id = nodeId;
+        node._inEdgeIds.setCollection(&_e._inEdgeIdsCollection);
+        node._outEdgeIds.setCollection(&_e._outEdgeIdsCollection);
+
+        if(auto* journal = journalScope.journal())
+        {
+            journal->add(Journal::Operation::AddNode, nodeId);
+
+            if(journal->_invertible)
+            {
+                journal->beginInverse();
+                journal->addInverse(Journal::Operation::RemoveNode, nodeId);
+            }
+        }
+
+        emit nodeAdded(this, nodeId);
+    }
+
+    _updateRequired = true;
+    endTransaction();
+
+    return firstNodeId;
+}
+
 void MutableGraph::removeNode(NodeId nodeId)
 {
     Q_ASSERT(containsNodeId(nodeId));
 
+    JournalScope journalScope(this);
+    if(auto* journal = journalScope.journal())
+    {
+        journalInverseRemoveNode(*journal, nodeId);
+        journal->add(Journal::Operation::RemoveNode, nodeId);
+    }
+
     beginTransaction();
 
     // Remove all edges that touch this node
@@ -330,6 +425,10 @@ void MutableGraph::reserveEdgeId(EdgeId edgeId)
     if(edgeId < nextEdgeId())
         return;
 
+    JournalScope journalScope(this);
+    if(auto* journal = journalScope.journal())
+        journal->add(Journal::Operation::ReserveEdgeId, edgeId);
+
     auto unusedEdgeId = nextEdgeId();
 
     Graph::reserveEdgeId(edgeId);
@@ -375,6 +474,7 @@ EdgeId MutableGraph::addEdge(EdgeId edgeId, NodeId sourceId, NodeId targetId)
     Q_ASSERT(_n._nodeIdsInUse[static_cast<int>(sourceId)]);
     Q_ASSERT(_n._nodeIdsInUse[static_cast<int>(targetId)]);
 
+    JournalScope journalScope(this);
     beginTransaction();
 
     // The requested ID is not available or is out of range, so resize and append
@@ -399,6 +499,17 @@ EdgeId MutableGraph::addEdge(EdgeId edgeId, NodeId sourceId, NodeId targetId)
 
     _e._connections[undirectedEdge].add(edgeId);
 
+    if(auto* journal = journalScope.journal())
+    {
+        journal->add(Journal::Operation::AddEdge, edgeId, sourceId, targetId);
+
+        if(journal->_invertible)
+        {
+            journal->beginInverse();
+            journal->addInverse(Journal::Operation::RemoveEdge, edgeId);
+        }
+    }
+
     emit edgeAdded(this, edgeId);
     _updateRequired = true;
     endTransaction();
@@ -411,10 +522,70 @@ EdgeId MutableGraph::addEdge(const IEdge& edge)
     return addEdge(edge.id(), edge.sourceId(), edge.targetId());
 }
 
+EdgeId MutableGraph::addEdgesInBulk(const std::vector<std::pair<NodeId, NodeId>>& edges)
+{
+    if(edges.empty())
+        return {};
+
+    JournalScope journalScope(this);
+    beginTransaction();
+
+    // Storage is grown once for the whole batch, rather than per edge
+    auto firstEdgeId = nextEdgeId();
+    Graph::reserveEdgeId(firstEdgeId + (static_cast<int>(edges.size()) - 1));
+    _e.resize(static_cast<int>(nextEdgeId()));
+
+    auto edgeId = firstEdgeId;
+    for(const auto& [sourceId, targetId] : edges)
+    {
+        Q_ASSERT(_n._nodeIdsInUse[static_cast<int>(sourceId)]);
+        Q_ASSERT(_n._nodeIdsInUse[static_cast<int>(targetId)]);
+
+        claimEdgeId(edgeId);
+        auto& edge = edgeBy(edgeId);
+        edge._id = edgeId;
+        edge._sourceId = sourceId;
+        edge._targetId = targetId;
+
+        nodeBy(sourceId)._outEdgeIds.add(edgeId);
+        nodeBy(targetId)._inEdgeIds.add(edgeId);
+
+        auto connection = _e._connections.try_emplace(
+            UndirectedEdge(sourceId, targetId), &_e._mergedEdgeIds).first;
+        connection->second.add(edgeId);
+
+        if(auto* journal = journalScope.journal())
+        {
+            journal->add(Journal::Operation::AddEdge, edgeId, sourceId, targetId);
+
+            if(journal->_invertible)
+            {
+                journal->beginInverse();
+                journal->addInverse(Journal::Operation::RemoveEdge, edgeId);
+            }
+        }
+
+        emit edgeAdded(this, edgeId);
+        ++edgeId;
+    }
+
+    _updateRequired = true;
+    endTransaction();
+
+    return firstEdgeId;
+}
+
 void MutableGraph::removeEdge(EdgeId edgeId)
 {
     Q_ASSERT(containsEdgeId(edgeId));
 
+    JournalScope journalScope(this);
+    if(auto* journal = journalScope.journal())
+    {
+        journalInverseRemoveEdge(*journal, edgeId);
+        journal->add(Journal::Operation::RemoveEdge, edgeId);
+    }
+
     beginTransaction();
 
     // Remove all node references to this edge
@@ -470,6 +641,13 @@ void MutableGraph::contractEdge(EdgeId edgeId)
     if(!containsEdgeId(edgeId))
         return;
 
+    JournalScope journalScope(this);
+    if(auto* journal = journalScope.journal())
+    {
+        journalInverseSnapshot(*journal);
+        journal->add(Journal::Operation::ContractEdge, edgeId);
+    }
+
     beginTransaction();
 
     const auto& edge = edgeById(edgeId);
@@ -490,6 +668,15 @@ void MutableGraph::contractEdges(const EdgeIdSet& edgeIds)
     if(edgeIds.empty())
         return;
 
+    JournalScope journalScope(this);
+    if(auto* journal = journalScope.journal())
+    {
+        journalInverseSnapshot(*journal);
+        journal->add(Journal::Operation::ContractEdges, edgeIds.size());
+        for(auto edgeId : edgeIds)
+            journal->_data.push_back(static_cast<int>(edgeId));
+    }
+
     beginTransaction();
 
     // Divide into components, but ignore any edges that aren't being contracted,
@@ -526,6 +713,14 @@ void MutableGraph::contractEdges(const EdgeIdSet& edgeIds)
 
 MutableGraph& MutableGraph::clone(const MutableGraph& other)
 {
+    JournalScope journalScope(this);
+    if(auto* journal = journalScope.journal())
+    {
+        journalInverseSnapshot(*journal);
+        journal->add(Journal::Operation::Assign, journal->_assignedGraphs.size());
+        journal->_assignedGraphs.emplace_back(std::make_shared<const MutableGraph>(other));
+    }
+
     beginTransaction();
 
     // Store the differences between the graphs
@@ -620,6 +815,206 @@ MutableGraph::Diff MutableGraph::diffTo(const MutableGraph& other)
     return diff;
 }
 
+void MutableGraph::beginJournal(bool invertible)
+{
+    _journal = std::make_unique<Journal>();
+    _journal->_invertible = invertible;
+    _journal->_fromRevision = _revision;
+}
+
+MutableGraph::Journal MutableGraph::endJournal()
+{
+    if(_journal == nullptr)
+        return {};
+
+    auto journal = std::move(*_journal);
+    _journal.reset();
+
+    journal._toRevision = _revision;
+
+    return journal;
+}
+
+MutableGraph::Journal MutableGraph::Journal::inverse() const
+{
+    Q_ASSERT(_invertible);
+
+    Journal inverse;
+    inverse._assignedGraphs = _assignedGraphs;
+    inverse._fromRevision = _toRevision;
+    inverse._toRevision = _fromRevision;
+
+    // Revert the changes in the opposite order to which they were made
+    auto end = _inverseData.size();
+    for(auto it = _inverseOffsets.rbegin(); it != _inverseOffsets.rend(); ++it)
+    {
+        inverse._data.insert(inverse._data.end(),
+            _inverseData.begin() + static_cast<std::ptrdiff_t>(*it),
+            _inverseData.begin() + static_cast<std::ptrdiff_t>(end));
+        end = *it;
+    }
+
+    return inverse;
+}
+
+void MutableGraph::journalInverseSnapshot(Journal& journal) const
+{
+    if(!journal._invertible)
+        return;
+
+    journal.beginInverse();
+    journal.addInverse(Journal::Operation::Assign, journal._assignedGraphs.size());
+    journal._assignedGraphs.emplace_back(std::make_shared<const MutableGraph>(*this));
+}
+
+void MutableGraph::journalInverseRemoveEdge(Journal& journal, EdgeId edgeId) const
+{
+    if(!journal._invertible)
+        return;
+
+    // Merges can't be expressed as individual operations
+    if(typeOf(edgeId) != MultiElementType::Not)
+    {
+        journalInverseSnapshot(journal);
+        return;
+    }
+
+    const auto& edge = edgeBy(edgeId);
+
+    journal.beginInverse();
+    journal.addInverse(Journal::Operation::AddEdge, edgeId, edge.sourceId(), edge.targetId());
+}
+
+void MutableGraph::journalInverseRemoveNode(Journal& journal, NodeId nodeId) const
+{
+    if(!journal._invertible)
+        return;
+
+    auto edgeIds = edgeIdsForNodeId(nodeId).copy();
+
+    // Loops are both in and out edges
+    std::sort(edgeIds.begin(), edgeIds.end());
+    edgeIds.erase(std::unique(edgeIds.begin(), edgeIds.end()), edgeIds.end());
+
+    bool merged = typeOf(nodeId) != MultiElementType::Not ||
+        std::any_of(edgeIds.begin(), edgeIds.end(),
+        [this](auto edgeId) { return typeOf(edgeId) != MultiElementType::Not; });
+
+    if(merged)
+    {
+        journalInverseSnapshot(journal);
+        return;
+    }
+
+    // The edges are removed implicitly, so must be restored explicitly
+    journal.beginInverse();
+    journal.addInverse(Journal::Operation::AddNode, nodeId);
+
+    for(auto edgeId : edgeIds)
+    {
+        const auto& edge = edgeBy(edgeId);
+        journal.addInverse(Journal::Operation::AddEdge, edgeId, edge.sourceId(), edge.targetId());
+    }
+}
+
+uint64_t MutableGraph::newRevision()
+{
+    static std::atomic<uint64_t> nextRevision(1);
+    return nextRevision++;
+}
+
+void MutableGraph::replay(const Journal& journal)
+{
+    if(journal.empty())
+        return;
+
+    // Only a replay that isn't part of some larger change can restore a revision
+    bool restoresRevision = _graphChangeDepth == 0 &&
+        journal._fromRevision == _revision && journal._toRevision != 0;
+
+    beginTransaction();
+
+    auto it = journal._data.begin();
+    auto next = [&it] { return *it++; };
+
+    while(it != journal._data.end())
+    {
+        switch(static_cast<Journal::Operation>(next()))
+        {
+        case Journal::Operation::ReserveNodeId:
+            reserveNodeId(next());
+            break;
+
+        case Journal::Operation::AddNode:
+        {
+            NodeId nodeId = next();
+
+            // Mirror addNode() claiming the first unused ID
+            if(!_unusedNodeIds.empty() && _unusedNodeIds.front() == nodeId)
+                _unusedNodeIds.pop_front();
+
+            reserveNodeId(nodeId);
+            addNode(nodeId);
+            break;
+        }
+
+        case Journal::Operation::RemoveNode:
+            removeNode(next());
+            break;
+
+        case Journal::Operation::ReserveEdgeId:
+            reserveEdgeId(next());
+            break;
+
+        case Journal::Operation::AddEdge:
+        {
+            EdgeId edgeId = next();
+            NodeId sourceId = next();
+            NodeId targetId = next();
+
+            if(!_unusedEdgeIds.empty() && _unusedEdgeIds.front() == edgeId)
+                _unusedEdgeIds.pop_front();
+
+            reserveEdgeId(edgeId);
+            addEdge(edgeId, sourceId, targetId);
+            break;
+        }
+
+        case Journal::Operation::RemoveEdge:
+            removeEdge(next());
+            break;
+
+        case Journal::Operation::ContractEdge:
+            contractEdge(next());
+            break;
+
+        case Journal::Operation::ContractEdges:
+        {
+            EdgeIdSet edgeIds;
+            auto numEdgeIds = next();
+            for(int i = 0; i < numEdgeIds; i++)
+                edgeIds.insert(next());
+
+            contractEdges(edgeIds);
+            break;
+        }
+
+        case Journal::Operation::Clear:
+            clear();
+            break;
+
+        case Journal::Operation::Assign:
+            clone(*journal._assignedGraphs.at(static_cast<size_t>(next())));
+            break;
+        }
+    }
+
+    if(restoresRevision)
+        _replayedRevision = journal._toRevision;
+
+    endTransaction();
+}
+
 void MutableGraph::beginTransaction()
 {
     if(_graphChangeDepth++ <= 0)
@@ -638,6 +1033,12 @@ void MutableGraph::endTransaction(bool graphChangeOccurred)
     if(--_graphChangeDepth <= 0)
     {
         update();
+
+        if(_graphChangeOccurred)
+            _revision = _replayedRevision != 0 ? _replayedRevision : newRevision();
+
+        _replayedRevision = 0;
+
         emit graphChanged(this, _graphChangeOccurred);
         _mutex.unlock();
         clearPhase();
@@ -23,6 +23,8 @@
 #include "shared/graph/imutablegraph.h"
 
 #include <deque>
+#include <memory>
+#include <cstdint>
 #include <mutex>
 #include <vector>
 #include <map>
@@ -162,6 +164,7 @@ public:
     NodeId addNode() override;
     NodeId addNode(NodeId nodeId) override;
     NodeId addNode(const INode& node) override;
+    NodeId addNodesInBulk(int numNodes) override;
     void removeNode(NodeId nodeId) override;
 
     const std::vector<EdgeId>& edgeIds() const override;
@@ -200,6 +203,7 @@ public:
     EdgeId addEdge(NodeId sourceId, NodeId targetId) override;
     EdgeId addEdge(EdgeId edgeId, NodeId sourceId, NodeId targetId) override;
     EdgeId addEdge(const IEdge& edge) override;
+    EdgeId addEdgesInBulk(const std::vector<std::pair<NodeId, NodeId>>& edges) override;
     void removeEdge(EdgeId edgeId) override;
 
     void contractEdge(EdgeId edgeId) override;
@@ -226,9 +230,92 @@ public:
 
     Diff diffTo(const MutableGraph& other);
 
+    // A compact record of the structural changes made to a graph, that reproduces
+    // them when replayed on a graph in the state the recorded graph started in
+    class Journal
+    {
+        friend class MutableGraph;
+
+    private:
+        enum class Operation
+        {
+            ReserveNodeId,
+            AddNode,
+            RemoveNode,
+            ReserveEdgeId,
+            AddEdge,
+            RemoveEdge,
+            ContractEdge,
+            ContractEdges,
+            Clear,
+            Assign
+        };
+
+        // Each operation followed by its arguments
+        std::vector<int> _data;
+
+        // Wholesale assignments can't be expressed any more compactly than a copy
+        std::vector<std::shared_ptr<const MutableGraph>> _assignedGraphs;
+
+        // When invertible, the operations that revert each change, in the order the
+        // changes were made; _inverseOffsets marks where each change's operations begin
+        bool _invertible = false;
+        std::vector<int> _inverseData;
+        std::vector<size_t> _inverseOffsets;
+
+        // The revisions of the graph before and after the recorded changes
+        uint64_t _fromRevision = 0;
+        uint64_t _toRevision = 0;
+
+        void add(Operation operation) { _data.push_back(static_cast<int>(operation)); }
+        template<typename... Args> void add(Operation operation, Args... args)
+        {
+            add(operation);
+            (_data.push_back(static_cast<int>(args)), ...);
+        }
+
+        void beginInverse() { _inverseOffsets.push_back(_inverseData.size()); }
+        template<typename... Args> void addInverse(Operation operation, Args... args)
+        {
+            _inverseData.push_back(static_cast<int>(operation));
+            (_inverseData.push_back(static_cast<int>(args)), ...);
+        }
+
+    public:
+        bool empty() const { return _data.empty(); }
+        bool invertible() const { return _invertible; }
+
+        // A journal that, replayed on the graph this one leaves behind, undoes its changes
+        Journal inverse() const;
+    };
+
+    // If invertible is set, the journal also records what is needed to undo the
+    // changes; this costs little beyond the removed edges for most operations,
+    // but those that merge elements or replace the graph wholesale take a copy
+    void beginJournal(bool invertible = false);
+    Journal endJournal();
+    void replay(const Journal& journal);
+
+    // Identifies the current state of the graph; replaying a journal (or its
+    // inverse) on the state it was recorded from restores the recorded revision
+    uint64_t revision() const { return _revision; }
+
     bool update() override;
 
 private:
+    class JournalScope;
+
+    std::unique_ptr<Journal> _journal;
+    int _journalDepth = 0;
+
+    static uint64_t newRevision();
+    uint64_t _revision = newRevision();
+    uint64_t _replayedRevision = 0;
+
+    void journalInverseSnapshot(Journal& journal) const;
+    void journalInverseRemoveEdge(Journal& journal, EdgeId edgeId) const;
+    void journalInverseRemoveNode(Journal& journal, NodeId nodeId) const;
+
     int _graphChangeDepth = 0;
     bool _graphChangeOccurred = false;
     std::mutex _mutex;
@@ -102,6 +102,12 @@ public:
         this->setMaxNodesPerLeaf(1);
     }
 
+    void build(const IGraphComponent& graph, const NodeLayoutPositions& nodePositions) override
+    {
+        SpatialTree<BarnesHutTree<NumDimensions>, NumDimensions,
+            BarnesHutSubVolume<NumDimensions>>::build(graph, nodePositions);
+    }
+
     void setTheta(float theta) { _theta = theta; }
 
     QVector3D evaluateKernel(const NodeLayoutPositions& nodePositions, NodeId nodeId,
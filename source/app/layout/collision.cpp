@@ -17,14 +17,19 @@
  */
 
 #include "collision.h"
+#include "nodebvh.h"
 
 #include "graph/graph.h"
 #include "graph/graphmodel.h"
 #include "ui/visualisations/elementvisual.h"
 
+#include "limitconstants.h"
+
 #include "maths/ray.h"
 #include "maths/plane.h"
 
+#include <limits>
+
 NodeId Collision::nodeClosestToLine(const std::vector<NodeId>& nodeIds, const QVector3D &point, const QVector3D &direction)
 {
     Plane plane(point, direction);
@@ -55,7 +60,38 @@ NodeId Collision::nodeClosestToLine(const std::vector<NodeId>& nodeIds, const QV
 
 NodeId Collision::nodeClosestToLine(const QVector3D &point, const QVector3D &direction)
 {
-    return nodeClosestToLine(_graphModel->graph().componentById(_componentId)->nodeIds(), point, direction);
+    auto bvh = _graphModel->nodeBVH(_componentId);
+    if(bvh == nullptr)
+        return nodeClosestToLine(_graphModel->graph().componentById(_componentId)->nodeIds(), point, direction);
+
+    Plane plane(point, direction);
+    NodeId closestNodeId;
+    float minimumDistance = std::numeric_limits<float>::max();
+
+    // The index is in the space of the node positions, so move the line into it instead
+    bvh->forEachNodeClosestToLine(point - _offset, direction, minimumDistance,
+    [&](NodeId nodeId, const QVector3D& nodePosition)
+    {
+        if(!_includeNotFound && _graphModel->nodeVisual(nodeId).state().test(VisualFlags::Unhighlighted))
+            return minimumDistance;
+
+        const QVector3D position = nodePosition + _offset;
+
+        if(plane.sideForPoint(position) != Plane::Side::Front)
+            return minimumDistance;
+
+        float distance = position.distanceToLine(point, direction);
+
+        if(distance < minimumDistance)
+        {
+            minimumDistance = distance;
+            closestNodeId = nodeId;
+        }
+
+        return minimumDistance;
+    });
+
+    return closestNodeId;
 }
 
 void Collision::nodesIntersectingLine(const QVector3D& point, const QVector3D& direction, std::vector<NodeId>& intersectingNodeIds)
@@ -67,24 +103,36 @@ void Collision::nodesInsideCylinder(const QVector3D &point, const QVector3D &dir
 {
     Plane plane(point, direction);
 
-    Q_ASSERT(!_componentId.isNull());
-    const auto* component = _graphModel->graph().componentById(_componentId);
-    const auto& nodeIds = component->nodeIds();
-    for(NodeId nodeId : nodeIds)
+    auto testNode = [&](NodeId nodeId, const QVector3D& nodePosition)
     {
         if(!_includeNotFound && _graphModel->nodeVisual(nodeId).state().test(VisualFlags::Unhighlighted))
-            continue;
+            return;
 
-        const QVector3D position = _graphModel->nodePositions().get(nodeId) + _offset;
+        const QVector3D position = nodePosition + _offset;
 
         if(plane.sideForPoint(position) != Plane::Side::Front)
-            continue;
+            return;
 
         float distance = position.distanceToLine(point, direction);
 
         if(distance <= radius + _graphModel->nodeVisual(nodeId)._size)
             containedNodeIds.push_back(nodeId);
+    };
+
+    Q_ASSERT(!_componentId.isNull());
+
+    auto bvh = _graphModel->nodeBVH(_componentId);
+    if(bvh != nullptr)
+    {
+        // Allow for the largest possible node, as the index only knows the nodes' centres
+        bvh->forEachNodeNearLine(point - _offset, direction,
+            radius + LimitConstants::maximumNodeSize(), testNode);
+        return;
     }
+
+    const auto* component = _graphModel->graph().componentById(_componentId);
+    for(NodeId nodeId : component->nodeIds())
+        testNode(nodeId, _graphModel->nodePositions().get(nodeId));
 }
 
 NodeId Collision::nearestNodeIntersectingLine(const QVector3D& point, const QVector3D& direction)
@@ -27,6 +27,11 @@
 #include "shared/utils/preferences.h"
 #include "shared/utils/scopetimer.h"
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <limits>
+#include <numeric>
 #include <cmath>
 
 template<typename T> float meanWeightedAvgBuffer(int start, int end, const T& buffer)
@@ -102,19 +107,30 @@ static float repulse(const float distanceSq, const float shortRange, const float
         ((distanceSq * distanceSq * distanceSq) + 0.0001f);
 }
 
-void ForceDirectedLayout::execute(bool firstIteration, Dimensionality dimensionality)
+static std::pair<NodeId, NodeId> endsOf(const IGraphComponent& graphComponent, EdgeId edgeId)
 {
-    SCOPE_TIMER_MULTISAMPLES(50)
+    const IEdge& edge = graphComponent.graph().edgeById(edgeId);
+    return {edge.sourceId(), edge.targetId()};
+}
 
-    if(firstIteration)
-    {
-        FastInitialLayout initialLayout(graphComponent(), positions());
-        initialLayout.execute(firstIteration, dimensionality);
+static std::pair<NodeId, NodeId> endsOf(const IGraphComponent&, const std::pair<NodeId, NodeId>& edge)
+{
+    return edge;
+}
 
-        for(NodeId nodeId : nodeIds())
-            _displacements->at(nodeId)._previous = {};
-    }
+void ForceDirectedLayout::executeInitialLayout(Dimensionality dimensionality)
+{
+    FastInitialLayout initialLayout(graphComponent(), positions());
+    initialLayout.execute(true, dimensionality);
 
+    for(NodeId nodeId : nodeIds())
+        _displacements->at(nodeId)._previous = {};
+}
+
+template<typename Edges>
+bool ForceDirectedLayout::applyForces(const std::vector<NodeId>& nodeIds, const Edges& edges,
+    Dimensionality dimensionality)
+{
     std::unique_ptr<AbstractBarnesHutTree> barnesHutTree;
 
     if(dimensionality == Dimensionality::ThreeDee)
@@ -148,13 +164,13 @@ void ForceDirectedLayout::execute(bool firstIteration, Dimensionality dimensiona
         barnesHutTree = std::make_unique<BarnesHutTree2D>();
     }
 
-    barnesHutTree->build(graphComponent(), positions());
+    barnesHutTree->build(nodeIds, positions(), positions().boundingBox(nodeIds));
 
     const float SHORT_RANGE = _settings->value(QStringLiteral("ShortRangeRepulseTerm"));
     const float LONG_RANGE = 0.01f + _settings->value(QStringLiteral("LongRangeRepulseTerm"));
 
     // Repulsive forces
-    auto repulsiveResults = concurrent_for(nodeIds().begin(), nodeIds().end(),
+    auto repulsiveResults = concurrent_for(nodeIds.begin(), nodeIds.end(),
     [this, &barnesHutTree, SHORT_RANGE, LONG_RANGE](NodeId nodeId)
     {
         if(cancelled())
@@ -168,40 +184,180 @@ void ForceDirectedLayout::execute(bool firstIteration, Dimensionality dimensiona
     }, ThreadPool::NonBlocking);
 
     // Attractive forces
-    auto attractiveResults = concurrent_for(edgeIds().begin(), edgeIds().end(),
-    [this](EdgeId edgeId)
+    if(!edges.empty())
     {
-        if(cancelled())
-            return;
+        if(nodeIds != _incidentNodeIds || edges.size() != _incidentEdgeEnds.size())
+        {
+            _incidentNodeIds = nodeIds;
+            _incidentEdgeEnds.resize(edges.size());
+            std::transform(edges.begin(), edges.end(), _incidentEdgeEnds.begin(),
+                [this](const auto& edge) { return endsOf(graphComponent(), edge); });
+
+            buildIncidentEdges();
+        }
+
+        // Each node's attractive force is a sum over its edges; scattering these from the
+        // edges in parallel would race, and make the result depend on the order of the
+        // additions, so compute the edges' forces in parallel, then gather them per node
+        _attractiveForces.resize(edges.size());
+        std::atomic<bool> edgeEndsChanged(false);
 
-        const IEdge& edge = graphComponent().graph().edgeById(edgeId);
-        if(!edge.isLoop())
+        concurrent_for(edges.begin(), edges.end(),
+        [this, &edges, &edgeEndsChanged](typename Edges::const_iterator edge)
         {
-            const QVector3D difference = positions().get(edge.targetId()) - positions().get(edge.sourceId());
+            if(cancelled())
+                return;
+
+            auto ends = endsOf(graphComponent(), *edge);
+            auto index = static_cast<size_t>(std::distance(edges.begin(), edge));
+
+            // The ids may be the same, but (re)used by different edges
+            if(ends != _incidentEdgeEnds[index])
+            {
+                _incidentEdgeEnds[index] = ends;
+                edgeEndsChanged = true;
+            }
+
+            auto [sourceId, targetId] = ends;
+
+            if(sourceId == targetId)
+            {
+                _attractiveForces[index] = {};
+                return;
+            }
+
+            const QVector3D difference = positions().get(targetId) - positions().get(sourceId);
             float distanceSq = difference.lengthSquared();
             const float force = distanceSq * 0.001f;
 
-            _displacements->at(edge.targetId())._attractive -= (force * difference);
-            _displacements->at(edge.sourceId())._attractive += (force * difference);
+            _attractiveForces[index] = force * difference;
+        });
+
+        if(edgeEndsChanged)
+            buildIncidentEdges();
+
+        if(!cancelled())
+        {
+            concurrent_for(nodeIds.begin(), nodeIds.end(),
+            [this, &nodeIds](std::vector<NodeId>::const_iterator nodeId)
+            {
+                auto i = static_cast<size_t>(std::distance(nodeIds.begin(), nodeId));
+                auto& attractive = _displacements->at(*nodeId)._attractive;
+
+                for(auto j = _incidentEdgeOffsets[i]; j < _incidentEdgeOffsets[i + 1]; j++)
+                {
+                    const auto& incidentEdge = _incidentEdges[j];
+                    attractive += incidentEdge._sign * _attractiveForces[incidentEdge._index];
+                }
+            });
         }
-    }, ThreadPool::NonBlocking);
+    }
 
     repulsiveResults.wait();
-    attractiveResults.wait();
 
     if(cancelled())
-        return;
+    {
+        // Discard any partially accumulated forces, otherwise they
+        // would be carried over into the next iteration
+        for(auto nodeId : nodeIds)
+        {
+            auto& displacement = _displacements->at(nodeId);
+            displacement._repulsive = {};
+            displacement._attractive = {};
+        }
+
+        return false;
+    }
 
-    concurrent_for(nodeIds().begin(), nodeIds().end(),
+    concurrent_for(nodeIds.begin(), nodeIds.end(),
     [this](NodeId nodeId)
     {
         _displacements->at(nodeId).computeAndDamp();
     });
 
     // Apply the forces
-    for(auto nodeId : nodeIds())
+    for(auto nodeId : nodeIds)
         positions().set(nodeId, positions().get(nodeId) + _displacements->at(nodeId)._next);
 
+    return true;
+}
+
+void ForceDirectedLayout::buildIncidentEdges()
+{
+    NodeIdMap<size_t> nodeIndices;
+    for(size_t i = 0; i < _incidentNodeIds.size(); i++)
+        nodeIndices[_incidentNodeIds[i]] = i;
+
+    auto indexOf = [&nodeIndices](NodeId nodeId)
+    {
+        auto it = nodeIndices.find(nodeId);
+        return it != nodeIndices.end() ? it->second : std::numeric_limits<size_t>::max();
+    };
+
+    _incidentEdgeOffsets.assign(_incidentNodeIds.size() + 1, 0);
+
+    for(const auto& [sourceId, targetId] : _incidentEdgeEnds)
+    {
+        if(sourceId == targetId)
+            continue;
+
+        for(auto nodeIndex : {indexOf(sourceId), indexOf(targetId)})
+        {
+            if(nodeIndex < _incidentNodeIds.size())
+                _incidentEdgeOffsets[nodeIndex + 1]++;
+        }
+    }
+
+    std::partial_sum(_incidentEdgeOffsets.begin(), _incidentEdgeOffsets.end(),
+        _incidentEdgeOffsets.begin());
+
+    // Filling in edge order preserves the order in which each node's forces are summed
+    auto next = _incidentEdgeOffsets;
+    _incidentEdges.resize(_incidentEdgeOffsets.back());
+
+    for(size_t i = 0; i < _incidentEdgeEnds.size(); i++)
+    {
+        auto [sourceId, targetId] = _incidentEdgeEnds[i];
+        if(sourceId == targetId)
+            continue;
+
+        auto sourceIndex = indexOf(sourceId);
+        if(sourceIndex < _incidentNodeIds.size())
+            _incidentEdges[next[sourceIndex]++] = {i, 1.0f};
+
+        auto targetIndex = indexOf(targetId);
+        if(targetIndex < _incidentNodeIds.size())
+            _incidentEdges[next[targetIndex]++] = {i, -1.0f};
+    }
+}
+
+bool ForceDirectedLayout::iterate(const std::vector<NodeId>& nodeIds,
+    const std::vector<EdgeId>& edgeIds, Dimensionality dimensionality)
+{
+    return applyForces(nodeIds, edgeIds, dimensionality);
+}
+
+bool ForceDirectedLayout::iterate(const std::vector<NodeId>& nodeIds,
+    const NodeIdPairs& edges, Dimensionality dimensionality)
+{
+    return applyForces(nodeIds, edges, dimensionality);
+}
+
+void ForceDirectedLayout::execute(bool firstIteration, Dimensionality dimensionality)
+{
+    SCOPE_TIMER_MULTISAMPLES(50)
+
+    if(firstIteration)
+        executeInitialLayout(dimensionality);
+
+    if(!iterate(nodeIds(), edgeIds(), dimensionality))
+        return;
+
+    updateChangeDetection(nodeIds());
+}
+
+void ForceDirectedLayout::updateChangeDetection(const std::vector<NodeId>& nodeIds)
+{
     // There are three main phases which decide when to stop the layout.
     // The phases operate primarily on the stddev of the forces within the graph
     //
@@ -219,20 +375,20 @@ void ForceDirectedLayout::execute(bool firstIteration, Dimensionality dimensiona
 
     // Calculate force averages
     float deltaForceTotal = 0.0f;
-    for(auto nodeId : nodeIds())
+    for(auto nodeId : nodeIds)
         deltaForceTotal += _displacements->at(nodeId)._nextLength;
 
-    _forceMean = deltaForceTotal / nodeIds().size();
+    _forceMean = deltaForceTotal / nodeIds.size();
 
     // Calculate Standard Deviation
     float variance = 0.0f;
-    for(auto nodeId : nodeIds())
+    for(auto nodeId : nodeIds)
     {
         float d = _displacements->at(nodeId)._nextLength - _forceMean;
         variance += (d * d);
     }
 
-    _forceStdDeviation = std::sqrt(variance / nodeIds().size());
+    _forceStdDeviation = std::sqrt(variance / nodeIds.size());
     switch(_changeDetectionPhase)
     {
         case ChangeDetectionPhase::Initial:
@@ -294,12 +450,45 @@ void ForceDirectedLayout::finishChangeDetection()
     _prevAvgForces.clear();
 }
 
+// Return to the Initial phase, forgetting any history
+void ForceDirectedLayout::resetChangeDetection()
+{
+    finishChangeDetection();
+    _changeDetectionPhase = ChangeDetectionPhase::Initial;
+    _prevUnstableStdDev = 0.0f;
+}
+
 void ForceDirectedLayout::unfinish()
 {
     if(_changeDetectionPhase == ChangeDetectionPhase::Finished)
         _changeDetectionPhase = ChangeDetectionPhase::Initial;
 }
 
+float ForceDirectedLayout::convergence() const
+{
+    const float FINETUNE_CONVERGENCE = 0.9f;
+
+    switch(_changeDetectionPhase)
+    {
+        case ChangeDetectionPhase::Finished:
+            return 1.0f;
+
+        case ChangeDetectionPhase::FineTune:
+            return FINETUNE_CONVERGENCE;
+
+        default:
+            break;
+    }
+
+    if(_forceStdDeviation <= 0.0f)
+        return 0.0f;
+
+    // FineTune is reached when the std dev falls to MINIMUM_STDDEV_THRESHOLD; measure
+    // progress towards it on a log scale, from 4 orders of magnitude above
+    auto orders = std::log10(_forceStdDeviation / MINIMUM_STDDEV_THRESHOLD);
+    return FINETUNE_CONVERGENCE * std::clamp(1.0f - (orders / 4.0f), 0.0f, 1.0f);
+}
+
 // Allows the layout algorithm to further calculate small layout changes until the change amount
 // falls below FINETUNE_STDDEV_DELTA, where it moves the phase to Finished
 void ForceDirectedLayout::fineTuneChangeDetection()
@@ -26,6 +26,7 @@
 #include <QVector3D>
 
 #include <vector>
+#include <utility>
 
 struct ForceDirectedDisplacement
 {
@@ -76,11 +77,49 @@ private:
 
     bool _hasBeenFlattened = false;
 
+    // Per edge attractive forces, summed into _displacements in edge order
+    std::vector<QVector3D> _attractiveForces;
+
+    struct IncidentEdge
+    {
+        size_t _index;
+        float _sign;
+    };
+
+    // The edges incident to each node, in edge order, so that each node's attractive force
+    // can be gathered independently; rebuilt whenever the nodes or edges' ends change
+    std::vector<NodeId> _incidentNodeIds;
+    std::vector<std::pair<NodeId, NodeId>> _incidentEdgeEnds;
+    std::vector<size_t> _incidentEdgeOffsets;
+    std::vector<IncidentEdge> _incidentEdges;
+
+    void buildIncidentEdges();
+
     void fineTuneChangeDetection();
     void oscillateChangeDetection();
     void initialChangeDetection();
     void finishChangeDetection();
 
+    template<typename Edges>
+    bool applyForces(const std::vector<NodeId>& nodeIds, const Edges& edges, Dimensionality dimensionality);
+
+protected:
+    using NodeIdPairs = std::vector<std::pair<NodeId, NodeId>>;
+
+    ForceDirectedDisplacements& displacements() { return *_displacements; }
+
+    void executeInitialLayout(Dimensionality dimensionality);
+
+    // Apply a single step of the forces between nodeIds, attracting along the given edges;
+    // returns false if the layout was cancelled before the positions could be updated
+    bool iterate(const std::vector<NodeId>& nodeIds, const std::vector<EdgeId>& edgeIds,
+        Dimensionality dimensionality);
+    bool iterate(const std::vector<NodeId>& nodeIds, const NodeIdPairs& edges,
+        Dimensionality dimensionality);
+
+    void updateChangeDetection(const std::vector<NodeId>& nodeIds);
+    void resetChangeDetection();
+
 public:
     ForceDirectedLayout(const IGraphComponent& graphComponent,
                         ForceDirectedDisplacements& displacements,
@@ -95,13 +134,14 @@ public:
 
     bool finished() const override { return _changeDetectionPhase == ChangeDetectionPhase::Finished; }
     void unfinish() override;
+    float convergence() const override;
 
     void execute(bool firstIteration, Dimensionality dimensionality) override;
 };
 
 class ForceDirectedLayoutFactory : public LayoutFactory
 {
-private:
+protected:
     ForceDirectedDisplacements _displacements;
 
 public:
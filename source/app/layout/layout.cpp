@@ -26,8 +26,20 @@
 
 #include <QDebug>
 
+#include <algorithm>
+#include <cmath>
+#include <random>
+
 template<> constexpr bool EnableBitMaskOperators<Layout::Dimensionality> = true;
 
+uint32_t Layout::seed() const
+{
+    if(deterministic())
+        return _settings->seed();
+
+    return std::random_device()();
+}
+
 static bool layoutIsFinished(const Layout& layout)
 {
     return layout.finished() || layout.graphComponent().numNodes() == 1;
@@ -40,6 +52,9 @@ LayoutThread::LayoutThread(GraphModel& graphModel,
     _repeating(repeating),
     _layoutFactory(std::move(layoutFactory)),
     _executedAtLeastOnce(graphModel.graph()),
+    _convergences(graphModel.graph()),
+    _convergenceRates(graphModel.graph()),
+    _smallComponentThreadPool(QStringLiteral("LayoutWorker")),
     _nodeLayoutPositions(graphModel.graph()),
     _performanceCounter(std::chrono::seconds(1))
 {
@@ -50,7 +65,8 @@ LayoutThread::LayoutThread(GraphModel& graphModel,
         {
             auto activeLayouts = std::count_if(_layouts.begin(), _layouts.end(),
                                                [](auto& layout) { return !layoutIsFinished(*layout.second); });
-            qDebug() << activeLayouts << "layouts\t" << ticksPerSecond << "ips";
+            qDebug() << activeLayouts << "layouts\t" << ticksPerSecond << "ips\t" <<
+                convergence() << "converged";
         }
     });
 
@@ -200,38 +216,98 @@ void LayoutThread::run()
     {
         u::setCurrentThreadName(QStringLiteral("Layout >"));
 
+        // If we're in 2D mode and the layouts can handle it, flatten the positions
+        if(_dimensionalityMode == Layout::Dimensionality::TwoDee &&
+            std::any_of(_layouts.begin(), _layouts.end(),
+            [this](const auto& layout)
+            {
+                return !layoutIsFinished(*layout.second) &&
+                    (layout.second->dimensionality() & _dimensionalityMode);
+            }))
+        {
+            _nodeLayoutPositions.flatten();
+        }
+
+        struct ScheduledLayout
+        {
+            ComponentId _componentId;
+            Layout* _layout = nullptr;
+            bool _firstIteration = false;
+            int _iterations = 1;
+
+            uint64_t computeCostHint() const
+            {
+                return static_cast<uint64_t>(_layout->graphComponent().numNodes()) *
+                    static_cast<uint64_t>(_iterations);
+            }
+        };
+
+        std::vector<ScheduledLayout> smallLayouts;
+        std::vector<ScheduledLayout> largeLayouts;
+
         for(auto& [componentId, layout] : _layouts)
         {
             if(layoutIsFinished(*layout))
                 continue;
 
-            if(_dimensionalityMode == Layout::Dimensionality::TwoDee &&
-               (layout->dimensionality() & _dimensionalityMode))
+            auto numNodes = layout->graphComponent().numNodes();
+            ScheduledLayout scheduledLayout{componentId, layout.get(),
+                !_executedAtLeastOnce.get(componentId), 1};
+
+            if(numNodes <= SMALL_COMPONENT_MAXIMUM_NODES)
             {
-                // If we're in 2D mode and the layout can handle it, flatten the positions
-                _nodeLayoutPositions.flatten();
+                scheduledLayout._iterations = iterationBudget(componentId, numNodes);
+                smallLayouts.push_back(scheduledLayout);
             }
+            else
+                largeLayouts.push_back(scheduledLayout);
+        }
 
-            layout->execute(!_executedAtLeastOnce.get(componentId), _dimensionalityMode);
-            _executedAtLeastOnce.set(componentId, true);
+        auto executeLargeLayouts = [this, &largeLayouts]
+        {
+            for(const auto& scheduledLayout : largeLayouts)
+            {
+                executeLayout(scheduledLayout._componentId, *scheduledLayout._layout,
+                    scheduledLayout._firstIteration, scheduledLayout._iterations);
+            }
+        };
+
+        if(!smallLayouts.empty())
+        {
+            // Small components make poor use of the thread pool individually, so instead they
+            // are iterated several times each, in parallel batches balanced by their cost,
+            // whilst the large components are iterated as normal
+            auto smallLayoutResults = _smallComponentThreadPool.concurrent_for(
+                smallLayouts.begin(), smallLayouts.end(),
+            [this](const ScheduledLayout& scheduledLayout)
+            {
+                executeLayout(scheduledLayout._componentId, *scheduledLayout._layout,
+                    scheduledLayout._firstIteration, scheduledLayout._iterations);
+            }, ThreadPool::NonBlocking);
+
+            executeLargeLayouts();
+            smallLayoutResults.wait();
         }
+        else
+            executeLargeLayouts();
 
+        for(const auto& scheduledLayouts : {&smallLayouts, &largeLayouts})
         {
-            std::unique_lock<NodePositions> lock(_graphModel->nodePositions());
-            _graphModel->nodePositions().update(_nodeLayoutPositions);
-
-            bool requiresFlattening = _dimensionalityMode == Layout::Dimensionality::TwoDee &&
-                std::any_of(_layouts.begin(), _layouts.end(),
-                [](const auto& layout)
-                {
-                    return layout.second->dimensionality() ==
-                        Layout::Dimensionality::ThreeDee;
-                });
-
-            if(requiresFlattening)
-                _graphModel->nodePositions().flatten();
+            for(const auto& scheduledLayout : *scheduledLayouts)
+                _executedAtLeastOnce.set(scheduledLayout._componentId, true);
         }
 
+        bool requiresFlattening = _dimensionalityMode == Layout::Dimensionality::TwoDee &&
+            std::any_of(_layouts.begin(), _layouts.end(),
+            [](const auto& layout)
+            {
+                return layout.second->dimensionality() ==
+                    Layout::Dimensionality::ThreeDee;
+            });
+
+        // This doesn't block; the renderer picks up the positions on its next frame
+        _graphModel->nodePositions().publish(_nodeLayoutPositions, requiresFlattening);
+
         _performanceCounter.tick();
         emit executed();
 
@@ -279,6 +355,49 @@ void LayoutThread::run()
     if(_debug != 0) qDebug() << "Layout stopped";
 }
 
+int LayoutThread::iterationBudget(ComponentId componentId, int numNodes) const
+{
+    // Smaller components are given more iterations, so that each costs roughly the same
+    auto budget = std::clamp(SMALL_COMPONENT_STEP_COST / std::max(numNodes, 1),
+        1, MAXIMUM_ITERATIONS_PER_STEP);
+
+    // Don't allocate many more iterations than the component is likely to need to
+    // finish, otherwise its cost is overestimated and the batches are unbalanced
+    auto rate = _convergenceRates.get(componentId);
+    if(rate > 0.0f)
+    {
+        auto remaining = std::ceil((1.0f - _convergences.get(componentId)) / rate);
+        budget = std::min(budget, std::max(static_cast<int>(remaining), 1));
+    }
+
+    return budget;
+}
+
+void LayoutThread::executeLayout(ComponentId componentId, Layout& layout,
+    bool firstIteration, int iterations)
+{
+    int iteration = 0;
+
+    for(; iteration < iterations; iteration++)
+    {
+        if(layoutIsFinished(layout) || layout.cancelled())
+            break;
+
+        layout.execute(firstIteration && iteration == 0, _dimensionalityMode);
+    }
+
+    if(iteration == 0)
+        return;
+
+    auto previousConvergence = _convergences.get(componentId);
+    auto convergence = layoutIsFinished(layout) ? 1.0f : layout.convergence();
+    auto rate = (convergence - previousConvergence) / static_cast<float>(iteration);
+
+    // Smooth the rate, since convergence is rarely monotonic
+    _convergenceRates.set(componentId, (_convergenceRates.get(componentId) + rate) * 0.5f);
+    _convergences.set(componentId, convergence);
+}
+
 void LayoutThread::addComponent(ComponentId componentId)
 {
     if(!u::contains(_layouts, componentId))
@@ -301,6 +420,9 @@ void LayoutThread::addComponent(ComponentId componentId)
             emit settingChanged();
         });
 
+        _convergences.set(componentId, 0.0f);
+        _convergenceRates.set(componentId, 0.0f);
+
         _graphModel->nodePositions().setScale(layout->scaling());
         _graphModel->nodePositions().setSmoothing(layout->smoothing());
         _layouts.emplace(componentId, std::move(layout));
@@ -316,7 +438,7 @@ void LayoutThread::addAllComponents()
 void LayoutThread::setStartingNodePositions(const ExactNodePositions& nodePositions)
 {
     _nodeLayoutPositions.set(_graphModel->graph().nodeIds(), nodePositions);
-    _graphModel->nodePositions().update(_nodeLayoutPositions);
+    _graphModel->nodePositions().publish(_nodeLayoutPositions);
 
     // Stop the layouts throwing away our newly set positions
     _executedAtLeastOnce.fill(true);
@@ -348,6 +470,69 @@ QString LayoutThread::layoutDisplayName() const
     return _layoutFactory->displayName();
 }
 
+void LayoutThread::setLayoutFactory(std::unique_ptr<LayoutFactory>&& layoutFactory)
+{
+    bool resumeAfterChange = false;
+
+    if(!paused())
+    {
+        pauseAndWait();
+        resumeAfterChange = true;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _layouts.clear();
+        _layoutFactory = std::move(layoutFactory);
+        _layoutPotentiallyRequired = true;
+    }
+
+    addAllComponents();
+
+    if(resumeAfterChange)
+        resume();
+}
+
+void LayoutThread::setDeterministic(bool deterministic, uint32_t seed)
+{
+    bool resumeAfterChange = false;
+
+    if(!paused())
+    {
+        pauseAndWait();
+        resumeAfterChange = true;
+    }
+
+    _layoutFactory->settings().setDeterministic(deterministic, seed);
+
+    if(resumeAfterChange)
+        resume();
+}
+
+float LayoutThread::convergenceOf(ComponentId componentId) const
+{
+    return _convergences.get(componentId);
+}
+
+float LayoutThread::convergence()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    float weightedConvergence = 0.0f;
+    int numNodes = 0;
+
+    for(const auto& [componentId, layout] : _layouts)
+    {
+        auto componentNumNodes = layout->graphComponent().numNodes();
+        auto componentConvergence = layoutIsFinished(*layout) ? 1.0f : _convergences.get(componentId);
+
+        weightedConvergence += componentConvergence * static_cast<float>(componentNumNodes);
+        numNodes += componentNumNodes;
+    }
+
+    return numNodes > 0 ? weightedConvergence / static_cast<float>(numNodes) : 1.0f;
+}
+
 void LayoutThread::removeComponent(ComponentId componentId)
 {
     bool resumeAfterRemoval = false;
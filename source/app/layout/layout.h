@@ -26,6 +26,7 @@
 #include "shared/utils/performancecounter.h"
 #include "shared/utils/cancellable.h"
 #include "shared/utils/enumbitmask.h"
+#include "shared/utils/threadpool.h"
 
 #include "layoutsettings.h"
 
@@ -82,6 +83,11 @@ protected:
 
     NodeLayoutPositions& positions() { return *_positions; }
 
+    bool deterministic() const { return _settings != nullptr && _settings->deterministic(); }
+
+    // The user's seed when deterministic, otherwise a different one on every call
+    uint32_t seed() const;
+
 public:
     Layout(const IGraphComponent& graphComponent,
            NodeLayoutPositions& positions,
@@ -114,6 +120,9 @@ public:
     // Resets the state of the algorithm such that finished() no longer returns true
     virtual void unfinish() { Q_ASSERT(!"unfinish not implemented"); }
 
+    // An estimate of how close the algorithm is to finishing, from 0 to 1
+    virtual float convergence() const { return finished() ? 1.0f : 0.0f; }
+
     virtual bool iterative() const { return _iterative == Iterative::Yes; }
     virtual Dimensionality dimensionality() const { return _dimensionality; }
 
@@ -185,10 +194,23 @@ private:
     std::condition_variable _waitForPause;
     std::condition_variable _waitForResume;
 
+    // Components with no more than this many nodes are iterated in parallel batches
+    static constexpr int SMALL_COMPONENT_MAXIMUM_NODES = 200;
+
+    // The number of node iterations each small component is allocated per step
+    static constexpr int SMALL_COMPONENT_STEP_COST = 5000;
+    static constexpr int MAXIMUM_ITERATIONS_PER_STEP = 50;
+
     std::unique_ptr<LayoutFactory> _layoutFactory;
     std::map<ComponentId, std::unique_ptr<Layout>> _layouts;
     ComponentArray<bool> _executedAtLeastOnce;
 
+    ComponentArray<float, LockingGraphArray> _convergences;
+    ComponentArray<float, LockingGraphArray> _convergenceRates;
+
+    // Separate from the global pool, which the layouts themselves use
+    ThreadPool _smallComponentThreadPool;
+
     Layout::Dimensionality _dimensionalityMode =
         Layout::Dimensionality::ThreeDee;
 
@@ -233,6 +255,18 @@ public:
     QString layoutName() const;
     QString layoutDisplayName() const;
 
+    // Replace the algorithm; the current positions are the starting point for the new one
+    void setLayoutFactory(std::unique_ptr<LayoutFactory>&& layoutFactory);
+
+    // Takes effect from the next iteration; restart the layout to reproduce a result
+    void setDeterministic(bool deterministic, uint32_t seed);
+
+    // How close the layout of a component is to finishing, from 0 to 1
+    float convergenceOf(ComponentId componentId) const;
+
+    // The convergence of all the components, weighted by their size
+    float convergence();
+
     std::vector<LayoutSetting>& settings();
     const LayoutSetting* setting(const QString& name) const;
 
@@ -246,6 +280,9 @@ private:
     bool workToDo();
     void uncancel();
     void unfinish();
+
+    int iterationBudget(ComponentId componentId, int numNodes) const;
+    void executeLayout(ComponentId componentId, Layout& layout, bool firstIteration, int iterations);
     void run();
 
     void addComponent(ComponentId componentId);
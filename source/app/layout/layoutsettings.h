@@ -27,6 +27,7 @@
 #include <vector>
 #include <utility>
 #include <algorithm>
+#include <cstdint>
 
 enum class LayoutSettingScaleType { Linear, Log };
 
@@ -75,6 +76,9 @@ class LayoutSettings : public QObject
 private:
     std::vector<LayoutSetting> _settings;
 
+    bool _deterministic = false;
+    uint32_t _seed = 0;
+
 public:
     float value(const QString& name) const;
     float normalisedValue(const QString& name) const;
@@ -87,6 +91,17 @@ public:
 
     std::vector<LayoutSetting>& vector() { return _settings; }
 
+    // When deterministic, layouts seed any randomness from seed(), so that
+    // the same seed always produces the same result, regardless of how
+    // many threads are available or how the work is scheduled
+    bool deterministic() const { return _deterministic; }
+    uint32_t seed() const { return _seed; }
+    void setDeterministic(bool deterministic, uint32_t seed)
+    {
+        _deterministic = deterministic;
+        _seed = seed;
+    }
+
     template<typename... Args>
     void registerSetting(Args&&... args)
     {
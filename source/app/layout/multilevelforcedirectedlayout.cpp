@@ -0,0 +1,359 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "multilevelforcedirectedlayout.h"
+
+#include "graph/graph.h"
+#include "graph/graphmodel.h"
+
+#include "shared/graph/elementid_containers.h"
+#include "shared/utils/scopetimer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <tuple>
+#include <cmath>
+
+namespace
+{
+struct WeightedEdge
+{
+    size_t _a;
+    size_t _b;
+    int _weight;
+};
+
+// Collapses a maximal matching of the given nodes, preferring heavier edges, so that each matched
+// pair is represented by a single node; parents is updated to map the absorbed node of each pair
+// to its survivor, and edges is rewritten in terms of the survivors; returns the surviving nodes
+std::vector<size_t> collapseMatching(const std::vector<size_t>& nodes, std::vector<WeightedEdge>& edges,
+    std::vector<size_t>& parents, std::mt19937& generator)
+{
+    const auto numNodes = parents.size();
+
+    // Compressed adjacency lists
+    std::vector<size_t> offsets(numNodes + 1, 0);
+    for(const auto& edge : edges)
+    {
+        offsets[edge._a + 1]++;
+        offsets[edge._b + 1]++;
+    }
+
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<size_t> adjacent(offsets.back());
+    std::vector<int> weights(offsets.back());
+    std::vector<size_t> cursors(offsets.begin(), offsets.end() - 1);
+
+    for(const auto& edge : edges)
+    {
+        adjacent[cursors[edge._a]] = edge._b;
+        weights[cursors[edge._a]++] = edge._weight;
+        adjacent[cursors[edge._b]] = edge._a;
+        weights[cursors[edge._b]++] = edge._weight;
+    }
+
+    // Visit in a random order so that the matching isn't biased towards low node ids
+    auto order = nodes;
+    std::shuffle(order.begin(), order.end(), generator);
+
+    std::vector<bool> matched(numNodes, false);
+    std::vector<size_t> survivors;
+    survivors.reserve(nodes.size());
+
+    for(auto node : order)
+    {
+        if(matched[node])
+            continue;
+
+        matched[node] = true;
+        survivors.push_back(node);
+
+        auto partner = numNodes;
+        int partnerWeight = 0;
+
+        for(auto i = offsets[node]; i < offsets[node + 1]; i++)
+        {
+            if(!matched[adjacent[i]] && weights[i] > partnerWeight)
+            {
+                partner = adjacent[i];
+                partnerWeight = weights[i];
+            }
+        }
+
+        if(partner != numNodes)
+        {
+            matched[partner] = true;
+            parents[partner] = node;
+        }
+    }
+
+    std::sort(survivors.begin(), survivors.end());
+
+    // Merge the edges that become parallel, accumulating their weights
+    for(auto& edge : edges)
+    {
+        edge._a = parents[edge._a];
+        edge._b = parents[edge._b];
+
+        if(edge._a > edge._b)
+            std::swap(edge._a, edge._b);
+    }
+
+    edges.erase(std::remove_if(edges.begin(), edges.end(),
+        [](const auto& edge) { return edge._a == edge._b; }), edges.end());
+
+    std::sort(edges.begin(), edges.end(), [](const auto& a, const auto& b)
+    {
+        return std::tie(a._a, a._b) < std::tie(b._a, b._b);
+    });
+
+    std::vector<WeightedEdge> mergedEdges;
+    for(const auto& edge : edges)
+    {
+        if(!mergedEdges.empty() && mergedEdges.back()._a == edge._a && mergedEdges.back()._b == edge._b)
+            mergedEdges.back()._weight += edge._weight;
+        else
+            mergedEdges.push_back(edge);
+    }
+
+    edges = std::move(mergedEdges);
+
+    return survivors;
+}
+} // namespace
+
+void MultilevelForceDirectedLayout::coarsen()
+{
+    const auto numNodes = nodeIds().size();
+
+    _generator.seed(seed());
+
+    _levels.clear();
+    _parents.resize(numNodes);
+    std::iota(_parents.begin(), _parents.end(), 0);
+    _absorbedLevels.assign(numNodes, std::numeric_limits<int>::max());
+
+    NodeIdMap<size_t> indexOf;
+    for(size_t i = 0; i < numNodes; i++)
+        indexOf.emplace(nodeIds().at(i), i);
+
+    std::vector<size_t> nodes(numNodes);
+    std::iota(nodes.begin(), nodes.end(), 0);
+
+    std::vector<WeightedEdge> edges;
+    edges.reserve(edgeIds().size());
+
+    for(auto edgeId : edgeIds())
+    {
+        const auto& edge = graphComponent().graph().edgeById(edgeId);
+        if(!edge.isLoop())
+            edges.push_back({indexOf.at(edge.sourceId()), indexOf.at(edge.targetId()), 1});
+    }
+
+    while(nodes.size() > MINIMUM_COARSEST_NODE_COUNT && !cancelled())
+    {
+        auto survivors = collapseMatching(nodes, edges, _parents, _generator);
+
+        // Further levels are not worth the iterations they would cost
+        if(static_cast<float>(survivors.size()) > MAXIMUM_COARSENING_RATIO * static_cast<float>(nodes.size()))
+        {
+            for(auto node : nodes)
+                _parents[node] = node;
+
+            break;
+        }
+
+        const auto level = static_cast<int>(_levels.size()) + 1;
+        for(auto node : nodes)
+        {
+            if(_parents[node] != node)
+                _absorbedLevels[node] = level;
+        }
+
+        nodes = std::move(survivors);
+
+        Level coarseLevel;
+        coarseLevel._nodeIds.reserve(nodes.size());
+        for(auto node : nodes)
+            coarseLevel._nodeIds.push_back(nodeIds().at(node));
+
+        coarseLevel._edges.reserve(edges.size());
+        for(const auto& edge : edges)
+            coarseLevel._edges.emplace_back(nodeIds().at(edge._a), nodeIds().at(edge._b));
+
+        _levels.push_back(std::move(coarseLevel));
+    }
+}
+
+void MultilevelForceDirectedLayout::discardHierarchy()
+{
+    _levels.clear();
+    _parents.clear();
+    _absorbedLevels.clear();
+    _ancestors.clear();
+    _hierarchyNodeIds.clear();
+
+    _level = 0;
+    _levelIterationCount = 0;
+    resetChangeDetection();
+}
+
+void MultilevelForceDirectedLayout::updateAncestors()
+{
+    _ancestors.resize(nodeIds().size());
+
+    for(size_t i = 0; i < nodeIds().size(); i++)
+    {
+        auto ancestor = i;
+        while(_absorbedLevels[ancestor] <= _level)
+            ancestor = _parents[ancestor];
+
+        _ancestors[i] = nodeIds().at(ancestor);
+    }
+}
+
+void MultilevelForceDirectedLayout::prolong(Dimensionality dimensionality)
+{
+    const auto& coarseNodeIds = _levels.at(_level - 1)._nodeIds;
+    _level--;
+    const auto& fineNodeIds = _level > 0 ? _levels.at(_level - 1)._nodeIds : nodeIds();
+
+    // Expand the coarse layout so that the finer level ends up at a similar density
+    auto ratio = static_cast<float>(fineNodeIds.size()) / static_cast<float>(coarseNodeIds.size());
+    auto scale = dimensionality == Dimensionality::TwoDee ? std::sqrt(ratio) : std::cbrt(ratio);
+    auto centre = positions().boundingBox(coarseNodeIds).centre();
+
+    for(auto nodeId : coarseNodeIds)
+        positions().set(nodeId, centre + ((positions().get(nodeId) - centre) * scale));
+
+    std::uniform_real_distribution<float> distribution(-PROLONGATION_JITTER, PROLONGATION_JITTER);
+    auto jitter = [this, dimensionality, &distribution]
+    {
+        QVector3D offset(distribution(_generator), distribution(_generator), 0.0f);
+
+        if(dimensionality == Dimensionality::ThreeDee)
+            offset.setZ(distribution(_generator));
+
+        return offset;
+    };
+
+    // Place the nodes that reappear at this level beside the node they were collapsed into...
+    for(size_t i = 0; i < nodeIds().size(); i++)
+    {
+        if(_absorbedLevels[i] == _level + 1)
+        {
+            auto parentPosition = positions().get(nodeIds().at(_parents[i]));
+            positions().set(nodeIds().at(i), parentPosition + jitter());
+        }
+    }
+
+    updateAncestors();
+
+    // ...and those that remain collapsed beside their new representative
+    for(size_t i = 0; i < nodeIds().size(); i++)
+    {
+        auto nodeId = nodeIds().at(i);
+        if(_ancestors[i] != nodeId)
+            positions().set(nodeId, positions().get(_ancestors[i]) + jitter());
+    }
+
+    for(auto nodeId : nodeIds())
+    {
+        auto& displacement = displacements().at(nodeId);
+        displacement._previous = {};
+        displacement._previousLength = 0.0f;
+    }
+
+    _levelIterationCount = 0;
+    resetChangeDetection();
+}
+
+float MultilevelForceDirectedLayout::convergence() const
+{
+    // Each level counts equally
+    auto numLevels = static_cast<float>(_levels.size() + 1);
+    auto levelsCompleted = static_cast<float>(static_cast<int>(_levels.size()) - _level);
+
+    return (levelsCompleted + ForceDirectedLayout::convergence()) / numLevels;
+}
+
+void MultilevelForceDirectedLayout::execute(bool firstIteration, Dimensionality dimensionality)
+{
+    SCOPE_TIMER_MULTISAMPLES(50)
+
+    if(firstIteration)
+    {
+        executeInitialLayout(dimensionality);
+        _coarseningPending = true;
+    }
+
+    if(_coarseningPending)
+    {
+        coarsen();
+
+        // A partial hierarchy would depend on when the cancellation happened
+        if(cancelled())
+            return;
+
+        _coarseningPending = false;
+        _level = static_cast<int>(_levels.size());
+        _hierarchyNodeIds = nodeIds();
+        updateAncestors();
+    }
+
+    // The hierarchy is indexed by position in nodeIds(), so if the component has gained
+    // or lost nodes since it was built, carry on with the nodes where they are at level 0
+    if(_level > 0 && _hierarchyNodeIds != nodeIds())
+        discardHierarchy();
+
+    if(_level == 0)
+    {
+        ForceDirectedLayout::execute(false, dimensionality);
+        return;
+    }
+
+    const auto& level = _levels.at(_level - 1);
+
+    if(!iterate(level._nodeIds, level._edges, dimensionality))
+        return;
+
+    // Carry the collapsed nodes along with their representatives
+    for(size_t i = 0; i < nodeIds().size(); i++)
+    {
+        auto nodeId = nodeIds().at(i);
+        if(_ancestors[i] != nodeId)
+            positions().set(nodeId, positions().get(nodeId) + displacements().at(_ancestors[i])._next);
+    }
+
+    updateChangeDetection(level._nodeIds);
+    _levelIterationCount++;
+
+    if(ForceDirectedLayout::finished() || _levelIterationCount >= MAXIMUM_ITERATIONS_PER_LEVEL)
+        prolong(dimensionality);
+}
+
+std::unique_ptr<Layout> MultilevelForceDirectedLayoutFactory::create(ComponentId componentId,
+    NodeLayoutPositions& nodePositions, Layout::Dimensionality dimensionalityMode)
+{
+    const auto* component = _graphModel->graph().componentById(componentId);
+    return std::make_unique<MultilevelForceDirectedLayout>(*component, _displacements,
+        nodePositions, dimensionalityMode, &_layoutSettings);
+}
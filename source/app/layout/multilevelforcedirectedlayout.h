@@ -0,0 +1,99 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MULTILEVELFORCEDIRECTEDLAYOUT_H
+#define MULTILEVELFORCEDIRECTEDLAYOUT_H
+
+#include "forcedirectedlayout.h"
+
+#include <vector>
+#include <random>
+
+// Builds a hierarchy of successively coarser versions of the component by collapsing
+// matched pairs of adjacent nodes, then lays it out starting from the coarsest level,
+// expanding each level into the next once the force directed layout has settled
+class MultilevelForceDirectedLayout : public ForceDirectedLayout
+{
+    Q_OBJECT
+
+private:
+    static const size_t MINIMUM_COARSEST_NODE_COUNT = 100;
+    static const int MAXIMUM_ITERATIONS_PER_LEVEL = 300;
+    const float MAXIMUM_COARSENING_RATIO = 0.75f;
+    const float PROLONGATION_JITTER = 1.0f;
+
+    struct Level
+    {
+        std::vector<NodeId> _nodeIds;
+        NodeIdPairs _edges;
+    };
+
+    // _levels[k - 1] is level k; level 0 is the component itself
+    std::vector<Level> _levels;
+    int _level = 0;
+    int _levelIterationCount = 0;
+
+    // Indexed by position in nodeIds(); the node each node was collapsed into and
+    // the level at which that first happened
+    std::vector<size_t> _parents;
+    std::vector<int> _absorbedLevels;
+
+    // Indexed by position in nodeIds(); the node that represents each node at _level
+    std::vector<NodeId> _ancestors;
+
+    // The component's nodes when the hierarchy was built; it's abandoned if they change
+    std::vector<NodeId> _hierarchyNodeIds;
+
+    // Reseeded from the layout's seed whenever the hierarchy is (re)built
+    std::mt19937 _generator;
+    bool _coarseningPending = false;
+
+    void coarsen();
+    void discardHierarchy();
+    void updateAncestors();
+    void prolong(Dimensionality dimensionality);
+
+public:
+    MultilevelForceDirectedLayout(const IGraphComponent& graphComponent,
+                                  ForceDirectedDisplacements& displacements,
+                                  NodeLayoutPositions& positions,
+                                  Layout::Dimensionality dimensionalityMode,
+                                  const LayoutSettings* settings) :
+        ForceDirectedLayout(graphComponent, displacements, positions, dimensionalityMode, settings)
+    {}
+
+    float convergence() const override;
+
+    void execute(bool firstIteration, Dimensionality dimensionality) override;
+};
+
+class MultilevelForceDirectedLayoutFactory : public ForceDirectedLayoutFactory
+{
+public:
+    explicit MultilevelForceDirectedLayoutFactory(GraphModel* graphModel) :
+        ForceDirectedLayoutFactory(graphModel)
+    {}
+
+    QString name() const override { return QStringLiteral("MultilevelForceDirected"); }
+    QString displayName() const override { return QObject::tr("Multilevel Force Directed"); }
+    std::unique_ptr<Layout> create(ComponentId componentId, NodeLayoutPositions& nodePositions,
+        Layout::Dimensionality dimensionalityMode) override;
+};
+
+#endif // MULTILEVELFORCEDIRECTEDLAYOUT_H
@@ -0,0 +1,140 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "nodebvh.h"
+
+#include "nodepositions.h"
+
+#include <algorithm>
+
+namespace
+{
+float surfaceArea(const BoundingBox3D& boundingBox)
+{
+    auto x = boundingBox.xLength();
+    auto y = boundingBox.yLength();
+    auto z = boundingBox.zLength();
+
+    return 2.0f * ((x * y) + (y * z) + (z * x));
+}
+} // namespace
+
+NodeBVH::NodeBVH(const std::vector<NodeId>& nodeIds, const NodePositions& nodePositions) :
+    _epoch(nodePositions.epoch())
+{
+    _entries.reserve(nodeIds.size());
+    for(auto nodeId : nodeIds)
+        _entries.push_back({nodeId, nodePositions.getWhileLocked(nodeId)});
+
+    if(_entries.empty())
+        return;
+
+    build(0, static_cast<int>(_entries.size()));
+    _builtCost = _cost;
+}
+
+int NodeBVH::build(int first, int count)
+{
+    auto index = static_cast<int>(_volumes.size());
+    _volumes.emplace_back();
+
+    Volume volume;
+    volume._first = first;
+    volume._count = count;
+
+    if(count > MaxNodesPerLeaf)
+    {
+        const auto& firstPosition = _entries.at(static_cast<size_t>(first))._position;
+        BoundingBox3D boundingBox(firstPosition, firstPosition);
+        for(int i = first; i < first + count; i++)
+            boundingBox.expandToInclude(_entries.at(static_cast<size_t>(i))._position);
+
+        // Split at the median of the longest axis
+        int axis = 0;
+        if(boundingBox.yLength() > boundingBox.xLength())
+            axis = 1;
+        if(boundingBox.zLength() > std::max(boundingBox.xLength(), boundingBox.yLength()))
+            axis = 2;
+
+        auto begin = _entries.begin() + first;
+        auto half = count / 2;
+        std::nth_element(begin, begin + half, begin + count,
+        [axis](const auto& a, const auto& b)
+        {
+            return a._position[axis] < b._position[axis];
+        });
+
+        volume._left = build(first, half);
+        volume._right = build(first + half, count - half);
+    }
+
+    fit(volume);
+    _volumes.at(static_cast<size_t>(index)) = volume;
+
+    return index;
+}
+
+void NodeBVH::fit(Volume& volume)
+{
+    if(volume.isLeaf())
+    {
+        const auto& firstPosition = _entries.at(static_cast<size_t>(volume._first))._position;
+        volume._boundingBox.set(firstPosition, firstPosition);
+
+        for(int i = volume._first; i < volume._first + volume._count; i++)
+            volume._boundingBox.expandToInclude(_entries.at(static_cast<size_t>(i))._position);
+
+        _cost += surfaceArea(volume._boundingBox);
+    }
+    else
+    {
+        volume._boundingBox = _volumes.at(static_cast<size_t>(volume._left))._boundingBox;
+        volume._boundingBox.expandToInclude(_volumes.at(static_cast<size_t>(volume._right))._boundingBox);
+    }
+
+    volume._centre = volume._boundingBox.centre();
+    volume._radius = (volume._boundingBox.max() - volume._centre).length();
+}
+
+bool NodeBVH::refit(const NodePositions& nodePositions)
+{
+    _epoch = nodePositions.epoch();
+    _cost = 0.0f;
+
+    for(auto& entry : _entries)
+        entry._position = nodePositions.getWhileLocked(entry._nodeId);
+
+    // Children always follow their parents, so this fits bottom up
+    for(auto it = _volumes.rbegin(); it != _volumes.rend(); ++it)
+        fit(*it);
+
+    // Once the nodes have moved far enough that the leaves overlap
+    // significantly, queries on the tree are no longer efficient
+    const float MaxCostRatio = 2.0f;
+    return _cost <= _builtCost * MaxCostRatio;
+}
+
+std::unique_ptr<NodeBVH> NodeBVH::refitted(const NodePositions& nodePositions) const
+{
+    auto bvh = std::make_unique<NodeBVH>(*this);
+
+    if(!bvh->refit(nodePositions))
+        return nullptr;
+
+    return bvh;
+}
@@ -0,0 +1,165 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NODEBVH_H
+#define NODEBVH_H
+
+#include "shared/graph/elementid.h"
+#include "maths/boundingbox.h"
+#include "maths/frustum.h"
+
+#include <QVector3D>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class NodePositions;
+
+// A bounding volume hierarchy over a snapshot of the positions of a set of nodes,
+// for answering spatial queries without visiting every node; as the nodes move
+// it is refitted to the new positions, rather than being built again from scratch
+class NodeBVH
+{
+private:
+    static constexpr int MaxNodesPerLeaf = 8;
+
+    struct Entry
+    {
+        NodeId _nodeId;
+        QVector3D _position;
+    };
+
+    struct Volume
+    {
+        BoundingBox3D _boundingBox;
+        QVector3D _centre;
+        float _radius = 0.0f;
+
+        // For leaves, the range of entries, otherwise the indices of the children,
+        // which are always greater than that of their parent
+        int _first = 0;
+        int _count = 0;
+        int _left = -1;
+        int _right = -1;
+
+        bool isLeaf() const { return _left < 0; }
+    };
+
+    std::vector<Entry> _entries;
+    std::vector<Volume> _volumes;
+    uint64_t _epoch = 0;
+
+    // The total surface area of the leaves, which grows as refitting degrades the tree
+    float _builtCost = 0.0f;
+    float _cost = 0.0f;
+
+    int build(int first, int count);
+    void fit(Volume& volume);
+
+    template<typename VolumeFn, typename EntryFn>
+    void traverse(VolumeFn&& volumeFn, EntryFn&& entryFn) const
+    {
+        if(_volumes.empty())
+            return;
+
+        std::vector<int> stack;
+        stack.push_back(0);
+
+        while(!stack.empty())
+        {
+            const auto& volume = _volumes.at(static_cast<size_t>(stack.back()));
+            stack.pop_back();
+
+            if(!volumeFn(volume._centre, volume._radius))
+                continue;
+
+            if(volume.isLeaf())
+            {
+                for(int i = volume._first; i < volume._first + volume._count; i++)
+                {
+                    const auto& entry = _entries.at(static_cast<size_t>(i));
+                    entryFn(entry._nodeId, entry._position);
+                }
+            }
+            else
+            {
+                stack.push_back(volume._right);
+                stack.push_back(volume._left);
+            }
+        }
+    }
+
+public:
+    // Requires the NodePositions lock to be held
+    NodeBVH(const std::vector<NodeId>& nodeIds, const NodePositions& nodePositions);
+
+    uint64_t epoch() const { return _epoch; }
+
+    // Fits the volumes to the current positions, returning false if the tree is
+    // now so degraded that it's better built again; requires the NodePositions
+    // lock to be held
+    bool refit(const NodePositions& nodePositions);
+
+    // As above, but leaves this tree alone and returns a refitted copy, or nullptr
+    std::unique_ptr<NodeBVH> refitted(const NodePositions& nodePositions) const;
+
+    // Calls fn with each node that is in front of point and might be within radius
+    // of the line through it, where direction is a unit vector
+    template<typename Fn>
+    void forEachNodeNearLine(const QVector3D& point, const QVector3D& direction,
+        float radius, Fn&& fn) const
+    {
+        traverse([&point, &direction, radius](const QVector3D& centre, float volumeRadius)
+        {
+            return QVector3D::dotProduct(centre - point, direction) >= -volumeRadius &&
+                centre.distanceToLine(point, direction) <= radius + volumeRadius;
+        }, std::forward<Fn>(fn));
+    }
+
+    // As above, but for finding the closest node to a line, where the radius
+    // shrinks as closer nodes are found; fn returns the new radius
+    template<typename Fn>
+    void forEachNodeClosestToLine(const QVector3D& point, const QVector3D& direction,
+        float initialRadius, Fn&& fn) const
+    {
+        float radius = initialRadius;
+
+        traverse([&point, &direction, &radius](const QVector3D& centre, float volumeRadius)
+        {
+            return QVector3D::dotProduct(centre - point, direction) >= -volumeRadius &&
+                centre.distanceToLine(point, direction) <= radius + volumeRadius;
+        },
+        [&fn, &radius](NodeId nodeId, const QVector3D& position)
+        {
+            radius = fn(nodeId, position);
+        });
+    }
+
+    // Calls fn with each node that might be inside frustum
+    template<typename Fn>
+    void forEachNodeInFrustum(const BaseFrustum& frustum, Fn&& fn) const
+    {
+        traverse([&frustum](const QVector3D& centre, float volumeRadius)
+        {
+            return frustum.intersectsSphere(centre, volumeRadius);
+        }, std::forward<Fn>(fn));
+    }
+};
+
+#endif // NODEBVH_H
@@ -47,6 +47,13 @@ QVector3D NodePositions::get(NodeId nodeId) const
 {
     std::unique_lock<const NodePositions> lock(*this);
 
+    return getWhileLocked(nodeId);
+}
+
+QVector3D NodePositions::getWhileLocked(NodeId nodeId) const
+{
+    Q_ASSERT(!unlocked());
+
     return elementFor(nodeId).mean(_smoothing) * _scale;
 }
 
@@ -65,11 +72,62 @@ void NodePositions::flatten()
     });
 }
 
-void NodePositions::update(const NodePositions& other)
+void NodePositions::publish(const NodePositions& other, bool flatten)
 {
-    std::unique_lock<const NodePositions> lock(*this);
+    auto& snapshot = _snapshots.at(_writeSnapshot);
+    snapshot = other._array;
+
+    if(flatten)
+    {
+        for(auto& positions : snapshot)
+        {
+            for(size_t i = 0; i < positions.size(); i++)
+                positions.at(i).setZ(0.0f);
+        }
+    }
+
+    _publishedEpoch++;
+
+    auto previous = _latestSnapshot.exchange((_publishedEpoch << SnapshotEpochShift) |
+        SnapshotFreshBit | _writeSnapshot);
+
+    // Take whichever snapshot was previously the latest, which is either
+    // the one we published last time, or the reader's spare
+    _writeSnapshot = previous & SnapshotIndexMask;
+}
+
+bool NodePositions::acquire()
+{
+    if((_latestSnapshot.load() & SnapshotFreshBit) == 0)
+        return false;
+
+    // Readers on other threads may also be acquiring, or holding the
+    // lock to get a consistent set of positions
+    std::unique_lock<std::recursive_mutex> lock(_mutex);
+
+    // Swap in our spare, which is never marked as fresh, unless another
+    // reader took the latest snapshot while we were waiting for the lock
+    auto latest = _latestSnapshot.load();
+    do
+    {
+        if((latest & SnapshotFreshBit) == 0)
+            return false;
+    }
+    while(!_latestSnapshot.compare_exchange_weak(latest, _spareSnapshot));
+
+    auto latestSnapshot = latest & SnapshotIndexMask;
+
+    auto size = _array.size();
+    _array.swap(_snapshots.at(latestSnapshot));
+
+    // The graph may have grown since the snapshot was published
+    if(_array.size() < size)
+        _array.resize(size);
+
+    _spareSnapshot = latestSnapshot;
+    _epoch = latest >> SnapshotEpochShift;
 
-    _array = other._array;
+    return true;
 }
 
 template<typename GetFn>
@@ -25,8 +25,11 @@
 #include "maths/boundingbox.h"
 
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include <QVector3D>
 
@@ -44,6 +47,27 @@ private:
     float _scale = 1.0f;
     int _smoothing = 1;
 
+    // Positions are handed from the layout to readers through a triple buffer, so
+    // that neither has to wait on the other: at any one time, one snapshot is
+    // being written by the layout, one is the most recently published and the
+    // third is whatever the reader last swapped out of the array's own storage
+    std::array<std::vector<MeanPosition>, 3> _snapshots;
+
+    // The index of the most recently published snapshot, whether or not it's
+    // been acquired yet, and the epoch at which it was published
+    static constexpr uint64_t SnapshotIndexMask = 0x3;
+    static constexpr uint64_t SnapshotFreshBit = 0x4;
+    static constexpr int SnapshotEpochShift = 3;
+    std::atomic<uint64_t> _latestSnapshot{0};
+
+    // Owned by the publisher
+    uint64_t _writeSnapshot = 1;
+    uint64_t _publishedEpoch = 0;
+
+    // Owned by the readers, protected by _mutex
+    uint64_t _spareSnapshot = 2;
+    std::atomic<uint64_t> _epoch{0};
+
 protected:
     const QVector3D& getUnsafe(NodeId nodeId) const;
 
@@ -62,9 +86,24 @@ public:
 
     QVector3D get(NodeId nodeId) const;
 
+    // For when the lock is already held, possibly by another thread on behalf of
+    // the caller, e.g. when reading positions concurrently from a thread pool
+    QVector3D getWhileLocked(NodeId nodeId) const;
+
     void flatten();
 
-    void update(const NodePositions& other);
+    // Publishes a copy of other's positions, without blocking; this must only
+    // ever be called from one thread at a time, typically the layout thread
+    void publish(const NodePositions& other, bool flatten = false);
+
+    // Makes the most recently published positions visible to get, returning
+    // false if there are none newer than the current ones; the renderer does
+    // this every frame, but anything else that needs the layout's current
+    // positions, e.g. when saving, should also do so, in case it isn't drawing
+    bool acquire();
+
+    // The epoch at which the current positions were published
+    uint64_t epoch() const { return _epoch.load(); }
 
     QVector3D centreOfMass(const std::vector<NodeId>& nodeIds) const;
 
@@ -87,9 +87,12 @@ struct SubVolume
     }
 };
 
-// Use the CRT pattern so we can create instances of subclasses by default constructor
-template<typename TreeType, size_t NumDimensions, typename SubVolumeType = SubVolume<TreeType, NumDimensions>>
-class SpatialTree : virtual public AbstractSpatialTree
+// Use the CRT pattern so we can create instances of subclasses by default constructor; Positions
+// need only provide get(NodeId), so trees can be built from positions other than the layout's
+template<typename TreeType, size_t NumDimensions,
+    typename SubVolumeType = SubVolume<TreeType, NumDimensions>,
+    typename Positions = NodeLayoutPositions>
+class SpatialTree
 {
 private:
     static constexpr size_t NumSubVolumes()
@@ -175,7 +178,7 @@ private:
             Q_ASSERT(subVolume._boundingBox.valid());
     }
 
-    void distributeNodesOverSubVolumes(const NodeLayoutPositions& nodePositions, const std::vector<NodeId>& nodeIds)
+    void distributeNodesOverSubVolumes(const Positions& nodePositions, const std::vector<NodeId>& nodeIds)
     {
         initialiseSubVolumes();
 
@@ -225,9 +228,9 @@ private:
 
     // The second parameter and superset of _subVolumes[x]._nodeIds are the
     // same, at the point when this is called
-    virtual void initialise(const NodeLayoutPositions&, const std::vector<NodeId>&) {}
+    virtual void initialise(const Positions&, const std::vector<NodeId>&) {}
 
-    void build(const std::vector<NodeId>& nodeIds, const NodeLayoutPositions& nodePositions)
+    void build(const std::vector<NodeId>& nodeIds, const Positions& nodePositions)
     {
         SCOPE_TIMER_MULTISAMPLES(50)
 
@@ -316,18 +319,23 @@ protected:
     void setMaxNodesPerLeaf(unsigned int maxNodesPerLeaf) { _maxNodesPerLeaf = maxNodesPerLeaf; }
 
 public:
-    void build(const IGraphComponent& graph, const NodeLayoutPositions& nodePositions) override
+    virtual ~SpatialTree() = default;
+
+    void build(const std::vector<NodeId>& nodeIds, const Positions& nodePositions,
+        const BoundingBox3D& boundingBox)
     {
         if constexpr(NumDimensions == 2)
-        {
-            auto boundingBox3D = nodePositions.boundingBox(graph.nodeIds());
-            _boundingBox = {boundingBox3D.min().toVector2D(), boundingBox3D.max().toVector2D()};
-        }
+            _boundingBox = {boundingBox.min().toVector2D(), boundingBox.max().toVector2D()};
         else if constexpr(NumDimensions == 3)
-            _boundingBox = nodePositions.boundingBox(graph.nodeIds());
+            _boundingBox = boundingBox;
 
         Q_ASSERT(_boundingBox.valid());
-        build(graph.nodeIds(), nodePositions);
+        build(nodeIds, nodePositions);
+    }
+
+    void build(const IGraphComponent& graph, const NodeLayoutPositions& nodePositions)
+    {
+        build(graph.nodeIds(), nodePositions, nodePositions.boundingBox(graph.nodeIds()));
     }
 };
 
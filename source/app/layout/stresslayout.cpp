@@ -0,0 +1,565 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "stresslayout.h"
+
+#include "graph/graph.h"
+#include "graph/graphmodel.h"
+
+#include "shared/graph/elementid_containers.h"
+#include "shared/utils/threadpool.h"
+#include "shared/utils/scopetimer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <limits>
+#include <cmath>
+
+namespace
+{
+// Set distances to the number of edges between source and every other node
+void breadthFirstDistances(size_t source, const std::vector<size_t>& offsets,
+    const std::vector<size_t>& adjacent, std::vector<int>::iterator distances, size_t numNodes)
+{
+    std::fill(distances, distances + static_cast<std::ptrdiff_t>(numNodes), -1);
+
+    std::vector<size_t> queue;
+    queue.reserve(numNodes);
+
+    distances[static_cast<std::ptrdiff_t>(source)] = 0;
+    queue.push_back(source);
+
+    for(size_t head = 0; head < queue.size(); head++)
+    {
+        auto node = queue[head];
+        auto distance = distances[static_cast<std::ptrdiff_t>(node)] + 1;
+
+        for(auto i = offsets[node]; i < offsets[node + 1]; i++)
+        {
+            auto& neighbourDistance = distances[static_cast<std::ptrdiff_t>(adjacent[i])];
+            if(neighbourDistance < 0)
+            {
+                neighbourDistance = distance;
+                queue.push_back(adjacent[i]);
+            }
+        }
+    }
+}
+} // namespace
+
+void StressLayout::initialise()
+{
+    const auto numNodes = nodeIds().size();
+
+    NodeIdMap<size_t> indexOf;
+    for(size_t i = 0; i < numNodes; i++)
+        indexOf.emplace(nodeIds().at(i), i);
+
+    std::vector<std::pair<size_t, size_t>> edges;
+    edges.reserve(edgeIds().size());
+
+    for(auto edgeId : edgeIds())
+    {
+        const auto& edge = graphComponent().graph().edgeById(edgeId);
+        if(!edge.isLoop())
+            edges.emplace_back(indexOf.at(edge.sourceId()), indexOf.at(edge.targetId()));
+    }
+
+    _offsets.assign(numNodes + 1, 0);
+    for(const auto& [source, target] : edges)
+    {
+        _offsets[source + 1]++;
+        _offsets[target + 1]++;
+    }
+
+    std::partial_sum(_offsets.begin(), _offsets.end(), _offsets.begin());
+
+    _adjacent.resize(_offsets.back());
+    std::vector<size_t> cursors(_offsets.begin(), _offsets.end() - 1);
+
+    for(const auto& [source, target] : edges)
+    {
+        _adjacent[cursors[source]++] = target;
+        _adjacent[cursors[target]++] = source;
+    }
+
+    _indices.resize(numNodes);
+    std::iota(_indices.begin(), _indices.end(), 0);
+
+    sampleSecondNeighbours();
+
+    _positions.resize(numNodes);
+    _nextPositions.resize(numNodes);
+    _stresses.resize(numNodes);
+
+    selectPivots();
+
+    _initialised = !cancelled();
+}
+
+void StressLayout::sampleSecondNeighbours()
+{
+    const auto numNodes = nodeIds().size();
+    const auto none = std::numeric_limits<size_t>::max();
+
+    std::vector<std::pair<size_t, size_t>> pairs;
+
+    // marks[j] == i when j is already a term of i
+    std::vector<size_t> marks(numNodes, none);
+
+    for(size_t i = 0; i < numNodes; i++)
+    {
+        marks[i] = i;
+        for(auto a = _offsets[i]; a < _offsets[i + 1]; a++)
+            marks[_adjacent[a]] = i;
+
+        size_t numSampled = 0;
+
+        for(auto a = _offsets[i]; a < _offsets[i + 1] && numSampled < MAXIMUM_SECOND_NEIGHBOURS; a++)
+        {
+            auto neighbour = _adjacent[a];
+            auto degree = _offsets[neighbour + 1] - _offsets[neighbour];
+
+            // Start from a different place for each node, so that nodes sharing a high
+            // degree neighbour don't all sample the same handful of its other neighbours
+            for(size_t b = 0; b < degree && numSampled < MAXIMUM_SECOND_NEIGHBOURS; b++)
+            {
+                auto secondNeighbour = _adjacent[_offsets[neighbour] + ((i + b) % degree)];
+
+                if(marks[secondNeighbour] == i)
+                    continue;
+
+                marks[secondNeighbour] = i;
+                pairs.emplace_back(std::min(i, secondNeighbour), std::max(i, secondNeighbour));
+                numSampled++;
+            }
+        }
+    }
+
+    // The terms must be symmetric, otherwise the nodes chase each other indefinitely
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    _secondOffsets.assign(numNodes + 1, 0);
+    for(const auto& [a, b] : pairs)
+    {
+        _secondOffsets[a + 1]++;
+        _secondOffsets[b + 1]++;
+    }
+
+    std::partial_sum(_secondOffsets.begin(), _secondOffsets.end(), _secondOffsets.begin());
+
+    _secondNeighbours.resize(_secondOffsets.back());
+    std::vector<size_t> cursors(_secondOffsets.begin(), _secondOffsets.end() - 1);
+
+    for(const auto& [a, b] : pairs)
+    {
+        _secondNeighbours[cursors[a]++] = b;
+        _secondNeighbours[cursors[b]++] = a;
+    }
+}
+
+void StressLayout::selectPivots()
+{
+    const auto numNodes = nodeIds().size();
+    const auto maxPivots = std::min(MAXIMUM_PIVOTS, numNodes);
+
+    _pivots.clear();
+    _pivotDistances.resize(maxPivots * numNodes);
+
+    auto degreeOf = [this](size_t node) { return _offsets[node + 1] - _offsets[node]; };
+
+    size_t pivot = 0;
+    for(size_t i = 1; i < numNodes; i++)
+    {
+        if(degreeOf(i) > degreeOf(pivot))
+            pivot = i;
+    }
+
+    // Starting with the highest degree node, repeatedly choose the node that
+    // is furthest from all of the pivots chosen so far
+    std::vector<int> nearestPivotDistances(numNodes, std::numeric_limits<int>::max());
+
+    while(_pivots.size() < maxPivots)
+    {
+        if(cancelled())
+            return;
+
+        auto distances = _pivotDistances.begin() +
+            static_cast<std::ptrdiff_t>(_pivots.size() * numNodes);
+
+        _pivots.push_back(pivot);
+        breadthFirstDistances(pivot, _offsets, _adjacent, distances, numNodes);
+
+        for(size_t i = 0; i < numNodes; i++)
+        {
+            // Nodes in the same component should always be reachable
+            Q_ASSERT(distances[static_cast<std::ptrdiff_t>(i)] >= 0);
+            nearestPivotDistances[i] = std::min(nearestPivotDistances[i],
+                distances[static_cast<std::ptrdiff_t>(i)]);
+        }
+
+        auto furthest = std::max_element(nearestPivotDistances.begin(), nearestPivotDistances.end());
+
+        // Every node is a pivot
+        if(*furthest <= 0)
+            break;
+
+        pivot = static_cast<size_t>(std::distance(nearestPivotDistances.begin(), furthest));
+    }
+
+    _pivotDistances.resize(_pivots.size() * numNodes);
+
+    // Each pivot stands in for the nodes it is nearest to
+    _pivotRegionSizes.assign(_pivots.size(), 0);
+    for(size_t i = 0; i < numNodes; i++)
+    {
+        size_t nearest = 0;
+        for(size_t p = 1; p < _pivots.size(); p++)
+        {
+            if(_pivotDistances[(p * numNodes) + i] < _pivotDistances[(nearest * numNodes) + i])
+                nearest = p;
+        }
+
+        _pivotRegionSizes[nearest]++;
+    }
+}
+
+void StressLayout::pivotMDS(Dimensionality dimensionality)
+{
+    const auto numNodes = nodeIds().size();
+    const auto numPivots = _pivots.size();
+    const size_t numDimensions = dimensionality == Dimensionality::TwoDee ? 2 : 3;
+    const float edgeLength = _settings->value(QStringLiteral("EdgeLength"));
+
+    std::vector<size_t> pivotIndices(numPivots);
+    std::iota(pivotIndices.begin(), pivotIndices.end(), 0);
+
+    auto squaredDistance = [this, numNodes, edgeLength](size_t i, size_t p)
+    {
+        auto distance = static_cast<double>(_pivotDistances[(p * numNodes) + i] * edgeLength);
+        return distance * distance;
+    };
+
+    std::vector<double> nodeMeans(numNodes);
+    concurrent_for(_indices.begin(), _indices.end(),
+    [&nodeMeans, &squaredDistance, numPivots](size_t i)
+    {
+        double sum = 0.0;
+        for(size_t p = 0; p < numPivots; p++)
+            sum += squaredDistance(i, p);
+
+        nodeMeans[i] = sum / static_cast<double>(numPivots);
+    });
+
+    std::vector<double> pivotMeans(numPivots);
+    concurrent_for(pivotIndices.begin(), pivotIndices.end(),
+    [&pivotMeans, &squaredDistance, numNodes](size_t p)
+    {
+        double sum = 0.0;
+        for(size_t i = 0; i < numNodes; i++)
+            sum += squaredDistance(i, p);
+
+        pivotMeans[p] = sum / static_cast<double>(numNodes);
+    });
+
+    const auto mean = std::accumulate(pivotMeans.begin(), pivotMeans.end(), 0.0) /
+        static_cast<double>(numPivots);
+
+    // The double centred matrix of squared distances, C, computed as required
+    // rather than stored, since it has an element for every node/pivot pair
+    auto centred = [&](size_t i, size_t p)
+    {
+        return -0.5 * (squaredDistance(i, p) - nodeMeans[i] - pivotMeans[p] + mean);
+    };
+
+    if(cancelled())
+        return;
+
+    // CᵀC, whose dominant eigenvectors project C onto the layout's axes
+    std::vector<double> ctc(numPivots * numPivots, 0.0);
+    concurrent_for(pivotIndices.begin(), pivotIndices.end(),
+    [&ctc, &centred, numNodes, numPivots](size_t a)
+    {
+        auto* row = &ctc[a * numPivots];
+
+        for(size_t i = 0; i < numNodes; i++)
+        {
+            auto c = centred(i, a);
+            for(size_t b = 0; b < numPivots; b++)
+                row[b] += c * centred(i, b);
+        }
+    });
+
+    if(cancelled())
+        return;
+
+    // Power iteration, deflating each subsequent eigenvector against the previous ones
+    std::mt19937 generator(seed());
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    std::vector<std::vector<double>> eigenvectors;
+
+    for(size_t d = 0; d < numDimensions; d++)
+    {
+        std::vector<double> v(numPivots);
+        std::generate(v.begin(), v.end(), [&] { return distribution(generator); });
+
+        for(int iteration = 0; iteration < POWER_ITERATIONS; iteration++)
+        {
+            std::vector<double> w(numPivots, 0.0);
+            for(size_t a = 0; a < numPivots; a++)
+            {
+                for(size_t b = 0; b < numPivots; b++)
+                    w[a] += ctc[(a * numPivots) + b] * v[b];
+            }
+
+            for(const auto& eigenvector : eigenvectors)
+            {
+                auto dot = std::inner_product(w.begin(), w.end(), eigenvector.begin(), 0.0);
+                for(size_t a = 0; a < numPivots; a++)
+                    w[a] -= dot * eigenvector[a];
+            }
+
+            auto norm = std::sqrt(std::inner_product(w.begin(), w.end(), w.begin(), 0.0));
+
+            // There are fewer pivots than dimensions
+            if(norm < std::numeric_limits<double>::epsilon())
+            {
+                std::fill(v.begin(), v.end(), 0.0);
+                break;
+            }
+
+            std::transform(w.begin(), w.end(), v.begin(), [norm](auto x) { return x / norm; });
+        }
+
+        eigenvectors.push_back(std::move(v));
+    }
+
+    // Nodes that are equidistant from every pivot coincide, so add a small
+    // amount of noise to give the stress majorisation something to work with
+    std::vector<QVector3D> noise(numNodes);
+    std::uniform_real_distribution<float> noiseDistribution(-0.05f * edgeLength, 0.05f * edgeLength);
+    for(auto& offset : noise)
+    {
+        offset = {noiseDistribution(generator), noiseDistribution(generator), 0.0f};
+        if(numDimensions > 2)
+            offset.setZ(noiseDistribution(generator));
+    }
+
+    concurrent_for(_indices.begin(), _indices.end(),
+    [this, &eigenvectors, &centred, &noise, numPivots](size_t i)
+    {
+        QVector3D position;
+
+        for(size_t d = 0; d < eigenvectors.size(); d++)
+        {
+            double coordinate = 0.0;
+            for(size_t p = 0; p < numPivots; p++)
+                coordinate += centred(i, p) * eigenvectors[d][p];
+
+            position[static_cast<int>(d)] = static_cast<float>(coordinate);
+        }
+
+        _positions[i] = position + noise[i];
+    });
+
+    // The projection is only correct up to scale, so normalise the edge lengths
+    double totalEdgeLength = 0.0;
+    for(size_t i = 0; i < numNodes; i++)
+    {
+        for(auto a = _offsets[i]; a < _offsets[i + 1]; a++)
+            totalEdgeLength += (_positions[i] - _positions[_adjacent[a]]).length();
+    }
+
+    if(!_adjacent.empty() && totalEdgeLength > 0.0)
+    {
+        auto scale = static_cast<float>((edgeLength * _adjacent.size()) / totalEdgeLength);
+        for(auto& position : _positions)
+            position *= scale;
+    }
+}
+
+double StressLayout::majorise(Dimensionality dimensionality)
+{
+    const auto numNodes = nodeIds().size();
+    const float edgeLength = _settings->value(QStringLiteral("EdgeLength"));
+    const float neighbourWeight = 1.0f / (edgeLength * edgeLength);
+
+    // Each node moves to the weighted average of the positions that would place it at the
+    // ideal distance from each of its terms; the terms are all read from the previous
+    // iteration's positions, so the nodes can be updated independently
+    concurrent_for(_indices.begin(), _indices.end(),
+    [this, numNodes, edgeLength, neighbourWeight, dimensionality](size_t i)
+    {
+        if(cancelled())
+            return;
+
+        const auto& position = _positions[i];
+        QVector3D numerator;
+        float denominator = 0.0f;
+        double stress = 0.0;
+
+        auto addTerm = [&](size_t j, float distance, float weight)
+        {
+            const auto& other = _positions[j];
+            auto difference = position - other;
+            auto length = difference.length();
+
+            numerator += weight * other;
+            if(length > 0.0f)
+                numerator += weight * difference * (distance / length);
+
+            denominator += weight;
+
+            auto error = static_cast<double>(length - distance);
+            stress += weight * error * error;
+        };
+
+        for(auto a = _offsets[i]; a < _offsets[i + 1]; a++)
+            addTerm(_adjacent[a], edgeLength, neighbourWeight);
+
+        for(auto a = _secondOffsets[i]; a < _secondOffsets[i + 1]; a++)
+            addTerm(_secondNeighbours[a], 2.0f * edgeLength, 0.25f * neighbourWeight);
+
+        for(size_t p = 0; p < _pivots.size(); p++)
+        {
+            auto edges = _pivotDistances[(p * numNodes) + i];
+
+            // Adjacent pivots are already terms
+            if(edges <= 1)
+                continue;
+
+            auto distance = static_cast<float>(edges) * edgeLength;
+            addTerm(_pivots[p], distance,
+                static_cast<float>(_pivotRegionSizes[p]) / (distance * distance));
+        }
+
+        auto nextPosition = denominator > 0.0f ? numerator / denominator : position;
+
+        if(dimensionality == Dimensionality::TwoDee)
+            nextPosition.setZ(0.0f);
+
+        _nextPositions[i] = nextPosition;
+        _stresses[i] = stress;
+    });
+
+    return std::accumulate(_stresses.begin(), _stresses.end(), 0.0);
+}
+
+void StressLayout::unfinish()
+{
+    // The component's membership may have changed while paused, so rebuild the
+    // topology; the majorisation carries on from the current positions
+    _initialised = false;
+
+    _finished = false;
+    _iteration = 0;
+    _previousStress = 0.0;
+    _relativeStressChange = 0.0;
+}
+
+float StressLayout::convergence() const
+{
+    if(_finished)
+        return 1.0f;
+
+    if(_relativeStressChange <= 0.0)
+        return 0.0f;
+
+    // Progress towards CONVERGENCE_TOLERANCE on a log scale, from 4 orders of magnitude above
+    auto orders = std::log10(_relativeStressChange / CONVERGENCE_TOLERANCE);
+    return static_cast<float>(std::clamp(1.0 - (orders / 4.0), 0.0, 1.0));
+}
+
+void StressLayout::execute(bool firstIteration, Dimensionality dimensionality)
+{
+    SCOPE_TIMER_MULTISAMPLES(50)
+
+    // Remember the need for a projection, in case it is cancelled before it completes
+    if(firstIteration)
+        _projectionPending = true;
+
+    if(!_initialised || _positions.size() != nodeIds().size())
+    {
+        initialise();
+
+        if(!_initialised)
+            return;
+    }
+
+    // Coming out of 2D, there is no information in the Z axis for the
+    // majorisation to work with, so start again from the projection
+    if(_projectionPending || (dimensionality == Dimensionality::ThreeDee && _hasBeenFlattened))
+    {
+        pivotMDS(dimensionality);
+
+        if(cancelled())
+            return;
+
+        _projectionPending = false;
+    }
+    else
+    {
+        for(size_t i = 0; i < nodeIds().size(); i++)
+            _positions[i] = positions().get(nodeIds().at(i));
+    }
+
+    _hasBeenFlattened = dimensionality == Dimensionality::TwoDee;
+
+    auto stress = majorise(dimensionality);
+
+    if(cancelled())
+        return;
+
+    std::swap(_positions, _nextPositions);
+
+    for(size_t i = 0; i < nodeIds().size(); i++)
+        positions().set(nodeIds().at(i), _positions[i]);
+
+    _iteration++;
+
+    _relativeStressChange = _previousStress > 0.0 ?
+        std::abs(_previousStress - stress) / _previousStress : 0.0;
+
+    // Stop once the stress is no longer decreasing significantly; the terms aren't symmetric
+    // so the nodes never entirely come to rest
+    if((_previousStress > 0.0 && _relativeStressChange < CONVERGENCE_TOLERANCE) ||
+        _iteration >= MAXIMUM_ITERATIONS)
+    {
+        _finished = true;
+    }
+
+    _previousStress = stress;
+}
+
+StressLayoutFactory::StressLayoutFactory(GraphModel* graphModel) :
+    LayoutFactory(graphModel)
+{
+    _layoutSettings.registerSetting("EdgeLength", QObject::tr("Edge Length"),
+                                    1.0f, 100.0f, 25.0f);
+}
+
+std::unique_ptr<Layout> StressLayoutFactory::create(ComponentId componentId,
+    NodeLayoutPositions& nodePositions, Layout::Dimensionality dimensionalityMode)
+{
+    const auto* component = _graphModel->graph().componentById(componentId);
+    return std::make_unique<StressLayout>(*component, nodePositions,
+        dimensionalityMode, &_layoutSettings);
+}
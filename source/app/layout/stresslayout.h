@@ -0,0 +1,107 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef STRESSLAYOUT_H
+#define STRESSLAYOUT_H
+
+#include "layout.h"
+
+#include <QVector3D>
+
+#include <vector>
+
+// The component is initially placed using Pivot MDS, then refined by sparse stress
+// majorisation; in the latter, each node is only drawn towards its neighbours and a
+// small set of pivot nodes, so an iteration costs O(k(n + m)) for k pivots
+class StressLayout : public Layout
+{
+    Q_OBJECT
+
+private:
+    static constexpr size_t MAXIMUM_PIVOTS = 50;
+    static const size_t MAXIMUM_SECOND_NEIGHBOURS = 16;
+    static const int POWER_ITERATIONS = 100;
+    static const int MAXIMUM_ITERATIONS = 500;
+    const double CONVERGENCE_TOLERANCE = 0.0001;
+
+    // Compressed adjacency lists, indexed by position in nodeIds()
+    std::vector<size_t> _offsets;
+    std::vector<size_t> _adjacent;
+
+    // A sample of the nodes that are two edges away; without these terms, nodes that
+    // share all their neighbours (e.g. the leaves of a star) are drawn to the same place
+    std::vector<size_t> _secondOffsets;
+    std::vector<size_t> _secondNeighbours;
+
+    std::vector<size_t> _pivots;
+
+    // The number of edges between pivot p and node i is _pivotDistances[(p * n) + i]
+    std::vector<int> _pivotDistances;
+
+    // The number of nodes that are closer to each pivot than to any other
+    std::vector<int> _pivotRegionSizes;
+
+    std::vector<size_t> _indices;
+    std::vector<QVector3D> _positions;
+    std::vector<QVector3D> _nextPositions;
+    std::vector<double> _stresses;
+
+    bool _initialised = false;
+    bool _projectionPending = false;
+    bool _hasBeenFlattened = false;
+    bool _finished = false;
+    int _iteration = 0;
+    double _previousStress = 0.0;
+    double _relativeStressChange = 0.0;
+
+    void initialise();
+    void sampleSecondNeighbours();
+    void selectPivots();
+    void pivotMDS(Dimensionality dimensionality);
+    double majorise(Dimensionality dimensionality);
+
+public:
+    StressLayout(const IGraphComponent& graphComponent,
+                 NodeLayoutPositions& positions,
+                 Layout::Dimensionality dimensionalityMode,
+                 const LayoutSettings* settings) :
+        Layout(graphComponent, positions, settings, Iterative::Yes,
+            Dimensionality::TwoOrThreeDee, 0.4f),
+        _hasBeenFlattened(dimensionalityMode == Layout::Dimensionality::TwoDee)
+    {}
+
+    bool finished() const override { return _finished; }
+    void unfinish() override;
+    float convergence() const override;
+
+    void execute(bool firstIteration, Dimensionality dimensionality) override;
+};
+
+class StressLayoutFactory : public LayoutFactory
+{
+public:
+    explicit StressLayoutFactory(GraphModel* graphModel);
+
+    QString name() const override { return QStringLiteral("Stress"); }
+    QString displayName() const override { return QObject::tr("Stress Majorisation"); }
+    std::unique_ptr<Layout> create(ComponentId componentId, NodeLayoutPositions& nodePositions,
+        Layout::Dimensionality dimensionalityMode) override;
+};
+
+#endif // STRESSLAYOUT_H
@@ -0,0 +1,298 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binarygraphsaver.h"
+
+#include "shared/attributes/iattribute.h"
+#include "shared/graph/igraph.h"
+#include "shared/graph/igraphmodel.h"
+#include "shared/graph/imutablegraph.h"
+#include "shared/loading/binarygraphformat.h"
+
+#include <QFile>
+#include <QUrl>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+class BinaryWriter
+{
+private:
+    QFile* _file;
+    uint64_t _position = 0;
+    bool _ok = true;
+
+public:
+    explicit BinaryWriter(QFile* file) : _file(file) {}
+
+    bool ok() const { return _ok; }
+
+    void writeRaw(const void* data, size_t size)
+    {
+        if(!_ok || size == 0)
+            return;
+
+        auto numBytesWritten = _file->write(reinterpret_cast<const char*>(data), static_cast<qint64>(size));
+        _ok = (numBytesWritten == static_cast<qint64>(size));
+        _position += size;
+    }
+
+    template<typename T>
+    void write(const T& value) { writeRaw(&value, sizeof(T)); }
+
+    template<typename T>
+    void write(const std::vector<T>& values) { writeRaw(values.data(), values.size() * sizeof(T)); }
+
+    void writeStrings(const std::vector<QByteArray>& strings)
+    {
+        std::vector<uint64_t> offsets;
+        offsets.reserve(strings.size() + 1);
+
+        uint64_t offset = 0;
+        offsets.push_back(offset);
+        for(const auto& string : strings)
+        {
+            offset += static_cast<uint64_t>(string.size());
+            offsets.push_back(offset);
+        }
+
+        write(offsets);
+
+        for(const auto& string : strings)
+            writeRaw(string.constData(), static_cast<size_t>(string.size()));
+
+        align();
+    }
+
+    void align()
+    {
+        const char padding[BinaryGraph::ALIGNMENT] = {};
+        auto remainder = _position % BinaryGraph::ALIGNMENT;
+
+        if(remainder != 0)
+            writeRaw(padding, BinaryGraph::ALIGNMENT - remainder);
+    }
+};
+
+template<typename E>
+void writeColumn(BinaryWriter& writer, const QString& name,
+    const IAttribute& attribute, const std::vector<E>& elementIds)
+{
+    auto utf8Name = name.toUtf8();
+    writer.write(static_cast<uint32_t>(utf8Name.size()));
+    writer.writeRaw(utf8Name.constData(), static_cast<size_t>(utf8Name.size()));
+
+    BinaryGraph::ColumnType columnType = BinaryGraph::ColumnType::String;
+    if(attribute.valueType() == ValueType::Int)
+        columnType = BinaryGraph::ColumnType::Int;
+    else if(attribute.valueType() == ValueType::Float)
+        columnType = BinaryGraph::ColumnType::Float;
+
+    std::vector<uint8_t> missing((elementIds.size() + 7) / 8, 0);
+    bool hasMissing = false;
+
+    for(size_t i = 0; i < elementIds.size(); i++)
+    {
+        if(attribute.valueMissingOf(elementIds[i]))
+        {
+            missing[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+            hasMissing = true;
+        }
+    }
+
+    writer.write(static_cast<uint8_t>(columnType));
+    writer.write(static_cast<uint8_t>(hasMissing ? 1 : 0));
+    writer.align();
+
+    switch(columnType)
+    {
+    case BinaryGraph::ColumnType::Int:
+    {
+        std::vector<int32_t> values;
+        values.reserve(elementIds.size());
+        for(auto elementId : elementIds)
+            values.push_back(attribute.intValueOf(elementId));
+
+        writer.write(values);
+        break;
+    }
+
+    case BinaryGraph::ColumnType::Float:
+    {
+        std::vector<double> values;
+        values.reserve(elementIds.size());
+        for(auto elementId : elementIds)
+            values.push_back(attribute.floatValueOf(elementId));
+
+        writer.write(values);
+        break;
+    }
+
+    case BinaryGraph::ColumnType::String:
+    {
+        std::vector<QByteArray> values;
+        values.reserve(elementIds.size());
+        for(auto elementId : elementIds)
+            values.push_back(attribute.stringValueOf(elementId).toUtf8());
+
+        writer.writeStrings(values);
+        break;
+    }
+    }
+
+    writer.align();
+
+    if(hasMissing)
+    {
+        writer.write(missing);
+        writer.align();
+    }
+}
+
+std::vector<QString> userDefinedAttributeNames(const IGraphModel& graphModel, ElementType elementType)
+{
+    auto attributeNames = graphModel.attributeNames(elementType);
+
+    attributeNames.erase(std::remove_if(attributeNames.begin(), attributeNames.end(),
+    [&graphModel](const auto& attributeName)
+    {
+        return !graphModel.attributeByName(attributeName)->userDefined();
+    }), attributeNames.end());
+
+    return attributeNames;
+}
+} // namespace
+
+bool BinaryGraphSaver::save()
+{
+    QFile file(_url.toLocalFile());
+    if(!file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+        return false;
+
+    const auto& graph = _graphModel->graph();
+    const auto& nodeIds = graph.nodeIds();
+    const auto& edgeIds = graph.edgeIds();
+
+    auto nodeAttributeNames = userDefinedAttributeNames(*_graphModel, ElementType::Node);
+    auto edgeAttributeNames = userDefinedAttributeNames(*_graphModel, ElementType::Edge);
+
+    BinaryGraph::Header header{};
+    std::copy(std::begin(BinaryGraph::MAGIC), std::end(BinaryGraph::MAGIC), header._magic);
+    header._version = BinaryGraph::VERSION;
+    header._flags = BinaryGraph::Flags::Csr;
+    header._numNodes = nodeIds.size();
+    header._numEdges = edgeIds.size();
+    header._numNodeColumns = static_cast<uint32_t>(nodeAttributeNames.size());
+    header._numEdgeColumns = static_cast<uint32_t>(edgeAttributeNames.size());
+
+    size_t numSteps = 3 + nodeAttributeNames.size() + edgeAttributeNames.size();
+    size_t step = 0;
+    auto nextStep = [this, &step, numSteps] { setProgress(static_cast<int>((++step * 100) / numSteps)); };
+
+    BinaryWriter writer(&file);
+    writer.write(header);
+    writer.align();
+
+    _graphModel->mutableGraph().setPhase(QObject::tr("Nodes"));
+
+    // Edges refer to nodes by their index in the node table
+    std::vector<uint32_t> nodeIndices(static_cast<size_t>(static_cast<int>(graph.nextNodeId())), 0);
+    std::vector<int32_t> nodeIdValues;
+    std::vector<QByteArray> nodeNames;
+    nodeIdValues.reserve(nodeIds.size());
+    nodeNames.reserve(nodeIds.size());
+
+    for(size_t i = 0; i < nodeIds.size(); i++)
+    {
+        auto nodeId = nodeIds[i];
+        nodeIndices[static_cast<size_t>(static_cast<int>(nodeId))] = static_cast<uint32_t>(i);
+        nodeIdValues.push_back(static_cast<int32_t>(nodeId));
+        nodeNames.push_back(_graphModel->nodeName(nodeId).toUtf8());
+    }
+
+    writer.write(nodeIdValues);
+    writer.align();
+    nextStep();
+
+    if(cancelled())
+        return false;
+
+    _graphModel->mutableGraph().setPhase(QObject::tr("Edges"));
+
+    std::vector<uint32_t> sources;
+    std::vector<uint32_t> targets;
+    std::vector<uint64_t> csrOffsets(nodeIds.size() + 1, 0);
+    sources.reserve(edgeIds.size());
+    targets.reserve(edgeIds.size());
+
+    for(auto edgeId : edgeIds)
+    {
+        const auto& edge = graph.edgeById(edgeId);
+        auto sourceIndex = nodeIndices[static_cast<size_t>(static_cast<int>(edge.sourceId()))];
+        sources.push_back(sourceIndex);
+        targets.push_back(nodeIndices[static_cast<size_t>(static_cast<int>(edge.targetId()))]);
+        csrOffsets[sourceIndex + 1]++;
+    }
+
+    writer.write(sources);
+    writer.align();
+    writer.write(targets);
+    writer.align();
+    writer.writeStrings(nodeNames);
+    nextStep();
+
+    _graphModel->mutableGraph().setPhase(QObject::tr("Attributes"));
+
+    for(const auto& attributeName : nodeAttributeNames)
+    {
+        if(cancelled())
+            return false;
+
+        writeColumn(writer, attributeName, *_graphModel->attributeByName(attributeName), nodeIds);
+        nextStep();
+    }
+
+    for(const auto& attributeName : edgeAttributeNames)
+    {
+        if(cancelled())
+            return false;
+
+        writeColumn(writer, attributeName, *_graphModel->attributeByName(attributeName), edgeIds);
+        nextStep();
+    }
+
+    // Out edges of each node, for consumers that want to traverse without building
+    // their own adjacency structure
+    std::partial_sum(csrOffsets.begin(), csrOffsets.end(), csrOffsets.begin());
+
+    std::vector<uint32_t> csrEdges(edgeIds.size());
+    auto csrInsertPositions = csrOffsets;
+    for(size_t i = 0; i < sources.size(); i++)
+        csrEdges[csrInsertPositions[sources[i]]++] = static_cast<uint32_t>(i);
+
+    writer.write(csrOffsets);
+    writer.align();
+    writer.write(csrEdges);
+    writer.align();
+    nextStep();
+
+    return writer.ok();
+}
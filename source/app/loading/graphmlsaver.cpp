@@ -112,6 +112,8 @@ bool GraphMLSaver::save()
         keyId++;
     }
 
+    // The renderer may not have taken the layout's latest positions, if it isn't drawing
+    graphModel->nodePositions().acquire();
     std::unique_lock<NodePositions> lock(graphModel->nodePositions());
 
     _graphModel->mutableGraph().setPhase(QObject::tr("Nodes"));
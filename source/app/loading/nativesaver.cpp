@@ -190,6 +190,8 @@ bool NativeSaver::save()
     layout["algorithm"] = _document->layoutName();
     layout["settings"] = layoutSettingsAsJson(*_document);
 
+    // The renderer may not have taken the layout's latest positions, if it isn't drawing
+    graphModel->nodePositions().acquire();
     layout["positions"] = u::graphArrayAsJson(graphModel->nodePositions(), graphModel->mutableGraph().nodeIds(), this,
     [](const auto& v)
     {
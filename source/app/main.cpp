@@ -37,6 +37,7 @@
 #include <QSettings>
 
 #include <iostream>
+#include <thread>
 
 #include "application.h"
 #include "limitconstants.h"
@@ -193,7 +194,10 @@ int start(int argc, char *argv[])
 
     qRegisterMetaType<size_t>("size_t");
 
-    ThreadPoolSingleton threadPool;
+    // Fixing the number of worker threads is useful for checking that results don't depend on it
+    const int numWorkerThreads = qEnvironmentVariableIntValue("WORKER_THREADS");
+    ThreadPoolSingleton threadPool(QStringLiteral("Worker"), numWorkerThreads > 0 ?
+        static_cast<unsigned int>(numWorkerThreads) : std::thread::hardware_concurrency());
     ScopeTimerManager scopeTimerManager;
 
     //FIXME: Eventually remove this
@@ -225,6 +229,10 @@ int start(int argc, char *argv[])
     u::definePref(QStringLiteral("visuals/minimumComponentRadius"),         2.0);
     u::definePref(QStringLiteral("visuals/transitionTime"),                 1.0);
 
+    u::definePref(QStringLiteral("layout/algorithm"),                       "ForceDirected");
+    u::definePref(QStringLiteral("layout/deterministic"),                   false);
+    u::definePref(QStringLiteral("layout/seed"),                            0);
+
     u::definePref(QStringLiteral("misc/maxUndoLevels"),                     25);
 
     u::definePref(QStringLiteral("misc/showGraphMetrics"),                  false);
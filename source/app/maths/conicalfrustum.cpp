@@ -20,6 +20,8 @@
 
 #include "shared/utils/utils.h"
 
+#include <algorithm>
+
 ConicalFrustum::ConicalFrustum(const Line3D& centreLine, const Line3D& surfaceLine) :
     _centreLine(centreLine)
 {
@@ -47,3 +49,15 @@ bool ConicalFrustum::containsPoint(const QVector3D& point) const
 
     return distanceToCentreLine < testRadius;
 }
+
+bool ConicalFrustum::intersectsSphere(const QVector3D& centre, float radius) const
+{
+    if(_nearPlane.distanceToPoint(centre) < -radius ||
+       _farPlane.distanceToPoint(centre) < -radius)
+        return false;
+
+    float distanceToCentreLine = centre.distanceToLine(_centreLine.start(),
+        (_centreLine.end() - _centreLine.start()).normalized());
+
+    return distanceToCentreLine <= std::max(_nearRadius, _farRadius) + radius;
+}
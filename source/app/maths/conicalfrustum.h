@@ -40,6 +40,7 @@ public:
     ConicalFrustum(const Line3D &centreLine, const Line3D& surfaceLine);
 
     bool containsPoint(const QVector3D& point) const override;
+    bool intersectsSphere(const QVector3D& centre, float radius) const override;
     Line3D centreLine() const override { return _centreLine; }
 };
 
@@ -42,6 +42,18 @@ bool Frustum::containsPoint(const QVector3D& point) const
     return true;
 }
 
+bool Frustum::intersectsSphere(const QVector3D& centre, float radius) const
+{
+    for(const auto& plane : _planes)
+    {
+        // Entirely in front of any one plane means entirely outside
+        if(plane.distanceToPoint(centre) < -radius)
+            return false;
+    }
+
+    return true;
+}
+
 bool BaseFrustum::containsLine(const Line3D& line) const
 {
     return containsPoint(line.start()) && containsPoint(line.end());
@@ -34,6 +34,9 @@ public:
     virtual bool containsPoint(const QVector3D& point) const = 0;
     bool containsLine(const Line3D& line) const;
 
+    // Conservative; may return true for spheres that are outside but close to the frustum
+    virtual bool intersectsSphere(const QVector3D& centre, float radius) const = 0;
+
     virtual Line3D centreLine() const = 0;
 };
 
@@ -47,6 +50,8 @@ public:
     Frustum(const Line3D& line1, const Line3D& line2, const Line3D& line3, const Line3D& line4);
 
     bool containsPoint(const QVector3D& point) const override;
+    bool intersectsSphere(const QVector3D& centre, float radius) const override;
+
     Line3D centreLine() const override { return _centreLine; }
 };
 
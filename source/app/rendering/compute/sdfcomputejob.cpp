@@ -26,9 +26,11 @@
 #include <QTime>
 #include <QDir>
 
-SDFComputeJob::SDFComputeJob(DoubleBufferedTexture* sdfTexture, GlyphMap* glyphMap) :
+SDFComputeJob::SDFComputeJob(DoubleBufferedTexture* sdfTexture, GlyphMap* glyphMap,
+    LayerVersions* layerVersions) :
     _sdfTexture(sdfTexture),
-    _glyphMap(glyphMap)
+    _glyphMap(glyphMap),
+    _layerVersions(layerVersions)
 {}
 
 void SDFComputeJob::run()
@@ -149,22 +151,36 @@ void SDFComputeJob::generateSDF()
     // SDF texture
     glBindTexture(GL_TEXTURE_2D_ARRAY, sdfTexture);
 
-    // Generate FBO texture
-    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA,
-                 renderWidth, renderHeight, numImages,
-                 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    // Layers that haven't changed since this texture was last generated are left alone,
+    // unless the texture needs to grow, in which case its contents are lost anyway
+    const auto& layerVersions = _glyphMap->layerVersions();
+    auto& generatedLayerVersions = (*_layerVersions)[sdfTexture];
 
-    // Set initial filtering and wrapping properties (filteiring will be changed to linear later)
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    if(static_cast<int>(generatedLayerVersions.size()) != numImages)
+    {
+        // Generate FBO texture
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA,
+                     renderWidth, renderHeight, numImages,
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        // Set initial filtering and wrapping properties (filteiring will be changed to linear later)
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        generatedLayerVersions.assign(static_cast<size_t>(numImages), 0);
+    }
 
     GLuint glyphTexture = 0;
 
     // Draw SDF texture for each layer of atlas layer
     for(int layer = 0; layer < numImages; ++layer)
     {
+        auto layerVersion = layerVersions.at(static_cast<size_t>(layer));
+        if(generatedLayerVersions.at(static_cast<size_t>(layer)) == layerVersion)
+            continue;
+
         // Can only render to one texture layer per draw call :(
         glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, sdfTexture, 0, layer);
 
@@ -195,6 +211,8 @@ void SDFComputeJob::generateSDF()
         sdfShader.setUniformValue("texSize", QPoint(sourceWidth, sourceHeight));
 
         glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        generatedLayerVersions.at(static_cast<size_t>(layer)) = layerVersion;
     }
 
     glFlush();
@@ -29,12 +29,20 @@
 #include <QOpenGLBuffer>
 
 #include <functional>
+#include <map>
+#include <vector>
+#include <cstdint>
 
 class SDFComputeJob : public GPUComputeJob
 {
+public:
+    // For each SDF texture, the GlyphMap::layerVersions it was last generated from
+    using LayerVersions = std::map<GLuint, std::vector<uint64_t>>;
+
 private:
     DoubleBufferedTexture* _sdfTexture;
     GlyphMap* _glyphMap;
+    LayerVersions* _layerVersions;
 
     std::function<void()> _onCompleteFn;
 
@@ -42,7 +50,7 @@ private:
     void generateSDF();
 
 public:
-    SDFComputeJob(DoubleBufferedTexture* sdfTexture, GlyphMap *glyphMap);
+    SDFComputeJob(DoubleBufferedTexture* sdfTexture, GlyphMap *glyphMap, LayerVersions* layerVersions);
 
     void run() override;
     void executeWhenComplete(std::function<void()> onCompleteFn);
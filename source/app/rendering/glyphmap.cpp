@@ -20,6 +20,7 @@
 
 #include "shared/utils/container.h"
 #include "shared/utils/preferences.h"
+#include "shared/utils/threadpool.h"
 
 #include <QTextLayout>
 #include <QPainter>
@@ -29,6 +30,7 @@
 #include <QPainterPath>
 
 #include <memory>
+#include <cmath>
 
 GlyphMap::GlyphMap(QString fontName) :
     _fontName(std::move(fontName))
@@ -101,8 +103,8 @@ void GlyphMap::setFontName(const QString& fontName)
 {
     std::unique_lock<std::recursive_mutex> lock(_mutex);
 
-    if(_fontName != fontName && _updateTypeRequired < UpdateType::Images)
-        _updateTypeRequired = UpdateType::Images;
+    if(_fontName != fontName && _updateTypeRequired < UpdateType::All)
+        _updateTypeRequired = UpdateType::All;
 
     _fontName = fontName;
 }
@@ -111,7 +113,7 @@ void GlyphMap::layoutStrings(const QFont& font)
 {
     QFontMetrics fontMetrics(font);
 
-    bool relayoutAllStrings = (_updateTypeRequired >= UpdateType::Images);
+    bool relayoutAllStrings = (_updateTypeRequired >= UpdateType::All);
 
     if(relayoutAllStrings)
         _results._glyphs.clear();
@@ -163,8 +165,9 @@ void GlyphMap::layoutStrings(const QFont& font)
                 {
                     _results._glyphs[glyph._index] = {};
 
-                    // New glyphs, so new images need to be generated
-                    _updateTypeRequired = UpdateType::Images;
+                    // New glyphs, so they need to be rendered
+                    if(_updateTypeRequired < UpdateType::Glyphs)
+                        _updateTypeRequired = UpdateType::Glyphs;
                 }
             }
         }
@@ -191,77 +194,149 @@ bool GlyphMap::stringsAreRenderable(const QFont &font) const
 
 void GlyphMap::renderImages(const QFont &font)
 {
-    if(_results._glyphs.empty() || _updateTypeRequired < UpdateType::Images)
+    if(_results._glyphs.empty() || _updateTypeRequired < UpdateType::Glyphs)
         return;
 
-    auto rawFont = QRawFont::fromFont(font);
+    float padding = std::max(static_cast<float>(QFontMetrics(font).height()) * 0.1f, 1.0f);
 
-    _images.clear();
+    if(_updateTypeRequired >= UpdateType::All)
+    {
+        // Start again from an empty atlas
+        _images.clear();
+        _layerVersions.clear();
+        _packLayer = 0;
+        _packX = padding;
+        _packY = padding;
+        _packRowHeight = 0.0f;
+    }
 
-    // Render Glyphs
-    float maxGlyphHeight = 0.0f;
-    float padding = std::max(static_cast<float>(QFontMetrics(font).height()) * 0.1f, 1.0f);
-    float x = padding;
-    float y = padding;
-    int layer = 0;
+    auto rawFont = QRawFont::fromFont(font);
+    _version++;
 
-    std::unique_ptr<QPainter> textPainter;
+    struct NewGlyph
+    {
+        quint32 _index = 0;
+        QPainterPath _path;
+        int _layer = 0;
+        QPoint _origin;
+        QImage _image;
+    };
+
+    std::vector<NewGlyph> newGlyphs;
 
+    // Find space for the glyphs that haven't been rendered yet, leaving any that have where they are
     for(auto& glyphPair : _results._glyphs)
     {
+        if(glyphPair.second._layer >= 0)
+            continue;
+
         auto glyph = glyphPair.first;
         auto path = rawFont.pathForGlyph(glyph);
         auto boundingRect = path.boundingRect();
         auto glyphWidth = static_cast<float>(boundingRect.x() + boundingRect.width());
-        float glyphAscent = boundingRect.y();
-        float glyphHeight = boundingRect.height();
-        float right = x + glyphWidth + padding;
-
-        maxGlyphHeight = std::max(glyphHeight, maxGlyphHeight);
+        auto glyphAscent = static_cast<float>(boundingRect.y());
+        auto glyphHeight = static_cast<float>(boundingRect.height());
+        float right = _packX + glyphWidth + padding;
 
         if(right >= static_cast<float>(_textureSize))
         {
             // Move down onto a new row
-            y += maxGlyphHeight + padding;
-            x = padding;
-            maxGlyphHeight = glyphHeight;
+            _packY += _packRowHeight + padding;
+            _packX = padding;
+            _packRowHeight = 0.0f;
+        }
 
-            float bottom = y + maxGlyphHeight + padding;
+        float bottom = _packY + glyphHeight + padding;
 
-            if(bottom >= static_cast<float>(_textureSize))
+        if(bottom >= static_cast<float>(_textureSize) || _images.empty())
+        {
+            if(!_images.empty())
             {
                 // Spill onto a new image
-                textPainter = nullptr;
-                layer++;
+                _packLayer++;
+                _packX = padding;
+                _packY = padding;
+                _packRowHeight = 0.0f;
             }
-        }
 
-        if(textPainter == nullptr)
-        {
             _images.emplace_back(_textureSize, _textureSize, QImage::Format_ARGB32);
-            auto& image = _images.back();
+            _images.back().fill(Qt::transparent);
+            _layerVersions.push_back(_version);
+        }
+
+        _packRowHeight = std::max(glyphHeight, _packRowHeight);
+
+        auto& image = _images.at(static_cast<size_t>(_packLayer));
+        _layerVersions.at(static_cast<size_t>(_packLayer)) = _version;
+
+        // Render into a small image of its own, aligned to the atlas' pixels
+        auto originX = std::floor(_packX);
+        auto originY = std::floor(_packY);
+        path.translate(_packX - originX, (_packY - originY) - glyphAscent);
+
+        NewGlyph newGlyph;
+        newGlyph._index = glyph;
+        newGlyph._path = path;
+        newGlyph._layer = _packLayer;
+        newGlyph._origin = QPoint(static_cast<int>(originX), static_cast<int>(originY));
+        newGlyph._image = QImage(static_cast<int>(std::ceil(glyphWidth)) + 2,
+            static_cast<int>(std::ceil(glyphHeight)) + 2, QImage::Format_ARGB32);
+        newGlyphs.push_back(newGlyph);
+
+        float u = _packX / static_cast<float>(image.width());
+        float v = (_packY + glyphHeight) / static_cast<float>(image.height());
+        float w = glyphWidth / static_cast<float>(image.width());
+        float h = glyphHeight / static_cast<float>(image.height());
+        float a = glyphAscent / static_cast<float>(image.height());
+
+        auto& textureGlyph = glyphPair.second;
+        textureGlyph._layer = _packLayer;
+        textureGlyph._u = u;
+        textureGlyph._v = v;
+        textureGlyph._width = w;
+        textureGlyph._height = h;
+        textureGlyph._ascent = a;
+
+        _packX += glyphWidth + padding;
+    }
+
+    if(newGlyphs.empty())
+        return;
+
+    // Rasterise the glyphs in parallel...
+    concurrent_for(newGlyphs.begin(), newGlyphs.end(),
+    [](std::vector<NewGlyph>::iterator newGlyph)
+    {
+        newGlyph->_image.fill(Qt::transparent);
 
-            image.fill(Qt::transparent);
+        QPainter painter(&newGlyph->_image);
+        painter.fillPath(newGlyph->_path, QBrush(Qt::white));
+    });
 
-            textPainter = std::make_unique<QPainter>(&image);
-            textPainter->setFont(font);
-            textPainter->setPen(Qt::white);
+    // ...then copy them into the atlas
+    std::unique_ptr<QPainter> textPainter;
+    int painterLayer = -1;
 
-            // Reset paint coordinates
-            x = padding;
-            y = padding;
+    for(const auto& newGlyph : newGlyphs)
+    {
+        if(newGlyph._layer != painterLayer)
+        {
+            textPainter = std::make_unique<QPainter>(&_images.at(static_cast<size_t>(newGlyph._layer)));
+            painterLayer = newGlyph._layer;
         }
 
-        path.translate(x, y - glyphAscent);
-        textPainter->fillPath(path, QBrush(Qt::white));
+        textPainter->drawImage(newGlyph._origin, newGlyph._image);
 
         if(u::pref("debug/saveGlyphMaps").toBool())
         {
-            auto xi = static_cast<int>(x);
-            auto yi = static_cast<int>(y);
-            auto wi = static_cast<int>(glyphWidth);
-            auto hi = static_cast<int>(glyphHeight);
-            auto ai = static_cast<int>(glyphAscent);
+            const auto& textureGlyph = _results._glyphs.at(newGlyph._index);
+            const auto& image = _images.at(static_cast<size_t>(newGlyph._layer));
+
+            auto xi = static_cast<int>(textureGlyph._u * static_cast<float>(image.width()));
+            auto hi = static_cast<int>(textureGlyph._height * static_cast<float>(image.height()));
+            auto yi = static_cast<int>(textureGlyph._v * static_cast<float>(image.height())) - hi;
+            auto wi = static_cast<int>(textureGlyph._width * static_cast<float>(image.width()));
+            auto ai = static_cast<int>(textureGlyph._ascent * static_cast<float>(image.height()));
 
             textPainter->setPen(Qt::red);
             textPainter->drawLine(xi,      yi,      xi,      yi + hi);
@@ -274,26 +349,10 @@ void GlyphMap::renderImages(const QFont &font)
             textPainter->drawLine(xi + wi, yi,      xi + wi, yi + hi);
             textPainter->drawLine(xi,      yi + hi, xi + wi, yi + hi);
         }
-
-        auto& image = _images.back();
-
-        float u = x / static_cast<float>(image.width());
-        float v = (y + glyphHeight) / static_cast<float>(image.height());
-        float w = glyphWidth / static_cast<float>(image.width());
-        float h = glyphHeight / static_cast<float>(image.height());
-        float a = glyphAscent / static_cast<float>(image.height());
-
-        auto& textureGlyph = _results._glyphs[glyph];
-        textureGlyph._layer = layer;
-        textureGlyph._u = u;
-        textureGlyph._v = v;
-        textureGlyph._width = w;
-        textureGlyph._height = h;
-        textureGlyph._ascent = a;
-
-        x += glyphWidth + padding;
     }
 
+    textPainter = nullptr;
+
     // Save Glyphmap for debug purposes if needed
     if(u::pref("debug/saveGlyphMaps").toBool())
     {
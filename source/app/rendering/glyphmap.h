@@ -26,8 +26,10 @@
 #include <QGlyphRun>
 #include <QFontMetrics>
 
+#include <cstdint>
 #include <map>
 #include <mutex>
+#include <vector>
 
 class GlyphMap
 {
@@ -68,6 +70,18 @@ public:
 private:
     std::vector<QImage> _images;
 
+    // Incremented whenever anything is rendered, so that consumers of the
+    // images can tell which layers have changed since they last looked
+    uint64_t _version = 0;
+    std::vector<uint64_t> _layerVersions;
+
+    // Where in the images the next glyph will be placed; glyphs are packed into
+    // rows, left to right, and new glyphs only ever go into the remaining space
+    int _packLayer = 0;
+    float _packX = 0.0f;
+    float _packY = 0.0f;
+    float _packRowHeight = 0.0f;
+
     Results _results;
 
     QString _fontName;
@@ -78,10 +92,11 @@ private:
     {
         None,
         Layout,
-        Images
+        Glyphs,
+        All
     };
 
-    UpdateType _updateTypeRequired = UpdateType::Images;
+    UpdateType _updateTypeRequired = UpdateType::All;
 
     mutable std::recursive_mutex _mutex;
 
@@ -95,6 +110,9 @@ public:
 
     const std::vector<QImage>& images() const;
 
+    // For each image, a value that increases whenever the image changes
+    const std::vector<uint64_t>& layerVersions() const { return _layerVersions; }
+
     void setTextureSize(int textureSize);
 
     void setFontName(const QString& fontName);
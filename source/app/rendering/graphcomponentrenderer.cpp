@@ -38,6 +38,7 @@
 
 #include "shared/graph/elementid_debug.h"
 #include "shared/utils/preferences.h"
+#include "shared/utils/threadpool.h"
 
 #include "limitconstants.h"
 
@@ -49,9 +50,19 @@
 #include <cmath>
 #include <mutex>
 #include <algorithm>
+#include <limits>
 
 const float GraphComponentRenderer::MINIMUM_ZOOM_DISTANCE = LimitConstants::maximumNodeSize() + 0.5f;
 const float GraphComponentRenderer::COMFORTABLE_ZOOM_RADIUS = MINIMUM_ZOOM_DISTANCE * 2.0f;
+const int GraphComponentRenderer::LOD_MINIMUM_NODES = 50000;
+const float GraphComponentRenderer::LOD_AGGREGATE_PIXEL_RADIUS = 4.0f;
+const int GraphComponentRenderer::LOD_REFITS_PER_REBUILD = 50;
+
+namespace
+{
+// The value of _lodAggregateIndices for nodes that are outside the view frustum
+const int LODCulled = -2;
+} // namespace
 
 void GraphComponentRenderer::initialise(GraphModel* graphModel, ComponentId componentId,
                                         SelectionManager* selectionManager,
@@ -106,6 +117,7 @@ void GraphComponentRenderer::cleanup()
 
     _nodeIds.clear();
     _edges.clear();
+    resetLOD();
 
     _graphModel = nullptr;
     _componentId.setToNull();
@@ -129,6 +141,7 @@ void GraphComponentRenderer::synchronise()
 
     _nodeIds.clear();
     _edges.clear();
+    resetLOD();
 
     const auto* component = _graphModel->graph().componentById(_componentId);
     Q_ASSERT(component != nullptr);
@@ -148,6 +161,201 @@ void GraphComponentRenderer::synchronise()
     });
 }
 
+void GraphComponentRenderer::resetLOD()
+{
+    _lodNodePositions.reset();
+    _lodTree.reset();
+    _lodRefitCount = 0;
+    _lodNodeIds.clear();
+    _lodAggregates.clear();
+    _lodCulledSubTrees.clear();
+    _lodAggregateIndices.reset();
+    _lodFrustum.reset();
+}
+
+float GraphComponentRenderer::projectedRadius(const QVector3D& centre, float radius,
+    const QMatrix4x4& modelViewMatrix, const QMatrix4x4& projectionMatrix) const
+{
+    auto viewCentre = modelViewMatrix.map(centre);
+
+    // The camera is inside the region
+    if(viewCentre.length() <= radius)
+        return std::numeric_limits<float>::max();
+
+    auto a = projectionMatrix * QVector4D(viewCentre, 1.0f);
+    auto b = projectionMatrix * QVector4D(viewCentre + QVector3D(radius, 0.0f, 0.0f), 1.0f);
+
+    // The region is behind the camera
+    if(a.w() <= 0.0f || b.w() <= 0.0f)
+        return 0.0f;
+
+    return std::abs((a.x() / a.w()) - (b.x() / b.w())) * 0.5f * static_cast<float>(_viewportWidth);
+}
+
+bool GraphComponentRenderer::updateLOD()
+{
+    if(_frozen)
+        return false;
+
+    if(!_initialised || static_cast<int>(_nodeIds.size()) < LOD_MINIMUM_NODES ||
+        !_viewData.camera().valid())
+    {
+        bool wasActive = lodActive();
+        resetLOD();
+        return wasActive;
+    }
+
+    const auto& nodePositions = _graphModel->nodePositions();
+    bool rebuilt = false;
+
+    if(_lodTree == nullptr || _lodTreeEpoch != nodePositions.epoch())
+    {
+        if(_lodNodePositions == nullptr)
+            _lodNodePositions = std::make_unique<ExactNodePositions>(_graphModel->graph());
+
+        concurrent_for(_nodeIds.begin(), _nodeIds.end(),
+        [this, &nodePositions](NodeId nodeId)
+        {
+            _lodNodePositions->set(nodeId, nodePositions.getWhileLocked(nodeId));
+        });
+
+        // While the layout is running, the existing tree is mostly just refitted to
+        // the new positions, as rebuilding it every time would invalidate every aggregate
+        if(_lodTree == nullptr || _lodRefitCount >= LOD_REFITS_PER_REBUILD)
+        {
+            const auto& firstPosition = _lodNodePositions->get(_nodeIds.front());
+            BoundingBox3D boundingBox(firstPosition, firstPosition);
+            for(auto nodeId : _nodeIds)
+                boundingBox.expandToInclude(_lodNodePositions->get(nodeId));
+
+            _lodTree = std::make_unique<LODTree>();
+            _lodTree->build(_nodeIds, *_lodNodePositions, boundingBox);
+            _lodRefitCount = 0;
+            rebuilt = true;
+        }
+        else
+        {
+            _lodTree->refit(*_lodNodePositions);
+            _lodRefitCount++;
+        }
+
+        _lodTreeEpoch = nodePositions.epoch();
+    }
+
+    auto modelView = modelViewMatrix();
+    auto projection = projectionMatrix();
+    _lodFrustum = _viewData.camera().frustumForViewportCoordinates(0, 0, width(), height());
+
+    std::vector<NodeId> nodeIds;
+    std::vector<const LODTree*> aggregates;
+    std::vector<const LODTree*> culledSubTrees;
+
+    _lodTree->cut([&](const LODTree& subTree)
+    {
+        if(!lodVisible(subTree.centre(), subTree.radius()))
+        {
+            culledSubTrees.push_back(&subTree);
+            return true;
+        }
+
+        if(projectedRadius(subTree.centre(), subTree.radius(), modelView, projection) >= LOD_AGGREGATE_PIXEL_RADIUS)
+            return false;
+
+        aggregates.push_back(&subTree);
+        return true;
+    },
+    [&nodeIds](NodeId nodeId) { nodeIds.push_back(nodeId); });
+
+    bool changed = aggregates != _lodAggregates || culledSubTrees != _lodCulledSubTrees;
+
+    _lodNodeIds = std::move(nodeIds);
+    _lodAggregates = std::move(aggregates);
+    _lodCulledSubTrees = std::move(culledSubTrees);
+
+    if(rebuilt)
+    {
+        // The sub trees of a rebuilt tree are all new, so instead
+        // compare which aggregate (if any) each node now belongs to
+        auto previousAggregateIndices = std::move(_lodAggregateIndices);
+        updateLODAggregateIndices();
+
+        return !std::all_of(_nodeIds.begin(), _nodeIds.end(),
+        [this, &previousAggregateIndices](NodeId nodeId)
+        {
+            auto previousAggregateIndex = previousAggregateIndices != nullptr ?
+                previousAggregateIndices->get(nodeId) : -1;
+
+            return _lodAggregateIndices->get(nodeId) == previousAggregateIndex;
+        });
+    }
+
+    if(!changed)
+        return false;
+
+    updateLODAggregateIndices();
+
+    return true;
+}
+
+void GraphComponentRenderer::updateLODAggregateIndices()
+{
+    if(_lodAggregateIndices == nullptr)
+        _lodAggregateIndices = std::make_unique<NodeArray<int>>(_graphModel->graph(), -1);
+
+    for(auto nodeId : _lodNodeIds)
+        _lodAggregateIndices->set(nodeId, -1);
+
+    if(!_lodAggregates.empty())
+    {
+        concurrent_for(_lodAggregates.begin(), _lodAggregates.end(),
+        [this](std::vector<const LODTree*>::const_iterator it)
+        {
+            auto aggregateIndex = static_cast<int>(std::distance(_lodAggregates.cbegin(), it));
+            (*it)->forEachNodeId([this, aggregateIndex](NodeId nodeId)
+            {
+                _lodAggregateIndices->set(nodeId, aggregateIndex);
+            });
+        });
+    }
+
+    if(!_lodCulledSubTrees.empty())
+    {
+        concurrent_for(_lodCulledSubTrees.begin(), _lodCulledSubTrees.end(),
+        [this](const LODTree* subTree)
+        {
+            subTree->forEachNodeId([this](NodeId nodeId)
+            {
+                _lodAggregateIndices->set(nodeId, LODCulled);
+            });
+        });
+    }
+}
+
+int GraphComponentRenderer::lodAggregateIndexOf(NodeId nodeId) const
+{
+    if(_lodAggregateIndices == nullptr)
+        return -1;
+
+    return std::max(_lodAggregateIndices->get(nodeId), -1);
+}
+
+bool GraphComponentRenderer::lodCulled(NodeId nodeId) const
+{
+    if(_lodAggregateIndices == nullptr)
+        return false;
+
+    return _lodAggregateIndices->get(nodeId) == LODCulled;
+}
+
+bool GraphComponentRenderer::lodVisible(const QVector3D& centre, float radius) const
+{
+    if(!_lodFrustum)
+        return true;
+
+    // Allow for the nodes themselves, which are centred at their positions
+    return _lodFrustum->intersectsSphere(centre, radius + LimitConstants::maximumNodeSize());
+}
+
 void GraphComponentRenderer::cloneViewDataFrom(const GraphComponentRenderer& other)
 {
     _viewData = other._viewData;
@@ -23,6 +23,8 @@
 #include "transition.h"
 #include "projection.h"
 
+#include "lodtree.h"
+
 #include "maths/boundingbox.h"
 
 #include "shared/graph/igraph.h"
@@ -34,7 +36,9 @@
 #include <QColor>
 #include <QRect>
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <vector>
 
 class GraphRenderer;
@@ -49,6 +53,15 @@ public:
     static const float MINIMUM_ZOOM_DISTANCE;
     static const float COMFORTABLE_ZOOM_RADIUS;
 
+    // Components with fewer nodes than this are always drawn in full
+    static const int LOD_MINIMUM_NODES;
+
+    // Regions whose projected radius is smaller than this are drawn as aggregates
+    static const float LOD_AGGREGATE_PIXEL_RADIUS;
+
+    // The number of times the LOD tree is refitted to new positions before it is rebuilt
+    static const int LOD_REFITS_PER_REBUILD;
+
     struct CameraAndLighting
     {
         Camera _camera;
@@ -107,6 +120,26 @@ public:
 
     bool focusedOnNodeAtRadius(NodeId nodeId, float radius) const;
 
+    // Requires the NodePositions lock to be held; returns true if the set of
+    // nodes and aggregates that should be drawn has changed
+    bool updateLOD();
+    bool lodActive() const { return _lodTree != nullptr; }
+
+    // When LOD is active, the nodes that should be drawn individually...
+    const std::vector<NodeId>& lodNodeIds() const { return _lodNodeIds; }
+
+    // ...and the regions that should each be drawn as a single aggregate
+    const std::vector<const LODTree*>& lodAggregates() const { return _lodAggregates; }
+
+    // The index into lodAggregates of the aggregate that contains nodeId, or -1
+    int lodAggregateIndexOf(NodeId nodeId) const;
+
+    // True if nodeId is in a region that is entirely outside the view frustum
+    bool lodCulled(NodeId nodeId) const;
+
+    // True if a sphere might be visible, i.e. is not entirely outside the view frustum
+    bool lodVisible(const QVector3D& centre, float radius) const;
+
     bool trackingCentreOfComponent() const;
 
     void resetView();
@@ -196,6 +229,21 @@ private:
     float _fovx = 0.0f;
     float _fovy = 0.0f;
 
+    std::unique_ptr<ExactNodePositions> _lodNodePositions;
+    std::unique_ptr<LODTree> _lodTree;
+    uint64_t _lodTreeEpoch = 0;
+    int _lodRefitCount = 0;
+    std::vector<NodeId> _lodNodeIds;
+    std::vector<const LODTree*> _lodAggregates;
+    std::vector<const LODTree*> _lodCulledSubTrees;
+    std::unique_ptr<NodeArray<int>> _lodAggregateIndices;
+    std::optional<Frustum> _lodFrustum;
+
+    void resetLOD();
+    void updateLODAggregateIndices();
+    float projectedRadius(const QVector3D& centre, float radius,
+        const QMatrix4x4& modelViewMatrix, const QMatrix4x4& projectionMatrix) const;
+
     float _entireComponentZoomDistance = 0.0f;
     float _orthoCameraDistance = 0.0f;
     float _maxDistanceFromFocus = 0.0f;
@@ -23,6 +23,7 @@
 #include "graphoverviewscene.h"
 #include "compute/sdfcomputejob.h"
 #include "shared/utils/preferences.h"
+#include "shared/utils/threadpool.h"
 
 #include "graph/graph.h"
 #include "graph/graphmodel.h"
@@ -47,6 +48,9 @@
 #include <QTextLayout>
 #include <QBuffer>
 
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
 #include <utility>
 
 template<typename Target>
@@ -119,9 +123,11 @@ GraphRenderer::GraphRenderer(GraphModel* graphModel,
         disableSceneUpdate();
     });
 
-    connect(_graphModel, &GraphModel::visualsChanged, [this]
+    connect(_graphModel, &GraphModel::visualsChanged, [this](VisualChangeFlags change)
     {
-        updateText();
+        // There is no new text to lay out if only the element states have changed
+        if(change != VisualChangeFlags::State)
+            updateText();
 
         executeOnRendererThread([this]
         {
@@ -150,12 +156,13 @@ GraphRenderer::~GraphRenderer()
 }
 
 void GraphRenderer::createGPUGlyphData(const QString& text, const QColor& textColor, const TextAlignment& textAlignment,
-                                    float textScale, float elementSize, const QVector3D& elementPosition,
+                                    float textScale, float elementSize, std::pair<NodeId, NodeId> anchor,
                                     int componentIndex, GPUGraphData* gpuGraphData)
 {
     Q_ASSERT(gpuGraphData != nullptr);
 
     auto& textLayout = _textLayoutResults._layouts[text];
+    auto& glyphAnchors = _gpuGraphElements[gpuGraphData]._glyphAnchors;
 
     auto verticalCentre = -textLayout._xHeight * textScale * 0.5f;
     auto top = elementSize;
@@ -193,35 +200,84 @@ void GraphRenderer::createGPUGlyphData(const QString& text, const QColor& textCo
         glyphData._textureCoord[1] = textureGlyph._v;
         glyphData._textureLayer = textureGlyph._layer;
 
-        glyphData._basePosition[0] = elementPosition.x();
-        glyphData._basePosition[1] = elementPosition.y();
-        glyphData._basePosition[2] = elementPosition.z();
+        // _basePosition is filled in by updateGPUPositionData
 
         glyphData._color[0] = textColor.redF();
         glyphData._color[1] = textColor.greenF();
         glyphData._color[2] = textColor.blueF();
 
         gpuGraphData->_glyphData.push_back(glyphData);
+        glyphAnchors.push_back(anchor);
     }
 }
 
-void GraphRenderer::updateGPUDataIfRequired()
+namespace
+{
+template<typename T, typename Fn>
+void concurrentForEachIndex(const std::vector<T>& elements, Fn&& fn)
 {
-    if(!_gpuDataRequiresUpdate)
+    // concurrent_for doesn't accept an empty range
+    if(elements.empty())
         return;
 
-    _gpuDataRequiresUpdate = false;
+    concurrent_for(elements.begin(), elements.end(),
+    [&elements, &fn](typename std::vector<T>::const_iterator it)
+    {
+        fn(static_cast<size_t>(std::distance(elements.begin(), it)), *it);
+    });
+}
+
+void setColor(float (&destination)[3], const QColor& color)
+{
+    destination[0] = static_cast<float>(color.redF());
+    destination[1] = static_cast<float>(color.greenF());
+    destination[2] = static_cast<float>(color.blueF());
+}
+
+void setPosition(float (&destination)[3], const QVector3D& position)
+{
+    destination[0] = position.x();
+    destination[1] = position.y();
+    destination[2] = position.z();
+}
+} // namespace
+
+void GraphRenderer::updateGPUDataIfRequired()
+{
+    if(!_gpuDataRequiresUpdate && !_gpuPositionDataRequiresUpdate)
+        return;
 
     std::unique_lock<NodePositions> nodePositionsLock(_graphModel->nodePositions());
-    std::unique_lock<std::recursive_mutex> glyphMapLock(_glyphMap->mutex());
 
-    int componentIndex = 0;
+    // The focus node determines which text is shown, when only showing its text
+    if(focusNodeIds() != _gpuDataFocusNodeIds)
+        _gpuDataRequiresUpdate = true;
+
+    bool rebuilt = _gpuDataRequiresUpdate;
 
-    auto& nodePositions = _graphModel->nodePositions();
+    if(rebuilt)
+        rebuildGPUData();
 
+    updateGPUPositionData();
+
+    if(rebuilt)
+        uploadGPUGraphData();
+    else
+        uploadGPUGraphPositionData();
+
+    _gpuDataRequiresUpdate = false;
+    _gpuPositionDataRequiresUpdate = false;
+}
+
+// Determines which elements go in which GPUGraphData, and regenerates
+// everything about them except for their positions
+void GraphRenderer::rebuildGPUData()
+{
     resetGPUGraphData();
+    _gpuGraphElements.clear();
+    _gpuDataFocusNodeIds = focusNodeIds();
 
-    NodeArray<QVector3D> scaledAndSmoothedNodePositions(_graphModel->graph());
+    int componentIndex = 0;
 
     float textScale = u::pref("visuals/textSize").toFloat();
     auto textAlignment = static_cast<TextAlignment>(u::pref("visuals/textAlignment").toInt());
@@ -234,6 +290,8 @@ void GraphRenderer::updateGPUDataIfRequired()
     if(!_graphModel->directed())
         edgeVisualType = EdgeVisualType::Cylinder;
 
+    // Assigning elements to GPUGraphData and creating glyphs is done serially,
+    // as neither gpuGraphDataForAlpha nor the glyph map are thread safe
     for(const auto& componentRendererRef : _componentRenderers)
     {
         GraphComponentRenderer* componentRenderer = componentRendererRef;
@@ -242,139 +300,347 @@ void GraphRenderer::updateGPUDataIfRequired()
 
         const float UnhighlightedAlpha = 0.22f;
 
-        for(auto nodeId : componentRenderer->nodeIds())
+        const auto& nodeIds = componentRenderer->lodActive() ?
+            componentRenderer->lodNodeIds() : componentRenderer->nodeIds();
+
+        for(auto nodeId : nodeIds)
         {
             if(_hiddenNodes.get(nodeId))
                 continue;
 
-            const QVector3D nodePosition = nodePositions.get(nodeId);
-            scaledAndSmoothedNodePositions[nodeId] = nodePosition;
-
             const auto& nodeVisual = _graphModel->nodeVisual(nodeId);
 
-            // Create and add NodeData
+            auto* gpuGraphData = gpuGraphDataForAlpha(componentRenderer->alpha(),
+                nodeVisual._state.test(VisualFlags::Unhighlighted) ? UnhighlightedAlpha : 1.0f);
+
+            if(gpuGraphData == nullptr)
+                continue;
+
             GPUGraphData::NodeData nodeData;
-            nodeData._position[0] = nodePosition.x();
-            nodeData._position[1] = nodePosition.y();
-            nodeData._position[2] = nodePosition.z();
             nodeData._component = componentIndex;
-            nodeData._size = nodeVisual._size;
-            nodeData._outerColor[0] = nodeVisual._outerColor.redF();
-            nodeData._outerColor[1] = nodeVisual._outerColor.greenF();
-            nodeData._outerColor[2] = nodeVisual._outerColor.blueF();
-            nodeData._innerColor[0] = nodeVisual._innerColor.redF();
-            nodeData._innerColor[1] = nodeVisual._innerColor.greenF();
-            nodeData._innerColor[2] = nodeVisual._innerColor.blueF();
-            nodeData._selected = nodeVisual._state.test(VisualFlags::Selected) ? 1.0f : 0.0f;
+            gpuGraphData->_nodeData.push_back(nodeData);
+            _gpuGraphElements[gpuGraphData]._nodeIds.push_back(nodeId);
+
+            if(nodeVisual._state.test(VisualFlags::Selected))
+                gpuGraphData->_elementsSelected = true;
+
+            if(showNodeText == TextState::Off || nodeVisual._state.test(VisualFlags::Unhighlighted))
+                continue;
+
+            if(showNodeText == TextState::Selected && !nodeVisual._state.test(VisualFlags::Selected))
+                continue;
+
+            if(showNodeText == TextState::Focused && componentRenderer->focusNodeId() != nodeId)
+                continue;
+
+            createGPUGlyphData(nodeVisual._text, textColor, textAlignment, textScale,
+                nodeVisual._size, {nodeId, nodeId}, componentIndex,
+                gpuGraphDataForOverlay(componentRenderer->alpha()));
+        }
+
+        // Regions of the component that are too small on screen to be worth drawing
+        // in full are drawn as a single node, taking the visuals of one of its nodes
+        const auto& aggregates = componentRenderer->lodAggregates();
+        std::vector<float> aggregateSizes;
+        aggregateSizes.reserve(aggregates.size());
+
+        for(size_t aggregateIndex = 0; aggregateIndex < aggregates.size(); aggregateIndex++)
+        {
+            const auto* aggregate = aggregates.at(aggregateIndex);
+            const auto& nodeVisual = _graphModel->nodeVisual(aggregate->representativeNodeId());
+            auto size = std::max(nodeVisual._size, aggregate->radius() * 0.5f);
+            aggregateSizes.push_back(size);
 
             auto* gpuGraphData = gpuGraphDataForAlpha(componentRenderer->alpha(),
                 nodeVisual._state.test(VisualFlags::Unhighlighted) ? UnhighlightedAlpha : 1.0f);
 
-            if(gpuGraphData != nullptr)
+            if(gpuGraphData == nullptr)
+                continue;
+
+            GPUGraphData::NodeData nodeData;
+            nodeData._component = componentIndex;
+            nodeData._size = size;
+            setColor(nodeData._outerColor, nodeVisual._outerColor);
+            setColor(nodeData._innerColor, nodeVisual._innerColor);
+            nodeData._selected = 0.0f;
+
+            auto& elements = _gpuGraphElements[gpuGraphData];
+            elements._aggregateNodeData.push_back(nodeData);
+            elements._aggregates.push_back({componentRenderer, static_cast<int>(aggregateIndex), {}});
+        }
+
+        // Edges with an end in an aggregate are bundled together with
+        // any others that have the same ends
+        struct EdgeBundle
+        {
+            EdgeId _edgeId;
+            int _count = 0;
+            GPUGraphElements::LODElement _source;
+            GPUGraphElements::LODElement _target;
+            float _sourceSize = 0.0f;
+            float _targetSize = 0.0f;
+        };
+
+        std::unordered_map<uint64_t, EdgeBundle> edgeBundles;
+
+        auto bundleEdge = [&](const IEdge& edge, int sourceAggregate, int targetAggregate)
+        {
+            // Aggregates and individual nodes share the same key space
+            auto endKey = [&aggregates](NodeId nodeId, int aggregateIndex)
             {
-                gpuGraphData->_nodeData.push_back(nodeData);
+                return static_cast<uint64_t>(aggregateIndex >= 0 ? aggregateIndex :
+                    static_cast<int>(aggregates.size()) + static_cast<int>(nodeId));
+            };
 
-                if(nodeData._selected != 0.0f)
-                    gpuGraphData->_elementsSelected = true;
+            auto sourceKey = endKey(edge.sourceId(), sourceAggregate);
+            auto targetKey = endKey(edge.targetId(), targetAggregate);
+            auto key = (std::min(sourceKey, targetKey) << 32) | std::max(sourceKey, targetKey);
 
-                if(showNodeText == TextState::Off || nodeVisual._state.test(VisualFlags::Unhighlighted))
-                    continue;
+            auto& bundle = edgeBundles[key];
+            bundle._count++;
 
-                if(showNodeText == TextState::Selected && !nodeVisual._state.test(VisualFlags::Selected))
-                    continue;
+            if(bundle._count > 1)
+                return;
 
-                if(showNodeText == TextState::Focused && componentRenderer->focusNodeId() != nodeId)
-                    continue;
+            auto setEnd = [&](NodeId nodeId, int aggregateIndex,
+                GPUGraphElements::LODElement& end, float& size)
+            {
+                end = {componentRenderer, aggregateIndex, nodeId};
 
-                createGPUGlyphData(nodeVisual._text, textColor, textAlignment, textScale,
-                    nodeVisual._size, nodePosition, componentIndex,
-                    gpuGraphDataForOverlay(componentRenderer->alpha()));
-            }
-        }
+                if(aggregateIndex >= 0)
+                    size = aggregateSizes.at(static_cast<size_t>(aggregateIndex));
+                else
+                    size = _graphModel->nodeVisual(nodeId)._size;
+            };
+
+            bundle._edgeId = edge.id();
+            setEnd(edge.sourceId(), sourceAggregate, bundle._source, bundle._sourceSize);
+            setEnd(edge.targetId(), targetAggregate, bundle._target, bundle._targetSize);
+        };
 
         for(auto& edge : componentRenderer->edges())
         {
             if(_hiddenEdges.get(edge->id()) || _hiddenNodes.get(edge->sourceId()) || _hiddenNodes.get(edge->targetId()))
                 continue;
 
-            const QVector3D& sourcePosition = scaledAndSmoothedNodePositions[edge->sourceId()];
-            const QVector3D& targetPosition = scaledAndSmoothedNodePositions[edge->targetId()];
+            if(componentRenderer->lodActive())
+            {
+                auto sourceAggregate = componentRenderer->lodAggregateIndexOf(edge->sourceId());
+                auto targetAggregate = componentRenderer->lodAggregateIndexOf(edge->targetId());
 
-            const auto& edgeVisual = _graphModel->edgeVisual(edge->id());
-            const auto& sourceNodeVisual = _graphModel->nodeVisual(edge->sourceId());
-            const auto& targetNodeVisual = _graphModel->nodeVisual(edge->targetId());
+                if(sourceAggregate >= 0 || targetAggregate >= 0)
+                {
+                    // Edges entirely within an aggregate aren't visible
+                    if(sourceAggregate != targetAggregate)
+                        bundleEdge(*edge, sourceAggregate, targetAggregate);
 
-            auto nodeRadiusSumSq = sourceNodeVisual._size + targetNodeVisual._size;
-            nodeRadiusSumSq *= nodeRadiusSumSq;
-            const auto edgeLengthSq = (targetPosition - sourcePosition).lengthSquared();
+                    continue;
+                }
 
-            if(edgeLengthSq < nodeRadiusSumSq)
-            {
-                // The edge's nodes are intersecting. Their overlap defines a lens of a
-                // certain radius. If this is greater than the edge radius, the edge is
-                // entirely enclosed within the nodes and we can safely skip rendering
-                // it altogether since it is entirely occluded.
+                // Both ends are out of view, but the edge may still pass through it
+                if(componentRenderer->lodCulled(edge->sourceId()) && componentRenderer->lodCulled(edge->targetId()))
+                {
+                    const auto& nodePositions = _graphModel->nodePositions();
+                    auto sourcePosition = nodePositions.getWhileLocked(edge->sourceId());
+                    auto targetPosition = nodePositions.getWhileLocked(edge->targetId());
+                    auto midpoint = (sourcePosition + targetPosition) * 0.5f;
 
-                const auto sourceRadiusSq = sourceNodeVisual._size * sourceNodeVisual._size;
-                const auto targetRadiusSq = targetNodeVisual._size * targetNodeVisual._size;
+                    if(!componentRenderer->lodVisible(midpoint, midpoint.distanceToPoint(sourcePosition)))
+                        continue;
+                }
+            }
 
-                const auto n = edgeLengthSq - sourceRadiusSq + targetRadiusSq;
-                const auto d = 4.0f * edgeLengthSq;
-                const auto intersectionLensRadiusSq = targetRadiusSq - ((n * n) / d);
+            const auto& edgeVisual = _graphModel->edgeVisual(edge->id());
 
-                const auto edgeRadiusSq = edgeVisual._size * edgeVisual._size;
+            auto* gpuGraphData = gpuGraphDataForAlpha(componentRenderer->alpha(),
+                edgeVisual._state.test(VisualFlags::Unhighlighted) ? UnhighlightedAlpha : 1.0f);
 
-                if(edgeRadiusSq < intersectionLensRadiusSq)
-                    continue;
-            }
+            if(gpuGraphData == nullptr)
+                continue;
 
+            // Edges that are occluded by their nodes are culled in the vertex shader,
+            // as whether or not that is the case depends on the layout
             GPUGraphData::EdgeData edgeData;
-            edgeData._sourcePosition[0] = sourcePosition.x();
-            edgeData._sourcePosition[1] = sourcePosition.y();
-            edgeData._sourcePosition[2] = sourcePosition.z();
-            edgeData._targetPosition[0] = targetPosition.x();
-            edgeData._targetPosition[1] = targetPosition.y();
-            edgeData._targetPosition[2] = targetPosition.z();
-            edgeData._sourceSize = _graphModel->nodeVisual(edge->sourceId())._size;
-            edgeData._targetSize = _graphModel->nodeVisual(edge->targetId())._size;
-            edgeData._edgeType = static_cast<int>(edgeVisualType);
             edgeData._component = componentIndex;
-            edgeData._size = edgeVisual._size;
-            edgeData._outerColor[0] = edgeVisual._outerColor.redF();
-            edgeData._outerColor[1] = edgeVisual._outerColor.greenF();
-            edgeData._outerColor[2] = edgeVisual._outerColor.blueF();
-            edgeData._innerColor[0] = edgeVisual._innerColor.redF();
-            edgeData._innerColor[1] = edgeVisual._innerColor.greenF();
-            edgeData._innerColor[2] = edgeVisual._innerColor.blueF();
-            edgeData._selected = 0.0f;
+            gpuGraphData->_edgeData.push_back(edgeData);
+
+            auto& elements = _gpuGraphElements[gpuGraphData];
+            elements._edgeIds.push_back(edge->id());
+            elements._edgeNodeIds.emplace_back(edge->sourceId(), edge->targetId());
+
+            if(showEdgeText == TextState::Off || edgeVisual._state.test(VisualFlags::Unhighlighted))
+                continue;
+
+            if(showEdgeText == TextState::Selected && !edgeVisual._state.test(VisualFlags::Selected))
+                continue;
+
+            createGPUGlyphData(edgeVisual._text, textColor, textAlignment, textScale,
+                edgeVisual._size, {edge->sourceId(), edge->targetId()}, componentIndex,
+                gpuGraphDataForOverlay(componentRenderer->alpha()));
+        }
+
+        for(const auto& [key, bundle] : edgeBundles)
+        {
+            const auto& edgeVisual = _graphModel->edgeVisual(bundle._edgeId);
 
             auto* gpuGraphData = gpuGraphDataForAlpha(componentRenderer->alpha(),
                 edgeVisual._state.test(VisualFlags::Unhighlighted) ? UnhighlightedAlpha : 1.0f);
 
-            if(gpuGraphData != nullptr)
-            {
-                gpuGraphData->_edgeData.push_back(edgeData);
+            if(gpuGraphData == nullptr)
+                continue;
 
-                if(edgeData._selected != 0.0f)
-                    gpuGraphData->_elementsSelected = true;
+            // A bundle is thicker the more edges it represents, but no thicker than its ends
+            auto size = edgeVisual._size * std::sqrt(static_cast<float>(bundle._count));
+            size = std::min(size, std::min(bundle._sourceSize, bundle._targetSize));
 
-                if(showEdgeText == TextState::Off || edgeVisual._state.test(VisualFlags::Unhighlighted))
-                    continue;
-
-                if(showEdgeText == TextState::Selected && !edgeVisual._state.test(VisualFlags::Selected))
-                    continue;
+            GPUGraphData::EdgeData edgeData;
+            edgeData._sourceSize = bundle._sourceSize;
+            edgeData._targetSize = bundle._targetSize;
+            edgeData._edgeType = static_cast<int>(EdgeVisualType::Cylinder);
+            edgeData._component = componentIndex;
+            edgeData._size = size;
+            setColor(edgeData._outerColor, edgeVisual._outerColor);
+            setColor(edgeData._innerColor, edgeVisual._innerColor);
+            edgeData._selected = 0.0f;
 
-                QVector3D midPoint = (sourcePosition + targetPosition) * 0.5f;
-                createGPUGlyphData(edgeVisual._text, textColor, textAlignment, textScale,
-                    edgeVisual._size, midPoint, componentIndex,
-                    gpuGraphDataForOverlay(componentRenderer->alpha()));
-            }
+            auto& elements = _gpuGraphElements[gpuGraphData];
+            elements._bundledEdgeData.push_back(edgeData);
+            elements._bundledEdgeEnds.emplace_back(bundle._source, bundle._target);
         }
 
         componentIndex++;
     }
 
-    uploadGPUGraphData();
+    // The remaining attributes are filled in concurrently, into the pre-sized buffers
+    for(auto& [gpuGraphData, elements] : _gpuGraphElements)
+    {
+        auto* nodeData = gpuGraphData->_nodeData.data();
+        concurrentForEachIndex(elements._nodeIds, [this, nodeData](size_t index, NodeId nodeId)
+        {
+            const auto& nodeVisual = _graphModel->nodeVisual(nodeId);
+            auto& data = nodeData[index];
+
+            data._size = nodeVisual._size;
+            setColor(data._outerColor, nodeVisual._outerColor);
+            setColor(data._innerColor, nodeVisual._innerColor);
+            data._selected = nodeVisual._state.test(VisualFlags::Selected) ? 1.0f : 0.0f;
+        });
+
+        auto* edgeData = gpuGraphData->_edgeData.data();
+        const auto& edgeNodeIds = elements._edgeNodeIds;
+        concurrentForEachIndex(elements._edgeIds,
+        [this, edgeData, &edgeNodeIds, edgeVisualType](size_t index, EdgeId edgeId)
+        {
+            const auto& edgeVisual = _graphModel->edgeVisual(edgeId);
+            auto& data = edgeData[index];
+
+            data._sourceSize = _graphModel->nodeVisual(edgeNodeIds[index].first)._size;
+            data._targetSize = _graphModel->nodeVisual(edgeNodeIds[index].second)._size;
+            data._edgeType = static_cast<int>(edgeVisualType);
+            data._size = edgeVisual._size;
+            setColor(data._outerColor, edgeVisual._outerColor);
+            setColor(data._innerColor, edgeVisual._innerColor);
+            data._selected = 0.0f;
+        });
+
+        gpuGraphData->_nodeData.insert(gpuGraphData->_nodeData.end(),
+            elements._aggregateNodeData.begin(), elements._aggregateNodeData.end());
+        gpuGraphData->_edgeData.insert(gpuGraphData->_edgeData.end(),
+            elements._bundledEdgeData.begin(), elements._bundledEdgeData.end());
+    }
+}
+
+// Rewrites the positions of the elements added by the last rebuildGPUData
+void GraphRenderer::updateGPUPositionData()
+{
+    const auto& nodePositions = _graphModel->nodePositions();
+
+    auto positionOf = [&nodePositions](const GPUGraphElements::LODElement& element)
+    {
+        if(element._aggregateIndex < 0)
+            return nodePositions.getWhileLocked(element._nodeId);
+
+        // The component may have been cleaned up since the last rebuild,
+        // in which case another is pending, so this position is moot
+        const auto& aggregates = element._componentRenderer->lodAggregates();
+        auto aggregateIndex = static_cast<size_t>(element._aggregateIndex);
+        if(aggregateIndex >= aggregates.size())
+            return QVector3D();
+
+        return aggregates.at(aggregateIndex)->centre();
+    };
+
+    for(auto& [gpuGraphData, elements] : _gpuGraphElements)
+    {
+        const auto numNodes = elements._nodeIds.size();
+        gpuGraphData->_nodePositionData.resize(numNodes + elements._aggregates.size());
+        auto* nodePositionData = gpuGraphData->_nodePositionData.data();
+        concurrentForEachIndex(elements._nodeIds,
+        [&nodePositions, nodePositionData](size_t index, NodeId nodeId)
+        {
+            setPosition(nodePositionData[index]._position, nodePositions.getWhileLocked(nodeId));
+        });
+
+        for(size_t i = 0; i < elements._aggregates.size(); i++)
+            setPosition(nodePositionData[numNodes + i]._position, positionOf(elements._aggregates.at(i)));
+
+        const auto numEdges = elements._edgeNodeIds.size();
+        gpuGraphData->_edgePositionData.resize(numEdges + elements._bundledEdgeEnds.size());
+        auto* edgePositionData = gpuGraphData->_edgePositionData.data();
+        concurrentForEachIndex(elements._edgeNodeIds,
+        [&nodePositions, edgePositionData](size_t index, std::pair<NodeId, NodeId> nodeIds)
+        {
+            auto& data = edgePositionData[index];
+            setPosition(data._sourcePosition, nodePositions.getWhileLocked(nodeIds.first));
+            setPosition(data._targetPosition, nodePositions.getWhileLocked(nodeIds.second));
+        });
+
+        for(size_t i = 0; i < elements._bundledEdgeEnds.size(); i++)
+        {
+            auto& data = edgePositionData[numEdges + i];
+            setPosition(data._sourcePosition, positionOf(elements._bundledEdgeEnds.at(i).first));
+            setPosition(data._targetPosition, positionOf(elements._bundledEdgeEnds.at(i).second));
+        }
+
+        Q_ASSERT(gpuGraphData->_glyphData.size() == elements._glyphAnchors.size());
+        auto* glyphData = gpuGraphData->_glyphData.data();
+        concurrentForEachIndex(elements._glyphAnchors,
+        [&nodePositions, glyphData](size_t index, std::pair<NodeId, NodeId> anchor)
+        {
+            auto midPoint = (nodePositions.getWhileLocked(anchor.first) +
+                nodePositions.getWhileLocked(anchor.second)) * 0.5f;
+            setPosition(glyphData[index]._basePosition, midPoint);
+        });
+    }
+}
+
+void GraphRenderer::updateLOD()
+{
+    std::unique_lock<NodePositions> nodePositionsLock(_graphModel->nodePositions());
+
+    for(const auto& componentRendererRef : _componentRenderers)
+    {
+        GraphComponentRenderer* componentRenderer = componentRendererRef;
+
+        // The camera may have moved such that a different level of detail is
+        // required, or such that a different part of the component is in view
+        if(componentRenderer->visible() && componentRenderer->updateLOD())
+            _gpuDataRequiresUpdate = true;
+    }
+}
+
+std::vector<NodeId> GraphRenderer::focusNodeIds() const
+{
+    std::vector<NodeId> nodeIds;
+
+    for(const auto& componentRendererRef : _componentRenderers)
+    {
+        const GraphComponentRenderer* componentRenderer = componentRendererRef;
+        if(componentRenderer->visible())
+            nodeIds.push_back(componentRenderer->focusNodeId());
+    }
+
+    return nodeIds;
 }
 
 void GraphRenderer::updateGPUData(GraphRenderer::When when)
@@ -861,12 +1127,14 @@ void GraphRenderer::updateText(std::function<void()> onCompleteFn) // NOLINT
     {
         glyphMapLock.unlock();
 
-        auto job = std::make_unique<SDFComputeJob>(&_sdfTexture, _glyphMap.get());
+        auto job = std::make_unique<SDFComputeJob>(&_sdfTexture, _glyphMap.get(), &_sdfLayerVersions);
         job->executeWhenComplete([this, onCompleteFn]
         {
             executeOnRendererThread([this]
             {
                 _sdfTexture.swap();
+
+                std::unique_lock<std::recursive_mutex> glyphMapLock(_glyphMap->mutex());
                 _textLayoutResults = _glyphMap->results();
 
                 updateGPUData(When::Later);
@@ -971,8 +1239,14 @@ void GraphRenderer::updateScene()
     {
         processEventQueue();
 
+        // Take whatever positions the layout most recently published
+        _graphModel->nodePositions().acquire();
+        auto nodePositionsEpoch = _graphModel->nodePositions().epoch();
+        bool nodePositionsAcquired = nodePositionsEpoch != _nodePositionsEpoch;
+        _nodePositionsEpoch = nodePositionsEpoch;
+
         // _synchronousLayoutChanged can only ever be (atomically) true in this scope
-        _synchronousLayoutChanged = _layoutChanged.exchange(false);
+        _synchronousLayoutChanged = _layoutChanged.exchange(false) || nodePositionsAcquired;
 
         // If there is a transition active then we'll need another
         // frame once we're finished with this one
@@ -984,8 +1258,9 @@ void GraphRenderer::updateScene()
         _scene->update(dTime);
 
         if(layoutChanged())
-            updateGPUData(When::Later);
+            _gpuPositionDataRequiresUpdate = true;
 
+        updateLOD();
         updateGPUDataIfRequired();
         updateComponentGPUData();
 
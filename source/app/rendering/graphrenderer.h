@@ -26,6 +26,7 @@
 #include "transition.h"
 #include "glyphmap.h"
 #include "doublebufferedtexture.h"
+#include "compute/sdfcomputejob.h"
 #include "projection.h"
 #include "shading.h"
 
@@ -55,7 +56,10 @@
 #include <QPixmap>
 #include <QPainter>
 #include <array>
+#include <map>
 #include <queue>
+#include <utility>
+#include <cstdint>
 
 class Graph;
 class GraphQuickItem;
@@ -222,6 +226,7 @@ private:
     GLuint _colorTexture = 0;
 
     DoubleBufferedTexture _sdfTexture;
+    SDFComputeJob::LayerVersions _sdfLayerVersions;
 
     bool _FBOcomplete = false;
 
@@ -233,6 +238,42 @@ private:
     EdgeArray<bool> _hiddenEdges;
 
     bool _gpuDataRequiresUpdate = false;
+    bool _gpuPositionDataRequiresUpdate = false;
+
+    // The elements each GPUGraphData was built from, in buffer order, so that
+    // when only the layout has changed, the positions can be rewritten without
+    // regenerating everything else
+    struct GPUGraphElements
+    {
+        std::vector<NodeId> _nodeIds;
+        std::vector<EdgeId> _edgeIds;
+        std::vector<std::pair<NodeId, NodeId>> _edgeNodeIds;
+
+        // Glyphs are placed at the midpoint of their anchors, which
+        // for a node's glyphs are both the node itself
+        std::vector<std::pair<NodeId, NodeId>> _glyphAnchors;
+
+        // Either an LOD aggregate, by its index into its component
+        // renderer's lodAggregates, or when _aggregateIndex is -1, a node
+        struct LODElement
+        {
+            const GraphComponentRenderer* _componentRenderer = nullptr;
+            int _aggregateIndex = -1;
+            NodeId _nodeId;
+        };
+
+        // LOD aggregates of nodes, and bundles of the edges between them; these
+        // follow the individual elements in the buffers, and are regenerated by a
+        // full rebuild whenever the set of aggregates changes, but their positions
+        // follow the layout, like those of the individual elements
+        std::vector<GPUGraphData::NodeData> _aggregateNodeData;
+        std::vector<LODElement> _aggregates;
+        std::vector<GPUGraphData::EdgeData> _bundledEdgeData;
+        std::vector<std::pair<LODElement, LODElement>> _bundledEdgeEnds;
+    };
+
+    std::map<GPUGraphData*, GPUGraphElements> _gpuGraphElements;
+    std::vector<NodeId> _gpuDataFocusNodeIds;
 
     QRect _selectionRect;
 
@@ -244,6 +285,10 @@ private:
     std::atomic<bool> _layoutChanged;
     bool _synchronousLayoutChanged = false;
 
+    // The epoch of the node positions last rendered; positions may also be
+    // acquired elsewhere, e.g. when saving, so acquire's result isn't enough
+    uint64_t _nodePositionsEpoch = 0;
+
     Transition _transition;
 
     PerformanceCounter _performanceCounter;
@@ -264,6 +309,10 @@ private:
     void updateGPUDataIfRequired();
     enum class When { Later, Now };
     void updateGPUData(When when);
+    void updateLOD();
+    void rebuildGPUData();
+    void updateGPUPositionData();
+    std::vector<NodeId> focusNodeIds() const;
     void updateComponentGPUData();
 
     // For high DPI displays (mostly MacOS "Retina" display)
@@ -305,7 +354,7 @@ private:
     void moveFocusToComponent(ComponentId componentId);
 
     void createGPUGlyphData(const QString& text, const QColor& textColor, const TextAlignment& textAlignment,
-                         float textScale, float elementSize, const QVector3D& elementPosition,
+                         float textScale, float elementSize, std::pair<NodeId, NodeId> anchor,
                          int componentIndex, GPUGraphData* gpuGraphData);
 
 signals:
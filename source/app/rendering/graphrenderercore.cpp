@@ -98,6 +98,12 @@ void GPUGraphData::prepareVertexBuffers()
         _nodeVBO.setUsagePattern(QOpenGLBuffer::DynamicDraw);
     }
 
+    if(!_nodePositionVBO.isCreated())
+    {
+        _nodePositionVBO.create();
+        _nodePositionVBO.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    }
+
     if(!_textVBO.isCreated())
     {
         _textVBO.create();
@@ -109,6 +115,12 @@ void GPUGraphData::prepareVertexBuffers()
         _edgeVBO.create();
         _edgeVBO.setUsagePattern(QOpenGLBuffer::DynamicDraw);
     }
+
+    if(!_edgePositionVBO.isCreated())
+    {
+        _edgePositionVBO.create();
+        _edgePositionVBO.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    }
 }
 
 void GPUGraphData::prepareTextVAO(QOpenGLShaderProgram& shader)
@@ -153,14 +165,17 @@ void GPUGraphData::prepareNodeVAO(QOpenGLShaderProgram& shader)
     _sphere.vertexArrayObject()->bind();
     shader.bind();
 
-    _nodeVBO.bind();
+    _nodePositionVBO.bind();
     shader.enableAttributeArray("nodePosition");
+    shader.setAttributeBuffer("nodePosition", GL_FLOAT, offsetof(NodePositionData, _position), 3, sizeof(NodePositionData));
+    _nodePositionVBO.release();
+
+    _nodeVBO.bind();
     shader.enableAttributeArray("component");
     shader.enableAttributeArray("size");
     shader.enableAttributeArray("outerColor");
     shader.enableAttributeArray("innerColor");
     shader.enableAttributeArray("selected");
-    shader.setAttributeBuffer("nodePosition", GL_FLOAT, offsetof(NodeData, _position),     3,         sizeof(NodeData));
     glVertexAttribIPointer(shader.attributeLocation("component"),                          1, GL_INT, sizeof(NodeData),
                           reinterpret_cast<const void*>(offsetof(NodeData, _component))); // NOLINT
     shader.setAttributeBuffer("size",         GL_FLOAT, offsetof(NodeData, _size),         1,         sizeof(NodeData));
@@ -184,9 +199,14 @@ void GPUGraphData::prepareEdgeVAO(QOpenGLShaderProgram& shader)
     _arrow.vertexArrayObject()->bind();
     shader.bind();
 
-    _edgeVBO.bind();
+    _edgePositionVBO.bind();
     shader.enableAttributeArray("sourcePosition");
     shader.enableAttributeArray("targetPosition");
+    shader.setAttributeBuffer("sourcePosition", GL_FLOAT, offsetof(EdgePositionData, _sourcePosition), 3, sizeof(EdgePositionData));
+    shader.setAttributeBuffer("targetPosition", GL_FLOAT, offsetof(EdgePositionData, _targetPosition), 3, sizeof(EdgePositionData));
+    _edgePositionVBO.release();
+
+    _edgeVBO.bind();
     shader.enableAttributeArray("sourceSize");
     shader.enableAttributeArray("targetSize");
     shader.enableAttributeArray("edgeType");
@@ -195,8 +215,6 @@ void GPUGraphData::prepareEdgeVAO(QOpenGLShaderProgram& shader)
     shader.enableAttributeArray("outerColor");
     shader.enableAttributeArray("innerColor");
     shader.enableAttributeArray("selected");
-    shader.setAttributeBuffer("sourcePosition", GL_FLOAT, offsetof(EdgeData, _sourcePosition),  3,         sizeof(EdgeData));
-    shader.setAttributeBuffer("targetPosition", GL_FLOAT, offsetof(EdgeData, _targetPosition),  3,         sizeof(EdgeData));
     shader.setAttributeBuffer("sourceSize",     GL_FLOAT, offsetof(EdgeData, _sourceSize),      1,         sizeof(EdgeData));
     shader.setAttributeBuffer("targetSize",     GL_FLOAT, offsetof(EdgeData, _targetSize),      1,         sizeof(EdgeData));
     glVertexAttribIPointer(shader.attributeLocation("edgeType"),                                1, GL_INT, sizeof(EdgeData),
@@ -253,7 +271,9 @@ void GPUGraphData::reset()
     _isOverlay = false;
     _elementsSelected = false;
     _nodeData.clear();
+    _nodePositionData.clear();
     _edgeData.clear();
+    _edgePositionData.clear();
     _glyphData.clear();
 }
 
@@ -301,6 +321,40 @@ void GPUGraphData::upload()
     _edgeVBO.allocate(_edgeData.data(), static_cast<int>(_edgeData.size() * sizeof(EdgeData)));
     _edgeVBO.release();
 
+    _nodePositionVBO.bind();
+    _nodePositionVBO.allocate(static_cast<int>(_nodePositionData.size() * sizeof(NodePositionData)));
+    _nodePositionVBO.release();
+
+    _edgePositionVBO.bind();
+    _edgePositionVBO.allocate(static_cast<int>(_edgePositionData.size() * sizeof(EdgePositionData)));
+    _edgePositionVBO.release();
+
+    uploadPositions();
+}
+
+// Only the positions are rewritten, into buffers that have already been sized by upload()
+void GPUGraphData::uploadPositions()
+{
+    Q_ASSERT(_nodePositionData.size() == _nodeData.size());
+    Q_ASSERT(_edgePositionData.size() == _edgeData.size());
+
+    if(!_nodePositionData.empty())
+    {
+        _nodePositionVBO.bind();
+        _nodePositionVBO.write(0, _nodePositionData.data(),
+            static_cast<int>(_nodePositionData.size() * sizeof(NodePositionData)));
+        _nodePositionVBO.release();
+    }
+
+    if(!_edgePositionData.empty())
+    {
+        _edgePositionVBO.bind();
+        _edgePositionVBO.write(0, _edgePositionData.data(),
+            static_cast<int>(_edgePositionData.size() * sizeof(EdgePositionData)));
+        _edgePositionVBO.release();
+    }
+
+    // Glyphs are anchored to element positions, but there are comparatively few of them
     _textVBO.bind();
     _textVBO.allocate(_glyphData.data(), static_cast<int>(_glyphData.size() * sizeof(GlyphData)));
     _textVBO.release();
@@ -365,8 +419,10 @@ void GPUGraphData::copyState(const GPUGraphData& gpuGraphData,
     _unhighlightAlpha = gpuGraphData._unhighlightAlpha;
     _isOverlay = gpuGraphData._isOverlay;
     _nodeData = gpuGraphData._nodeData;
+    _nodePositionData = gpuGraphData._nodePositionData;
     _glyphData = gpuGraphData._glyphData;
     _edgeData = gpuGraphData._edgeData;
+    _edgePositionData = gpuGraphData._edgePositionData;
     _elementsSelected = gpuGraphData._elementsSelected;
 
     // Cause VBO to be recreated
@@ -376,7 +432,9 @@ void GPUGraphData::copyState(const GPUGraphData& gpuGraphData,
     _selectionTexture = 0;
 
     _edgeVBO.destroy();
+    _edgePositionVBO.destroy();
     _nodeVBO.destroy();
+    _nodePositionVBO.destroy();
     _textVBO.destroy();
 
     initialise(nodesShader, edgesShader, textShader);
@@ -643,6 +701,15 @@ void GraphRendererCore::uploadGPUGraphData()
     }
 }
 
+void GraphRendererCore::uploadGPUGraphPositionData()
+{
+    for(auto& gpuGraphData : _gpuGraphData)
+    {
+        if(gpuGraphData.alpha() > 0.0f)
+            gpuGraphData.uploadPositions();
+    }
+}
+
 void GraphRendererCore::resetGPUComponentData()
 {
     _componentData.clear();
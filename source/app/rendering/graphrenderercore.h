@@ -60,6 +60,7 @@ struct GPUGraphData : OpenGLFunctions
     void drawToFramebuffer();
 
     void upload();
+    void uploadPositions();
 
     int numNodes() const;
     int numEdges() const;
@@ -79,9 +80,9 @@ struct GPUGraphData : OpenGLFunctions
 
     bool hasGraphElements() const;
 
+    // The attributes that only change when the visuals do
     struct NodeData
     {
-        float _position[3] = {0.0f, 0.0f, 0.0f};
         int _component = -1;
         float _size = -1.0f;
         float _outerColor[3] = {0.0f, 0.0f, 0.0f};
@@ -91,8 +92,6 @@ struct GPUGraphData : OpenGLFunctions
 
     struct EdgeData
     {
-        float _sourcePosition[3] = {0.0f, 0.0f, 0.0f};
-        float _targetPosition[3] = {0.0f, 0.0f, 0.0f};
         float _sourceSize = 0.0f;
         float _targetSize = 0.0f;
         int _edgeType = -1;
@@ -103,6 +102,18 @@ struct GPUGraphData : OpenGLFunctions
         float _selected = 0.0f;
     };
 
+    // The attributes that change whenever the layout does
+    struct NodePositionData
+    {
+        float _position[3] = {0.0f, 0.0f, 0.0f};
+    };
+
+    struct EdgePositionData
+    {
+        float _sourcePosition[3] = {0.0f, 0.0f, 0.0f};
+        float _targetPosition[3] = {0.0f, 0.0f, 0.0f};
+    };
+
     struct GlyphData
     {
         int _component = -1;
@@ -126,12 +137,18 @@ struct GPUGraphData : OpenGLFunctions
     std::vector<NodeData> _nodeData;
     QOpenGLBuffer _nodeVBO;
 
+    std::vector<NodePositionData> _nodePositionData;
+    QOpenGLBuffer _nodePositionVBO;
+
     std::vector<GlyphData> _glyphData;
     QOpenGLBuffer _textVBO;
 
     std::vector<EdgeData> _edgeData;
     QOpenGLBuffer _edgeVBO;
 
+    std::vector<EdgePositionData> _edgePositionData;
+    QOpenGLBuffer _edgePositionVBO;
+
     bool _elementsSelected = false;
 
     GLuint _fbo = 0;
@@ -198,6 +215,7 @@ protected:
     GPUGraphData* gpuGraphDataForOverlay(float alpha);
     void resetGPUGraphData();
     void uploadGPUGraphData();
+    void uploadGPUGraphPositionData();
 
     void resetGPUComponentData();
     void appendGPUComponentData(const QMatrix4x4& modelViewMatrix,
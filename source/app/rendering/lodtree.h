@@ -0,0 +1,150 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LODTREE_H
+#define LODTREE_H
+
+#include "layout/spatialtree.h"
+
+#include <QVector3D>
+
+#include <cmath>
+#include <vector>
+
+class LODTree;
+
+struct LODSubVolume : SubVolume<LODTree, 3> {};
+
+// A spatial tree over the (rendered) positions of a component's nodes, in which each
+// sub tree summarises the nodes within it, so that regions that are too small on
+// screen to be worth drawing in full can be drawn as a single aggregate instead
+class LODTree : public SpatialTree<LODTree, 3, LODSubVolume, ExactNodePositions>
+{
+private:
+    static constexpr unsigned int MaxNodesPerLeaf = 16;
+
+    int _mass = 0;
+    QVector3D _centre;
+    float _radius = 0.0f;
+    NodeId _representativeNodeId;
+
+    void initialise(const ExactNodePositions& nodePositions, const std::vector<NodeId>& nodeIds) override
+    {
+        _mass = static_cast<int>(nodeIds.size());
+        _representativeNodeId = nodeIds.front();
+
+        float reciprocal = 1.0f / static_cast<float>(_mass);
+        for(auto nodeId : nodeIds)
+            _centre += nodePositions.get(nodeId) * reciprocal;
+
+        for(auto nodeId : nodeIds)
+            _radius = std::max(_radius, _centre.distanceToPoint(nodePositions.get(nodeId)));
+    }
+
+    template<typename AggregateFn, typename NodeFn>
+    void traverse(AggregateFn&& aggregateFn, NodeFn&& nodeFn) const
+    {
+        std::vector<const LODTree*> stack;
+        stack.push_back(this);
+
+        while(!stack.empty())
+        {
+            const LODTree* subTree = stack.back();
+            stack.pop_back();
+
+            for(int i = 0; i < subTree->_numInternalNodes; i++)
+            {
+                const LODTree* childTree = subTree->_internalNodes.at(i)->_subTree.get();
+
+                if(!aggregateFn(*childTree))
+                    stack.push_back(childTree);
+            }
+
+            for(int i = 0; i < subTree->_numNonEmptyLeaves; i++)
+            {
+                for(auto nodeId : subTree->_nonEmptyLeaves.at(i)->_nodeIds)
+                    nodeFn(nodeId);
+            }
+        }
+    }
+
+public:
+    LODTree()
+    {
+        setMaxNodesPerLeaf(MaxNodesPerLeaf);
+    }
+
+    int mass() const { return _mass; }
+    const QVector3D& centre() const { return _centre; }
+    float radius() const { return _radius; }
+
+    // Any one of the nodes within the tree, from which to take visual attributes
+    NodeId representativeNodeId() const { return _representativeNodeId; }
+
+    // Visits the sub trees depth first, not descending into those for which aggregateFn
+    // returns true; the nodes of any leaves that are reached are passed to nodeFn
+    template<typename AggregateFn, typename NodeFn>
+    void cut(AggregateFn&& aggregateFn, NodeFn&& nodeFn) const
+    {
+        traverse(std::forward<AggregateFn>(aggregateFn), std::forward<NodeFn>(nodeFn));
+    }
+
+    // Recomputes the centres and radii from moved positions, keeping the existing
+    // structure; the radii are conservative, so are never smaller than if the tree
+    // were rebuilt, but the tree becomes less efficient the further the nodes move
+    void refit(const ExactNodePositions& nodePositions)
+    {
+        QVector3D sum;
+
+        for(int i = 0; i < _numInternalNodes; i++)
+        {
+            auto* childTree = _internalNodes.at(i)->_subTree.get();
+            childTree->refit(nodePositions);
+            sum += childTree->_centre * static_cast<float>(childTree->_mass);
+        }
+
+        for(int i = 0; i < _numNonEmptyLeaves; i++)
+        {
+            for(auto nodeId : _nonEmptyLeaves.at(i)->_nodeIds)
+                sum += nodePositions.get(nodeId);
+        }
+
+        _centre = sum / static_cast<float>(_mass);
+        _radius = 0.0f;
+
+        for(int i = 0; i < _numInternalNodes; i++)
+        {
+            const auto* childTree = _internalNodes.at(i)->_subTree.get();
+            _radius = std::max(_radius, _centre.distanceToPoint(childTree->_centre) + childTree->_radius);
+        }
+
+        for(int i = 0; i < _numNonEmptyLeaves; i++)
+        {
+            for(auto nodeId : _nonEmptyLeaves.at(i)->_nodeIds)
+                _radius = std::max(_radius, _centre.distanceToPoint(nodePositions.get(nodeId)));
+        }
+    }
+
+    template<typename Fn>
+    void forEachNodeId(Fn&& fn) const
+    {
+        traverse([](const LODTree&) { return false; }, std::forward<Fn>(fn));
+    }
+};
+
+#endif // LODTREE_H
@@ -117,6 +117,32 @@ void main()
     element = float(-(gl_InstanceID + 1));
 
     float edgeLength = distance(sourcePosition, targetPosition);
+
+    float edgeLengthSq = edgeLength * edgeLength;
+    float nodeRadiusSum = sourceSize + targetSize;
+
+    if(edgeLengthSq > 0.0 && edgeLengthSq < (nodeRadiusSum * nodeRadiusSum))
+    {
+        // The edge's nodes are intersecting. Their overlap defines a lens of a
+        // certain radius. If this is greater than the edge radius, the edge is
+        // entirely enclosed within the nodes and we can safely skip rendering
+        // it altogether since it is entirely occluded. This happens here rather
+        // than on the CPU so that the set of edges is independent of the layout.
+        float sourceRadiusSq = sourceSize * sourceSize;
+        float targetRadiusSq = targetSize * targetSize;
+
+        float n = edgeLengthSq - sourceRadiusSq + targetRadiusSq;
+        float d = 4.0 * edgeLengthSq;
+        float intersectionLensRadiusSq = targetRadiusSq - ((n * n) / d);
+
+        if((size * size) < intersectionLensRadiusSq)
+        {
+            // Degenerate every vertex so that no fragments are produced
+            gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+            return;
+        }
+    }
+
     float edgeLengthMinusNodeRadii = edgeLength - (sourceSize + targetSize);
     vec3 midpoint = mix(sourcePosition, targetPosition, 0.5);
     mat4 orientationMatrix = makeOrientationMatrix(normalize(targetPosition - sourcePosition));
@@ -67,6 +67,21 @@ public:
     const TransformInfo* info() const { return _info; }
     void setInfo(TransformInfo* info) { _info = info; }
 
+    void resetInfo() const
+    {
+        if(_info != nullptr)
+            *_info = {};
+    }
+
+    void restoreCachedInfo(const TransformInfo& info) const
+    {
+        if(_info == nullptr)
+            return;
+
+        *_info = info;
+        _info->setCached(true);
+    }
+
     int index() const { return _index; }
 
     // This is so that subclasses can access the config
@@ -22,10 +22,21 @@
 #include "graph/mutablegraph.h"
 #include "transform/transformedgraph.h"
 
-#include "shared/utils/iterator_range.h"
 #include "shared/utils/container.h"
 
 #include <algorithm>
+#include <atomic>
+
+namespace
+{
+// Result ids must be unique across every copy of every cache, as results are
+// matched on the ids of their inputs
+int newResultId()
+{
+    static std::atomic<int> nextResultId(1);
+    return nextResultId++;
+}
+} // namespace
 
 TransformCache::TransformCache(GraphModel& graphModel) :
     _graphModel(&graphModel)
@@ -34,158 +45,142 @@ TransformCache::TransformCache(GraphModel& graphModel) :
 TransformCache& TransformCache::operator=(TransformCache&& other) noexcept
 {
     _graphModel = other._graphModel;
-    _cache = std::move(other._cache);
+    _results = std::move(other._results);
+    _retiredResults = std::move(other._retiredResults);
+    _graphId = other._graphId;
+    _attributeIds = std::move(other._attributeIds);
     return *this;
 }
 
-bool TransformCache::lastResultChangesGraph() const
+void TransformCache::clear()
 {
-    return std::any_of(_cache.back().begin(), _cache.back().end(), [](const auto& result)
-    {
-        return result._graph != nullptr;
-    });
+    _results.clear();
+    _retiredResults.clear();
+    _graphId = 0;
+    _attributeIds.clear();
 }
 
-bool TransformCache::lastResultCreatedAnyOf(const std::vector<QString>& attributeNames) const
+TransformCache::Result TransformCache::resultFor(const GraphTransformConfig& config) const
 {
-    return !u::setIntersection(attributesCreatedByLastResult(), attributeNames).empty();
-}
-
-std::vector<QString> TransformCache::attributesCreatedByLastResult() const
-{
-    std::vector<QString> attributeNames;
+    Result result;
+    result._config = config;
+    result._inputGraphId = _graphId;
 
-    for(const auto& result : _cache.back())
+    for(const auto& attributeName : config.referencedAttributeNames())
     {
-        auto resultAttributeNames = u::keysFor(result._newAttributes);
-        attributeNames.insert(attributeNames.end(), resultAttributeNames.begin(), resultAttributeNames.end());
+        result._inputAttributeIds[attributeName] = u::contains(_attributeIds, attributeName) ?
+            _attributeIds.at(attributeName) : 0;
     }
 
-    return attributeNames;
+    return result;
 }
 
 void TransformCache::add(TransformCache::Result&& result)
 {
-    if(_cache.empty() || lastResultChangesGraph() || lastResultCreatedAnyOf(result.referencedAttributeNames()))
-        _cache.emplace_back();
+    // Results that are reused keep their id, so anything downstream
+    // that depends on them can also be reused
+    if(result._id == 0)
+        result._id = newResultId();
 
-    _cache.back().emplace_back(std::move(result));
+    if(result.changesGraph())
+        _graphId = result._id;
+
+    for(const auto& attributeName : u::keysFor(result._newAttributes))
+        _attributeIds[attributeName] = result._id;
+
+    _results.emplace_back(std::move(result));
 }
 
 void TransformCache::attributeAdded(const QString& attributeName)
 {
-    // When an attribute is added its values may differ to previous incarnations, so
-    // invalidate any subsequent entries that depend on it
-    // Furthermore, if any entries are /creating/ the same attribute that we're adding,
-    // invalidate those too as their names will need to be regenerated
-    auto resultSetIt = _cache.begin();
-    auto resultSetEnd = _cache.end();
-    for(; resultSetIt != resultSetEnd; ++resultSetIt)
+    // If any entries are creating the same attribute that we're adding,
+    // invalidate them as their names will need to be regenerated; entries that
+    // depend on the attribute are already invalid by virtue of their inputs
+    auto createsAttribute = [&attributeName](const auto& result)
     {
-        auto resultIt = resultSetIt->begin();
-        auto resultEnd = resultSetIt->end();
-        for(; resultIt != resultEnd; ++resultIt)
-        {
-            // Depends on attributeName
-            if(u::contains(resultIt->_config.referencedAttributeNames(), attributeName))
-            {
-                resultSetIt->erase(resultIt, resultEnd);
-                break;
-            }
-
-            // Creates attributeName
-            if(u::contains(resultIt->_newAttributes, attributeName))
-            {
-                resultSetIt->erase(resultIt, resultEnd);
-                break;
-            }
-        }
-
-        // All subsequent results are now also invalid
-        if(resultIt != resultEnd)
-        {
-            _cache.erase(resultSetIt, resultSetEnd);
-            break;
-        }
-    }
+        return u::contains(result._newAttributes, attributeName);
+    };
+
+    _results.erase(std::remove_if(_results.begin(), _results.end(),
+        createsAttribute), _results.end());
+    _retiredResults.erase(std::remove_if(_retiredResults.begin(), _retiredResults.end(),
+        createsAttribute), _retiredResults.end());
 }
 
-TransformCache::Result TransformCache::apply(const GraphTransformConfig& config, TransformedGraph& graph)
+void TransformCache::retire(TransformCache&& other)
 {
-    TransformCache::Result result;
-    result._config = config;
+    std::deque<Result> retiredResults;
+
+    for(auto& result : other._results)
+        retiredResults.emplace_front(std::move(result));
+
+    for(auto& result : other._retiredResults)
+        retiredResults.emplace_back(std::move(result));
 
-    if(_cache.empty())
-        return result;
+    for(auto& result : _retiredResults)
+        retiredResults.emplace_back(std::move(result));
 
-    auto& resultSet = _cache.front();
+    if(retiredResults.size() > MaxRetiredResults)
+        retiredResults.resize(MaxRetiredResults);
 
-    auto it = std::find_if(resultSet.begin(), resultSet.end(),
-    [&](const auto& cachedResult)
+    _retiredResults = std::move(retiredResults);
+    other.clear();
+}
+
+bool TransformCache::apply(TransformCache::Result& result, TransformedGraph& graph)
+{
+    auto hasSameInputs = [&result](const auto& cachedResult)
     {
-        return cachedResult._config == config;
-    });
+        return cachedResult.hasSameInputsAs(result);
+    };
 
-    if(it != resultSet.end())
+    auto applyFrom = [this, &result, &graph](auto& results, auto it)
     {
         auto& cachedResult = *it;
 
         // Apply the cached result
         _graphModel->addAttributes(cachedResult._newAttributes);
-        if(cachedResult._graph != nullptr)
-            graph = *(cachedResult._graph);
+        if(cachedResult.changesGraph())
+            graph.replay(*cachedResult._graphChanges);
 
         result = std::move(cachedResult);
+        results.erase(it);
+    };
 
-        if(result._graph != nullptr)
-        {
-            // If the graph was changed, remove the entire set...
-            _cache.erase(_cache.begin());
-        }
-        else
-        {
-            // ...otherwise just remove the specific result
-            resultSet.erase(it);
-
-            // If that was the last result, remove the set as well
-            if(resultSet.empty())
-                _cache.erase(_cache.begin());
-        }
+    auto it = std::find_if(_results.begin(), _results.end(), hasSameInputs);
+    if(it != _results.end())
+    {
+        applyFrom(_results, it);
+        return true;
     }
 
-    return result;
+    auto retiredIt = std::find_if(_retiredResults.begin(), _retiredResults.end(), hasSameInputs);
+    if(retiredIt != _retiredResults.end())
+    {
+        applyFrom(_retiredResults, retiredIt);
+        return true;
+    }
+
+    return false;
 }
 
-const MutableGraph* TransformCache::graph() const
+void TransformCache::replayGraphChanges(TransformedGraph& graph) const
 {
-    // Return the last graph in the cache
-    for(const auto& resultSet : make_iterator_range(_cache.rbegin(), _cache.rend()))
+    for(const auto& cachedResult : _results)
     {
-        const auto& cachedResults = make_iterator_range(resultSet.rbegin(), resultSet.rend());
-        auto it = std::find_if(cachedResults.begin(), cachedResults.end(),
-        [](const auto& cachedResult)
-        {
-            return cachedResult._graph != nullptr;
-        });
-
-        if(it != cachedResults.end())
-            return it->_graph.get();
+        if(cachedResult.changesGraph())
+            graph.replay(*cachedResult._graphChanges);
     }
-
-    return nullptr;
 }
 
 std::map<QString, Attribute> TransformCache::attributes() const
 {
     std::map<QString, Attribute> map;
 
-    for(const auto& resultSet : _cache)
+    for(const auto& cachedResult : _results)
     {
-        for(const auto& cachedResult : resultSet)
-        {
-            const auto& newAttributes = cachedResult._newAttributes;
-            map.insert(newAttributes.begin(), newAttributes.end());
-        }
+        const auto& newAttributes = cachedResult._newAttributes;
+        map.insert(newAttributes.begin(), newAttributes.end());
     }
 
     return map;
@@ -20,11 +20,15 @@
 #define TRANSFORMCACHE_H
 
 #include "graphtransformconfig.h"
+#include "transforminfo.h"
 #include "attributes/attribute.h"
+#include "graph/mutablegraph.h"
 
+#include <map>
+#include <memory>
 #include <vector>
+#include <deque>
 
-class MutableGraph;
 class TransformedGraph;
 class GraphModel;
 
@@ -33,51 +37,58 @@ class TransformCache
 public:
     struct Result
     {
-        Result() = default;
+        bool changesGraph() const { return _graphChanges != nullptr; }
 
-        Result(const Result& other) :
-            _config(other._config),
-            _graph(other._graph ? std::make_unique<MutableGraph>(*other._graph) : nullptr),
-            _newAttributes(other._newAttributes)
-        {}
-
-        Result(Result&& other) noexcept :
-            _config(std::move(other._config)),
-            _graph(std::move(other._graph)),
-            _newAttributes(std::move(other._newAttributes))
-        {}
-
-        Result& operator=(Result&& other) noexcept
+        std::vector<QString> referencedAttributeNames() const
         {
-            _config = std::move(other._config);
-            _graph = std::move(other._graph);
-            _newAttributes = std::move(other._newAttributes);
-
-            return *this;
+            return _config.referencedAttributeNames();
         }
 
-        bool changesGraph() const { return _graph != nullptr; }
-        bool isApplicable() const { return changesGraph() || !_newAttributes.empty(); }
-
-        std::vector<QString> referencedAttributeNames() const
+        bool hasSameInputsAs(const Result& other) const
         {
-            return _config.referencedAttributeNames();
+            return _config == other._config &&
+                _inputGraphId == other._inputGraphId &&
+                _inputAttributeIds == other._inputAttributeIds;
         }
 
+        // Uniquely identifies the outputs of this result; later results
+        // record it as an input when they consume those outputs
+        int _id = 0;
+
         GraphTransformConfig _config;
-        std::unique_ptr<MutableGraph> _graph;
+
+        // The result that produced the graph this result was computed from, or 0
+        // if it was computed directly from the source graph
+        int _inputGraphId = 0;
+
+        // For each referenced attribute, the result that created it, or 0 if
+        // it wasn't created by a transform
+        std::map<QString, int> _inputAttributeIds;
+
+        // Rather than a copy of the resultant graph, the changes that the transform
+        // made to its input are stored; these are immutable, so are shared between
+        // copies of the cache
+        std::shared_ptr<const MutableGraph::Journal> _graphChanges;
+
         std::map<QString, Attribute> _newAttributes;
-    };
 
-    using ResultSet = std::vector<Result>;
+        // Alerts raised when the result was computed, so they can be restored on reuse
+        TransformInfo _info;
+    };
 
 private:
-    bool lastResultChangesGraph() const;
-    bool lastResultCreatedAnyOf(const std::vector<QString>& attributeNames) const;
-    std::vector<QString> attributesCreatedByLastResult() const;
-
     GraphModel* _graphModel;
-    std::vector<ResultSet> _cache;
+    std::vector<Result> _results;
+
+    // Results that are no longer part of the pipeline, most recent first; these
+    // are kept so that returning to an earlier configuration (e.g. by undoing)
+    // can reuse them instead of re-executing the transforms
+    std::deque<Result> _retiredResults;
+    static constexpr size_t MaxRetiredResults = 16;
+
+    // The outputs of the results added so far
+    int _graphId = 0;
+    std::map<QString, int> _attributeIds;
 
 public:
     explicit TransformCache(GraphModel& graphModel);
@@ -85,13 +96,25 @@ public:
     TransformCache(TransformCache&& other) noexcept = default;
     TransformCache& operator=(TransformCache&& other) noexcept;
 
-    bool empty() const { return _cache.empty(); }
-    void clear() { _cache.clear(); }
+    bool empty() const { return _results.empty(); }
+    void clear();
+
+    // Creates an empty result for config, whose inputs are the outputs of
+    // the results that have been added so far
+    Result resultFor(const GraphTransformConfig& config) const;
+
     void add(Result&& result);
     void attributeAdded(const QString& attributeName);
-    Result apply(const GraphTransformConfig& config, TransformedGraph& graph);
 
-    const MutableGraph* graph() const;
+    // Keeps any results of other that weren't reused, so that they can be later
+    void retire(TransformCache&& other);
+
+    // If a result with the same inputs is cached, it is applied to
+    // graph, moved into result and true is returned
+    bool apply(Result& result, TransformedGraph& graph);
+
+    // Replays the changes made to the graph by every cached result, in order
+    void replayGraphChanges(TransformedGraph& graph) const;
     std::map<QString, Attribute> attributes() const;
 };
 
@@ -25,23 +25,20 @@
 #include "shared/utils/container.h"
 
 #include <functional>
+#include <algorithm>
 
 TransformedGraph::TransformedGraph(GraphModel& graphModel, const MutableGraph& source) :
     _graphModel(&graphModel),
     _source(&source),
     _cache(graphModel),
+    _cacheRevision(source.revision()),
     _cancelled(false),
     _nodesState(source),
     _edgesState(source),
     _previousNodesState(source),
     _previousEdgesState(source)
 {
-    connect(_source, &Graph::graphChanged, [this]
-    {
-        // If the source graph changes at all, our cache is invalid
-        _cache.clear();
-        rebuild();
-    });
+    connect(_source, &Graph::graphChanged, [this] { onSourceGraphChanged(); });
 
     connect(&_target, &Graph::graphChanged, this, &TransformedGraph::onTargetGraphChanged, Qt::DirectConnection);
     enableComponentManagement();
@@ -61,6 +58,38 @@ TransformedGraph::TransformedGraph(GraphModel& graphModel, const MutableGraph& s
     addTransform(std::make_unique<IdentityTransform>());
 }
 
+void TransformedGraph::onSourceGraphChanged()
+{
+    auto revision = _source->revision();
+
+    if(revision != _cacheRevision)
+    {
+        // If the source graph changes at all, our cache is invalid...
+        if(!_cache.empty())
+        {
+            _cachesForRevisions.emplace_front(_cacheRevision, std::move(_cache));
+
+            if(_cachesForRevisions.size() > MaxCachesForRevisions)
+                _cachesForRevisions.pop_back();
+        }
+
+        _cache = TransformCache(*_graphModel);
+        _cacheRevision = revision;
+
+        // ...unless it has been in its current state before
+        auto it = std::find_if(_cachesForRevisions.begin(), _cachesForRevisions.end(),
+            [revision](const auto& cacheForRevision) { return cacheForRevision.first == revision; });
+
+        if(it != _cachesForRevisions.end())
+        {
+            _cache = std::move(it->second);
+            _cachesForRevisions.erase(it);
+        }
+    }
+
+    rebuild();
+}
+
 void TransformedGraph::cancelRebuild()
 {
     std::unique_lock<std::mutex> lock(_currentTransformMutex);
@@ -90,6 +119,12 @@ TransformedGraph& TransformedGraph::operator=(const MutableGraph& other)
     return *this;
 }
 
+void TransformedGraph::replay(const MutableGraph::Journal& journal)
+{
+    _target.replay(journal);
+    Graph::reserve(_target);
+}
+
 bool TransformedGraph::update()
 {
     _graphChangeOccurred = _target.update() || _graphChangeOccurred;
@@ -140,12 +175,12 @@ void TransformedGraph::rebuild()
         {
             setProgress(-1); // Indetermindate by default
 
-            TransformCache::Result result;
-            result._config = transform->config();
+            auto result = newCache.resultFor(transform->config());
 
-            result = _cache.apply(result._config, *this);
-            if(result.isApplicable())
+            // Only reapply the transform if its inputs have changed
+            if(_cache.apply(result, *this))
             {
+                transform->restoreCachedInfo(result._info);
                 newCreatedAttributeNames[transform->index()] = u::keysFor(result._newAttributes);
                 newCache.add(std::move(result));
                 continue;
@@ -157,14 +192,14 @@ void TransformedGraph::rebuild()
 
             setCurrentTransform(transform.get());
             transform->uncancel();
+            transform->resetInfo();
 
-            if(transform->applyAndUpdate(*this, *_graphModel))
-            {
-                result._graph = std::make_unique<MutableGraph>(_target);
+            _target.beginJournal();
+            bool graphChanged = transform->applyAndUpdate(*this, *_graphModel);
+            auto journal = _target.endJournal();
 
-                // Graph has changed, so the cache is now invalid
-                _cache.clear();
-            }
+            if(graphChanged)
+                result._graphChanges = std::make_shared<const MutableGraph::Journal>(std::move(journal));
 
             setCurrentTransform(nullptr);
 
@@ -179,6 +214,9 @@ void TransformedGraph::rebuild()
                 updatedAttributeNames.append(newAttributeName);
             }
 
+            if(transform->info() != nullptr)
+                result._info = *transform->info();
+
             newCreatedAttributeNames[transform->index()] = newAttributeNames;
             newCache.add(std::move(result));
         }
@@ -191,8 +229,8 @@ void TransformedGraph::rebuild()
             // We've been cancelled so rollback to our previous state
             _cache = std::move(oldCache);
             _createdAttributeNames = std::move(oldCreatedAttributeNames);
-            const auto* cachedGraph = _cache.graph();
-            *this = (cachedGraph != nullptr ? *cachedGraph : *_source);
+            *this = *_source;
+            _cache.replayGraphChanges(*this);
 
             // Remove any attributes that were added before the cancel occurred
             for(const auto& attributeName : u::setDifference(_graphModel->attributeNames(), fixedAttributeNames))
@@ -205,6 +243,8 @@ void TransformedGraph::rebuild()
         }
         else
         {
+            // Results that are no longer used are kept in case they're needed again
+            newCache.retire(std::move(_cache));
             _cache = std::move(newCache);
             _createdAttributeNames = std::move(newCreatedAttributeNames);
         }
@@ -37,6 +37,9 @@
 #include <functional>
 #include <atomic>
 #include <mutex>
+#include <deque>
+#include <utility>
+#include <cstdint>
 
 class GraphModel;
 class ICommand;
@@ -88,6 +91,7 @@ public:
 
     void reserve(const Graph& other) override;
     TransformedGraph& operator=(const MutableGraph& other);
+    void replay(const MutableGraph::Journal& journal);
 
     bool update() override;
 
@@ -112,6 +116,15 @@ private:
 
     TransformCache _cache;
 
+    // The cache is only valid for the revision of the source graph it was built
+    // from; the caches of recent revisions are kept, in case the source is
+    // returned to one of them, as happens when a change to it is undone
+    uint64_t _cacheRevision = 0;
+    std::deque<std::pair<uint64_t, TransformCache>> _cachesForRevisions;
+    static constexpr size_t MaxCachesForRevisions = 4;
+
+    void onSourceGraphChanged();
+
     using CreatedAttributeNamesMap = std::map<int, std::vector<QString>>;
     CreatedAttributeNamesMap _createdAttributeNames;
 
@@ -27,6 +27,7 @@ class TransformInfo
 {
 private:
     std::vector<Alert> _alerts;
+    bool _cached = false;
 
 public:
     template<typename... Args>
@@ -36,6 +37,10 @@ public:
     }
 
     auto alerts() const { return _alerts; }
+
+    // True if the transform's result was reused from the cache, rather than recomputed
+    bool cached() const { return _cached; }
+    void setCached(bool cached) { _cached = cached; }
 };
 
 using TransformInfosMap = std::map<int, TransformInfo>;
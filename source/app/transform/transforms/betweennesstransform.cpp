@@ -28,7 +28,6 @@
 #include <stack>
 #include <queue>
 #include <map>
-#include <thread>
 
 void BetweennessTransform::apply(TransformedGraph& target) const
 {
@@ -51,7 +50,7 @@ void BetweennessTransform::apply(TransformedGraph& target) const
     };
 
     std::vector<BetweennessArrays> betweennessArrays(
-        std::thread::hardware_concurrency(),
+        S(ThreadPoolSingleton)->numThreads(),
         BetweennessArrays{target});
 
     concurrent_for(nodeIds.begin(), nodeIds.end(),
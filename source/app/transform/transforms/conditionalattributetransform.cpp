@@ -18,7 +18,7 @@
 
 #include "conditionalattributetransform.h"
 #include "transform/transformedgraph.h"
-#include "attributes/conditionfncreator.h"
+#include "attributes/compiledcondition.h"
 
 #include "graph/graphmodel.h"
 
@@ -55,15 +55,16 @@ void ConditionalAttributeTransform::apply(TransformedGraph& target) const
 
         ElementIdArray<E, QString> newValues(target);
 
-        auto conditionFn = CreateConditionFnFor::elementType<E>(*_graphModel, config()._condition);
-        if(conditionFn == nullptr)
+        CompiledCondition<E> condition(*_graphModel, config()._condition);
+        if(!condition.isValid())
         {
             addAlert(AlertType::Error, QObject::tr("Invalid condition"));
             return;
         }
 
-        for(auto elementId : elementIds)
-            newValues[elementId] = conditionFn(elementId) ? QObject::tr("True") : QObject::tr("False");
+        auto results = condition.evaluate(elementIds);
+        for(size_t i = 0; i < elementIds.size(); i++)
+            newValues[elementIds[i]] = results[i] != 0 ? QObject::tr("True") : QObject::tr("False");
 
         auto& attribute = _graphModel->createAttribute(newAttributeName)
             .setDescription(QObject::tr("An attribute synthesised by the Boolean Attribute transform."));
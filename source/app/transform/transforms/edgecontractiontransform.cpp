@@ -18,7 +18,7 @@
 
 #include "edgecontractiontransform.h"
 #include "transform/transformedgraph.h"
-#include "attributes/conditionfncreator.h"
+#include "attributes/compiledcondition.h"
 #include "graph/graphmodel.h"
 
 #include "shared/utils/string.h"
@@ -29,19 +29,21 @@ void EdgeContractionTransform::apply(TransformedGraph& target) const
 {
     target.setPhase(QObject::tr("Contracting"));
 
-    auto conditionFn = CreateConditionFnFor::edge(*_graphModel, config()._condition);
-    if(conditionFn == nullptr)
+    CompiledCondition<EdgeId> condition(*_graphModel, config()._condition);
+    if(!condition.isValid())
     {
         addAlert(AlertType::Error, QObject::tr("Invalid condition"));
         return;
     }
 
+    const auto& edgeIds = target.edgeIds();
+    auto results = condition.evaluate(edgeIds);
     EdgeIdSet edgeIdsToContract;
 
-    for(auto edgeId : target.edgeIds())
+    for(size_t i = 0; i < edgeIds.size(); i++)
     {
-        if(conditionFn(edgeId))
-            edgeIdsToContract.insert(edgeId);
+        if(results[i] != 0)
+            edgeIdsToContract.insert(edgeIds[i]);
     }
 
     target.mutableGraph().contractEdges(edgeIdsToContract);
@@ -37,6 +37,8 @@
 #include "loading/isaver.h"
 
 #include "layout/forcedirectedlayout.h"
+#include "layout/multilevelforcedirectedlayout.h"
+#include "layout/stresslayout.h"
 #include "layout/layout.h"
 #include "layout/collision.h"
 
@@ -246,6 +248,28 @@ bool Document::commandIsCancelling() const
     return _commandManager.commandIsCancelling();
 }
 
+static QStringList layoutNames()
+{
+    return {QStringLiteral("ForceDirected"), QStringLiteral("MultilevelForceDirected"), QStringLiteral("Stress")};
+}
+
+static std::unique_ptr<LayoutFactory> layoutFactoryForName(const QString& name, GraphModel* graphModel)
+{
+    std::unique_ptr<LayoutFactory> layoutFactory;
+
+    if(name == QStringLiteral("MultilevelForceDirected"))
+        layoutFactory = std::make_unique<MultilevelForceDirectedLayoutFactory>(graphModel);
+    else if(name == QStringLiteral("Stress"))
+        layoutFactory = std::make_unique<StressLayoutFactory>(graphModel);
+    else
+        layoutFactory = std::make_unique<ForceDirectedLayoutFactory>(graphModel);
+
+    layoutFactory->settings().setDeterministic(u::pref("layout/deterministic").toBool(),
+        u::pref("layout/seed").toUInt());
+
+    return layoutFactory;
+}
+
 QString Document::layoutName() const
 {
     if(_layoutThread != nullptr)
@@ -262,6 +286,26 @@ QString Document::layoutDisplayName() const
     return {};
 }
 
+QVariantList Document::availableLayouts() const
+{
+    QVariantList layouts;
+
+    if(_graphModel == nullptr)
+        return layouts;
+
+    for(const auto& name : layoutNames())
+    {
+        auto layoutFactory = layoutFactoryForName(name, _graphModel.get());
+
+        QVariantMap layout;
+        layout.insert(QStringLiteral("name"), name);
+        layout.insert(QStringLiteral("displayName"), layoutFactory->displayName());
+        layouts.append(layout);
+    }
+
+    return layouts;
+}
+
 std::vector<LayoutSetting>& Document::layoutSettings() const
 {
     return _layoutThread->settings();
@@ -392,9 +436,24 @@ void Document::setTransforms(const QStringList& transforms)
     for(const auto& transform : transforms)
         _graphTransformsModel.append(transform);
 
+    emit cachedTransformsChanged();
+
     setSaveRequired();
 }
 
+QVariantList Document::cachedTransforms() const
+{
+    QVariantList cachedTransforms;
+
+    if(_graphModel == nullptr)
+        return cachedTransforms;
+
+    for(int index = 0; index < _graphTransforms.size(); index++)
+        cachedTransforms.append(_graphModel->transformInfoAtIndex(index).cached());
+
+    return cachedTransforms;
+}
+
 void Document::setVisualisations(const QStringList& visualisations)
 {
     _visualisations = visualisations;
@@ -637,7 +696,7 @@ bool Document::openFile(const QUrl& fileUrl, const QString& fileType, QString pl
 
             _graphModel->buildVisualisations(_visualisations);
 
-            //FIXME make use of this when we can switch algorithms = completedLoader->layoutName();
+            _loadedLayoutName = completedLoader->layoutName();
             _loadedLayoutSettings = completedLoader->layoutSettings();
 
             const auto* nodePositions = completedLoader->nodePositions();
@@ -725,6 +784,12 @@ void Document::onPreferenceChanged(const QString& key, const QVariant&)
         // showEdgeText affects the warning state of TextVisualisationChannel
         setVisualisations(_visualisations);
     }
+    else if(_layoutThread != nullptr && (key == QStringLiteral("layout/deterministic") ||
+        key == QStringLiteral("layout/seed")))
+    {
+        _layoutThread->setDeterministic(u::pref("layout/deterministic").toBool(),
+            u::pref("layout/seed").toUInt());
+    }
 }
 
 void Document::onLoadProgress(int percentage)
@@ -755,7 +820,12 @@ void Document::onLoadComplete(const QUrl&, bool success)
     if(!_bookmarks.empty())
         emit bookmarksChanged();
 
-    _layoutThread = std::make_unique<LayoutThread>(*_graphModel, std::make_unique<ForceDirectedLayoutFactory>(_graphModel.get()));
+    // A saved file's layout algorithm takes precedence over the preferred one
+    auto layoutName = !_loadedLayoutName.isEmpty() ? _loadedLayoutName :
+        u::pref("layout/algorithm").toString();
+
+    _layoutThread = std::make_unique<LayoutThread>(*_graphModel,
+        layoutFactoryForName(layoutName, _graphModel.get()));
 
     for(const auto& layoutSetting : _loadedLayoutSettings)
         _layoutThread->setSettingValue(layoutSetting._name, layoutSetting._value);
@@ -2159,7 +2229,7 @@ bool Document::hasVisualisationInfo() const
 QVariantMap Document::visualisationInfoAtIndex(int index) const
 {
     QVariantMap map;
-    QVariantList numericValues;
+    QVariantMap numericStatistics;
     QVariantList stringValues;
 
     map.insert(QStringLiteral("alertType"), static_cast<int>(AlertType::None));
@@ -2169,7 +2239,7 @@ QVariantMap Document::visualisationInfoAtIndex(int index) const
     map.insert(QStringLiteral("mappedMinimumNumericValue"), 0.0);
     map.insert(QStringLiteral("mappedMaximumNumericValue"), 1.0);
     map.insert(QStringLiteral("hasNumericRange"), true);
-    map.insert(QStringLiteral("numericValues"), numericValues);
+    map.insert(QStringLiteral("numericStatistics"), numericStatistics);
     map.insert(QStringLiteral("stringValues"), stringValues);
     map.insert(QStringLiteral("numApplications"), 1);
 
@@ -2185,12 +2255,22 @@ QVariantMap Document::visualisationInfoAtIndex(int index) const
     map.insert(QStringLiteral("hasNumericRange"), visualisationInfo.statistics()._range > 0.0);
     map.insert(QStringLiteral("numApplications"), visualisationInfo.numApplications());
 
-    const auto& numericValuesVector = visualisationInfo.statistics()._values;
-    numericValues.reserve(static_cast<int>(numericValuesVector.size()));
-    for(auto value : numericValuesVector)
-        numericValues.append(value);
+    // The distribution is summarised by a histogram, rather than passing every value
+    const auto& statistics = visualisationInfo.statistics();
+    numericStatistics.insert(QStringLiteral("min"), statistics._min);
+    numericStatistics.insert(QStringLiteral("max"), statistics._max);
+    numericStatistics.insert(QStringLiteral("mean"), statistics._mean);
+    numericStatistics.insert(QStringLiteral("stddev"), statistics._stddev);
+
+    QVariantList histogram;
+    const auto& histogramVector = visualisationInfo.histogram();
+    histogram.reserve(static_cast<int>(histogramVector.size()));
+    for(auto count : histogramVector)
+        histogram.append(static_cast<double>(count));
 
-    map.insert(QStringLiteral("numericValues"), numericValues);
+    numericStatistics.insert(QStringLiteral("histogram"), histogram);
+
+    map.insert(QStringLiteral("numericStatistics"), numericStatistics);
 
     const auto& stringValuesVector = visualisationInfo.stringValues();
     stringValues.reserve(static_cast<int>(stringValuesVector.size()));
@@ -2396,6 +2476,22 @@ void Document::resetLayoutSettingValue(const QString& name)
     _layoutThread->resetSettingValue(name);
 }
 
+void Document::setLayoutAlgorithm(const QString& name)
+{
+    if(_layoutThread == nullptr || name == layoutName() || !layoutNames().contains(name))
+        return;
+
+    _layoutThread->setLayoutFactory(layoutFactoryForName(name, _graphModel.get()));
+    u::setPref(QStringLiteral("layout/algorithm"), name);
+
+    initialiseLayoutSettingsModel();
+
+    _layoutRequired = true;
+    updateLayoutState();
+
+    emit layoutDisplayNameChanged();
+}
+
 void Document::cancelCommand()
 {
     if(!_loadComplete && _graphFileParserThread != nullptr)
@@ -2746,6 +2842,9 @@ void Document::saveNodePositionsToFile(const QUrl& fileUrl)
     {
         json positions;
 
+        // The renderer may not have taken the layout's latest positions, if it isn't drawing
+        _graphModel->nodePositions().acquire();
+
         uint64_t i = 0;
         for(auto nodeId : _graphModel->graph().nodeIds())
         {
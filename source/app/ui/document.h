@@ -97,7 +97,9 @@ class Document : public QObject, public IDocument, public FailureReason
     Q_PROPERTY(bool commandIsCancelling READ commandIsCancelling NOTIFY commandIsCancellingChanged)
 
     Q_PROPERTY(QML_ENUM_PROPERTY(LayoutPauseState) layoutPauseState READ layoutPauseState NOTIFY layoutPauseStateChanged)
+    Q_PROPERTY(QString layoutName READ layoutName NOTIFY layoutDisplayNameChanged)
     Q_PROPERTY(QString layoutDisplayName READ layoutDisplayName NOTIFY layoutDisplayNameChanged)
+    Q_PROPERTY(QVariantList availableLayouts READ availableLayouts NOTIFY layoutDisplayNameChanged)
 
     Q_PROPERTY(bool canUndo READ canUndo NOTIFY canUndoChanged)
     Q_PROPERTY(QString nextUndoAction READ nextUndoAction NOTIFY nextUndoActionChanged)
@@ -108,6 +110,7 @@ class Document : public QObject, public IDocument, public FailureReason
     Q_PROPERTY(bool canEnterOverviewMode READ canEnterOverviewMode NOTIFY canEnterOverviewModeChanged)
 
     Q_PROPERTY(QQmlVariantListModel* transforms READ transformsModel CONSTANT)
+    Q_PROPERTY(QVariantList cachedTransforms READ cachedTransforms NOTIFY cachedTransformsChanged)
     Q_PROPERTY(QQmlVariantListModel* visualisations READ visualisationsModel CONSTANT)
     Q_PROPERTY(QQmlVariantListModel* layoutSettings READ settingsModel CONSTANT)
 
@@ -172,6 +175,7 @@ public:
 
     QString layoutName() const;
     QString layoutDisplayName() const;
+    QVariantList availableLayouts() const;
     std::vector<LayoutSetting>& layoutSettings() const;
     void updateLayoutDimensionality();
     void updateLayoutState();
@@ -192,6 +196,9 @@ public:
     QStringList transforms() const { return _graphTransforms; }
     void setTransforms(const QStringList& transforms);
 
+    // For each transform, whether its previous result was reused
+    QVariantList cachedTransforms() const;
+
     QQmlObjectListModel<EnrichmentTableModel>* enrichmentTableModels()
     { return &_enrichmentTableModels; }
 
@@ -270,6 +277,7 @@ private:
     QByteArray _pluginUiData;
     int _pluginUiDataVersion = -1;
 
+    QString _loadedLayoutName;
     std::vector<LayoutSettingKeyValue> _loadedLayoutSettings;
     std::unique_ptr<ExactNodePositions> _startingNodePositions;
     bool _userLayoutPaused = false; // true if the user wants the layout to pause
@@ -334,6 +342,7 @@ signals:
     void graphWillChange(const Graph* graph);
     void graphChanged(const Graph* graph, bool changeOccurred);
     void graphChangingChanged();
+    void cachedTransformsChanged();
 
     void commandInProgressChanged();
     void commandProgressChanged();
@@ -496,6 +505,7 @@ public:
     Q_INVOKABLE void setLayoutSettingValue(const QString& name, float value);
     Q_INVOKABLE void setLayoutSettingNormalisedValue(const QString& name, float normalisedValue);
     Q_INVOKABLE void resetLayoutSettingValue(const QString& name);
+    Q_INVOKABLE void setLayoutAlgorithm(const QString& name);
 
     Q_INVOKABLE void cancelCommand();
 
@@ -36,6 +36,7 @@
 #include "maths/frustum.h"
 
 #include "layout/collision.h"
+#include "layout/nodebvh.h"
 
 #include "ui/visualisations/elementvisual.h"
 
@@ -52,19 +53,28 @@ NodeIdSet nodeIdsInsideFrustum(const GraphModel& graphModel,
 {
     NodeIdSet selection;
 
-    const auto* component = graphModel.graph().componentById(componentId);
-    Q_ASSERT(component != nullptr);
-
-    for(NodeId nodeId : component->nodeIds())
+    auto testNode = [&](NodeId nodeId, const QVector3D& nodePosition)
     {
         if(graphModel.nodeVisual(nodeId).state().test(VisualFlags::Unhighlighted))
-            continue;
+            return;
 
-        const QVector3D nodePosition = graphModel.nodePositions().get(nodeId);
         if(frustum.containsPoint(nodePosition))
             selection.insert(nodeId);
+    };
+
+    auto bvh = graphModel.nodeBVH(componentId);
+    if(bvh != nullptr)
+    {
+        bvh->forEachNodeInFrustum(frustum, testNode);
+        return selection;
     }
 
+    const auto* component = graphModel.graph().componentById(componentId);
+    Q_ASSERT(component != nullptr);
+
+    for(NodeId nodeId : component->nodeIds())
+        testNode(nodeId, graphModel.nodePositions().get(nodeId));
+
     return selection;
 }
 
@@ -46,7 +46,8 @@ Window
     // changing
     property int visualisationIndex
 
-    property var values: []
+    // min, max, mean, stddev and histogram of the values
+    property var statistics: ({})
     property bool invert: false
 
     property double _minimumValue: 0.0
@@ -83,10 +84,10 @@ Window
             exponentSlider.value = Math.log2(mapping.exponent);
     }
 
-    onValuesChanged:
+    onStatisticsChanged:
     {
-        _minimumValue = Math.min.apply(null, values);
-        _maximumValue = Math.max.apply(null, values);
+        _minimumValue = statistics.min !== undefined ? statistics.min : 0.0;
+        _maximumValue = statistics.max !== undefined ? statistics.max : 0.0;
 
         setup();
     }
@@ -261,7 +262,7 @@ Window
                 Layout.fillWidth: true
                 Layout.fillHeight: true
 
-                values: root.values
+                statistics: root.statistics
                 invert: root.invert
                 exponent: root._exponent
 
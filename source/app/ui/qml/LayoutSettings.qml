@@ -74,7 +74,34 @@ Rectangle
 
             RowLayout
             {
-                Label { font.bold: true; text: document.layoutDisplayName }
+                ComboBox
+                {
+                    id: algorithmComboBox
+
+                    Layout.fillWidth: true
+
+                    model: document.availableLayouts
+                    textRole: "displayName"
+
+                    currentIndex:
+                    {
+                        var layouts = document.availableLayouts;
+                        for(var i = 0; i < layouts.length; i++)
+                        {
+                            if(layouts[i].name === document.layoutName)
+                                return i;
+                        }
+
+                        return -1;
+                    }
+
+                    onActivated:
+                    {
+                        root.document.setLayoutAlgorithm(model[index].name);
+                        root.valueChanged();
+                    }
+                }
+
                 Item { Layout.fillWidth: true }
                 FloatingButton { action: closeAction }
             }
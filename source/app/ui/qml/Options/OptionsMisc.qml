@@ -42,6 +42,15 @@ Item
         property alias autoBackgroundUpdateCheck: autoBackgroundUpdateCheckCheckbox.checked
     }
 
+    Preferences
+    {
+        id: layout
+        section: "layout"
+
+        property alias deterministic: deterministicLayoutCheckbox.checked
+        property alias seed: layoutSeedSpinBox.value
+    }
+
     Preferences
     {
         id: tracking
@@ -108,6 +117,29 @@ Item
             text: qsTr("Disable Extended Help Tooltips")
         }
 
+        Label
+        {
+            font.bold: true
+            text: qsTr("Layout")
+        }
+
+        RowLayout
+        {
+            CheckBox
+            {
+                id: deterministicLayoutCheckbox
+                text: qsTr("Reproducible Layouts, With Seed:")
+            }
+
+            SpinBox
+            {
+                id: layoutSeedSpinBox
+                enabled: deterministicLayoutCheckbox.checked
+                minimumValue: 0
+                maximumValue: 999999
+            }
+        }
+
         Label
         {
             font.bold: true
@@ -72,6 +72,14 @@ Item
             visible: root.pinned
         }
 
+        NamedIcon
+        {
+            iconName: "view-refresh"
+            visible: root.cached
+
+            ToolTip { text: qsTr("The previous result of this transform was reused") }
+        }
+
         RowLayout
         {
             id: expression
@@ -275,6 +283,8 @@ Item
     }
 
     property int index: -1
+    property bool cached: index >= 0 && index < document.cachedTransforms.length &&
+        document.cachedTransforms[index]
     property string value
     onValueChanged:
     {
@@ -367,7 +367,7 @@ Item
                     onTriggered:
                     {
                         mappingSelector.visualisationIndex = index;
-                        mappingSelector.values = root._visualisationInfo.numericValues;
+                        mappingSelector.statistics = root._visualisationInfo.numericStatistics;
                         mappingSelector.invert = isFlagSet("invert");
 
                         if(parameters.mapping !== undefined)
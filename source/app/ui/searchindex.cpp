@@ -0,0 +1,155 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "searchindex.h"
+
+#include "graph/graph.h"
+#include "attributes/attributecolumn.h"
+
+#include "shared/utils/threadpool.h"
+
+#include <algorithm>
+
+std::vector<SearchIndex::Trigram> SearchIndex::trigramsOf(const QString& value)
+{
+    std::vector<Trigram> trigrams;
+
+    // Folding makes the index case insensitive
+    const auto folded = value.toCaseFolded();
+
+    if(folded.size() < 3)
+        return trigrams;
+
+    trigrams.reserve(static_cast<size_t>(folded.size() - 2));
+    for(int i = 0; i < folded.size() - 2; i++)
+    {
+        trigrams.emplace_back(
+            (static_cast<Trigram>(folded.at(i).unicode()) << 32) |
+            (static_cast<Trigram>(folded.at(i + 1).unicode()) << 16) |
+            static_cast<Trigram>(folded.at(i + 2).unicode()));
+    }
+
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+    return trigrams;
+}
+
+void SearchIndex::clear()
+{
+    _version = std::numeric_limits<uint64_t>::max();
+    _values.clear();
+    _postings.clear();
+    _numIndexedNodes = 0;
+    _numStaleNodes = 0;
+}
+
+void SearchIndex::update(const Graph& graph, const AttributeColumn<NodeId>& column)
+{
+    if(column.version() == _version)
+        return;
+
+    // Postings are never removed individually, so when too many of them refer to
+    // values that are no longer current, it's cheaper to start again
+    if(_numStaleNodes > _numIndexedNodes / 2)
+        clear();
+
+    _version = column.version();
+    _values.resize(static_cast<size_t>(static_cast<int>(graph.nextNodeId())));
+
+    const auto& nodeIds = graph.nodeIds();
+    if(nodeIds.empty())
+        return;
+
+    struct Change
+    {
+        bool _changed = false;
+        bool _wasIndexed = false;
+        std::vector<Trigram> _trigrams;
+    };
+
+    std::vector<Change> changes(nodeIds.size());
+
+    // Finding the changed values and their trigrams is the bulk of the work, so do it concurrently
+    concurrent_for(nodeIds.begin(), nodeIds.end(),
+    [&](std::vector<NodeId>::const_iterator it)
+    {
+        auto nodeId = *it;
+        auto& change = changes[static_cast<size_t>(std::distance(nodeIds.begin(), it))];
+        auto& indexedValue = _values[static_cast<size_t>(static_cast<int>(nodeId))];
+        auto value = column.stringValueOf(nodeId);
+
+        if(value == indexedValue)
+            return;
+
+        change._changed = true;
+        change._wasIndexed = !indexedValue.isEmpty();
+        change._trigrams = trigramsOf(value);
+        indexedValue = value;
+    });
+
+    for(size_t i = 0; i < nodeIds.size(); i++)
+    {
+        const auto& change = changes[i];
+
+        if(!change._changed)
+            continue;
+
+        if(change._wasIndexed)
+            _numStaleNodes++;
+        else
+            _numIndexedNodes++;
+
+        for(auto trigram : change._trigrams)
+            _postings[trigram].emplace_back(nodeIds[i]);
+    }
+}
+
+bool SearchIndex::findCandidates(const QString& term, NodeIdBitSet& candidates) const
+{
+    auto trigrams = trigramsOf(term);
+
+    if(trigrams.empty())
+        return false;
+
+    std::vector<const std::vector<NodeId>*> postings;
+    postings.reserve(trigrams.size());
+
+    for(auto trigram : trigrams)
+    {
+        auto it = _postings.find(trigram);
+
+        // No value contains this trigram, so nothing can match
+        if(it == _postings.end())
+            return true;
+
+        postings.emplace_back(&it->second);
+    }
+
+    // Starting with the rarest trigram keeps the intersection small
+    std::sort(postings.begin(), postings.end(),
+    [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+    NodeIdBitSet intersection(*postings.front());
+    for(auto it = postings.begin() + 1; it != postings.end() && !intersection.empty(); ++it)
+        intersection &= NodeIdBitSet(**it);
+
+    candidates |= intersection;
+
+    return true;
+}
@@ -0,0 +1,67 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include "shared/graph/elementid.h"
+#include "shared/graph/elementid_bitset.h"
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
+
+#include <QString>
+
+class Graph;
+template<typename E> class AttributeColumn;
+
+// A trigram index over the values of a node attribute, used to narrow down the
+// nodes that can possibly contain a search term; the nodes it yields must still
+// be checked against the term, as the index is case insensitive and may contain
+// nodes whose values have since changed
+class SearchIndex
+{
+private:
+    using Trigram = uint64_t;
+
+    uint64_t _version = std::numeric_limits<uint64_t>::max();
+
+    // The values as they were when they were last indexed, indexed by NodeId
+    std::vector<QString> _values;
+
+    std::unordered_map<Trigram, std::vector<NodeId>> _postings;
+    size_t _numIndexedNodes = 0;
+    size_t _numStaleNodes = 0;
+
+    static std::vector<Trigram> trigramsOf(const QString& value);
+
+    void clear();
+
+public:
+    // Brings the index up to date with column; only the nodes whose values
+    // have changed since the last update are (re)indexed
+    void update(const Graph& graph, const AttributeColumn<NodeId>& column);
+
+    // Adds the nodes whose values may contain term to candidates, returning
+    // false if the term is too short for the index to narrow anything down
+    bool findCandidates(const QString& term, NodeIdBitSet& candidates) const;
+};
+
+#endif // SEARCHINDEX_H
@@ -21,8 +21,10 @@
 #include "graph/graph.h"
 #include "graph/graphmodel.h"
 #include "attributes/conditionfncreator.h"
+#include "attributes/attributecolumn.h"
 
 #include "shared/utils/container.h"
+#include "shared/utils/threadpool.h"
 
 #include <QRegularExpression>
 
@@ -46,16 +48,29 @@ void SearchManager::findNodes(QString term, Flags<FindOptions> options,
         return;
     }
 
-    NodeIdSet foundNodeIds;
+    NodeIdBitSet foundNodeIds;
+
+    auto nodeAttributeNames = _graphModel->attributeNames(ElementType::Node);
 
     // If no attributes are specified, search them all
     if(_attributeNames.empty())
     {
-        for(auto& attributeName : _graphModel->attributeNames(ElementType::Node))
+        for(auto& attributeName : nodeAttributeNames)
             _attributeNames.append(attributeName);
     }
 
+    // Discard the indexes of attributes that no longer exist
+    for(auto it = _indexes.begin(); it != _indexes.end();)
+    {
+        if(!u::contains(nodeAttributeNames, it->first))
+            it = _indexes.erase(it);
+        else
+            ++it;
+    }
+
     std::vector<Attribute> attributes;
+    QStringList searchableAttributeNames;
+    std::vector<std::shared_ptr<const AttributeColumn<NodeId>>> columns;
     for(auto& attributeName : _attributeNames)
     {
         auto attribute = _graphModel->attributeValueByName(attributeName);
@@ -64,9 +79,16 @@ void SearchManager::findNodes(QString term, Flags<FindOptions> options,
             attribute.elementType() == ElementType::Node)
         {
             attributes.emplace_back(attribute);
+            searchableAttributeNames.append(attributeName);
+            columns.emplace_back(_graphModel->materialisedNodeAttribute(attributeName));
         }
     }
 
+    // The columns are unavailable while the graph is changing, in which case
+    // the values are read (serially) from the attributes themselves instead
+    bool useColumns = std::none_of(columns.begin(), columns.end(),
+        [](const auto& column) { return column == nullptr; });
+
     // None of the given attributes are searchable
     if(!_attributeNames.empty() && attributes.empty())
     {
@@ -97,57 +119,118 @@ void SearchManager::findNodes(QString term, Flags<FindOptions> options,
 
     if(re.isValid())
     {
+        const auto& graph = _graphModel->graph();
+
+        // When the term is matched literally, any match must contain it, so
+        // the indexes can be used to rule out most nodes without matching them
+        bool useCandidates = false;
+        NodeIdBitSet candidates;
+
+        if(useColumns && !attributes.empty() &&
+            (options.test(FindOptions::MatchExact) || !options.test(FindOptions::MatchUsingRegex)))
+        {
+            useCandidates = true;
+
+            for(size_t i = 0; i < attributes.size() && useCandidates; i++)
+            {
+                auto& index = _indexes[searchableAttributeNames.at(static_cast<int>(i))];
+                index.update(graph, *columns.at(i));
+
+                // The term is too short to narrow the search
+                if(!index.findCandidates(_term, candidates))
+                    useCandidates = false;
+            }
+        }
+
         ConditionFnOp::String op = ConditionFnOp::String::MatchesRegex;
         if(reOptions.testFlag(QRegularExpression::CaseInsensitiveOption))
             op = ConditionFnOp::String::MatchesRegexCaseInsensitive;
 
         std::vector<NodeConditionFn> conditionFns;
-        for(auto& attribute : attributes)
+        if(!useColumns)
         {
-            auto conditionFn = CreateConditionFnFor::node(attribute, op, term);
+            for(auto& attribute : attributes)
+            {
+                auto conditionFn = CreateConditionFnFor::node(attribute, op, term);
 
-            if(conditionFn != nullptr)
-                conditionFns.emplace_back(conditionFn);
+                if(conditionFn != nullptr)
+                    conditionFns.emplace_back(conditionFn);
+            }
         }
 
-        for(auto nodeId : _graphModel->graph().nodeIds())
+        auto valueMatches = [&](NodeId nodeId)
+        {
+            if(useColumns)
+            {
+                return std::any_of(columns.begin(), columns.end(),
+                [&re, nodeId](const auto& column)
+                {
+                    return re.match(column->stringValueOf(nodeId)).hasMatch();
+                });
+            }
+
+            return std::any_of(conditionFns.begin(), conditionFns.end(),
+            [nodeId](const auto& conditionFn)
+            {
+                return conditionFn(nodeId);
+            });
+        };
+
+        auto matches = [&](NodeId nodeId)
         {
             // We can't add tail nodes to the results since merge sets can only be found
             // using head nodes... (cont.)
-            if(_graphModel->graph().typeOf(nodeId) == MultiElementType::Tail)
-                continue;
+            if(graph.typeOf(nodeId) == MultiElementType::Tail)
+                return false;
 
-            const auto& mergedNodeIds = _graphModel->graph().mergedNodeIdsForNodeId(nodeId);
-            bool match = false;
+            const auto& mergedNodeIds = graph.mergedNodeIdsForNodeId(nodeId);
 
             // Fall back on a node name search if there are no attributes provided
-            if(attributes.empty())
-                match = re.match(_graphModel->nodeNames().at(nodeId)).hasMatch();
+            if(attributes.empty() && re.match(_graphModel->nodeNames().at(nodeId)).hasMatch())
+                return true;
 
-            if(!match)
+            // ...but we still match against the tails... (cont.)
+            return std::any_of(mergedNodeIds.begin(), mergedNodeIds.end(),
+            [&](auto mergedNodeId)
             {
-                match = std::any_of(conditionFns.begin(), conditionFns.end(),
-                [&mergedNodeIds](const auto& conditionFn)
-                {
-                    // ...but we still match against the tails... (cont.)
-                    return std::any_of(mergedNodeIds.begin(), mergedNodeIds.end(),
-                    [&conditionFn](auto mergedNodeId)
-                    {
-                       return conditionFn(mergedNodeId);
-                    });
-                });
-            }
+                if(useCandidates && !candidates.contains(mergedNodeId))
+                    return false;
+
+                return valueMatches(mergedNodeId);
+            });
+        };
+
+        const auto& nodeIds = graph.nodeIds();
+        std::vector<uint8_t> nodeMatches(nodeIds.size(), 0);
 
-            if(match)
+        // Reading from the columns (or the node names) is safe to do concurrently
+        if(!nodeIds.empty() && (useColumns || attributes.empty()))
+        {
+            concurrent_for(nodeIds.begin(), nodeIds.end(),
+            [&](std::vector<NodeId>::const_iterator it)
             {
-                // ...so that the entire merge set of the head is found, even if
-                // it's only a subset of the merge set that actually matched
-                foundNodeIds.insert(mergedNodeIds.begin(), mergedNodeIds.end());
-            }
+                nodeMatches[static_cast<size_t>(std::distance(nodeIds.begin(), it))] = matches(*it) ? 1 : 0;
+            });
+        }
+        else
+        {
+            for(size_t i = 0; i < nodeIds.size(); i++)
+                nodeMatches[i] = matches(nodeIds[i]) ? 1 : 0;
+        }
+
+        for(size_t i = 0; i < nodeIds.size(); i++)
+        {
+            if(nodeMatches[i] == 0)
+                continue;
+
+            // ...so that the entire merge set of the head is found, even if
+            // it's only a subset of the merge set that actually matched
+            const auto& mergedNodeIds = graph.mergedNodeIdsForNodeId(nodeIds[i]);
+            foundNodeIds.insert(mergedNodeIds.begin(), mergedNodeIds.end());
         }
     }
 
-    bool changed = u::setsDiffer(_foundNodeIds, foundNodeIds);
+    bool changed = _foundNodeIds != foundNodeIds;
 
     _foundNodeIds = std::move(foundNodeIds);
 
@@ -171,5 +254,5 @@ void SearchManager::refresh()
 
 bool SearchManager::SearchManager::nodeWasFound(NodeId nodeId) const
 {
-    return u::contains(_foundNodeIds, nodeId);
+    return _foundNodeIds.contains(nodeId);
 }
@@ -20,15 +20,19 @@
 #define SEARCHMANAGER_H
 
 #include "findoptions.h"
+#include "searchindex.h"
 
 #include "shared/graph/elementid.h"
 #include "shared/graph/elementid_containers.h"
+#include "shared/graph/elementid_bitset.h"
 #include "shared/utils/flags.h"
 
 #include <QObject>
 #include <QString>
 #include <QStringList>
 
+#include <map>
+
 class GraphModel;
 
 // What to select when found nodes changes
@@ -47,7 +51,7 @@ public:
     void clearFoundNodeIds();
     void refresh();
 
-    const NodeIdSet& foundNodeIds() const { return _foundNodeIds; }
+    const NodeIdBitSet& foundNodeIds() const { return _foundNodeIds; }
     bool nodeWasFound(NodeId nodeId) const;
 
     bool active() const { return !_term.isEmpty(); }
@@ -61,7 +65,10 @@ private:
     FindSelectStyle _selectStyle = FindSelectStyle::None;
 
     const GraphModel* _graphModel = nullptr;
-    NodeIdSet _foundNodeIds;
+    NodeIdBitSet _foundNodeIds;
+
+    // Keyed by attribute name; built when an attribute is first searched
+    std::map<QString, SearchIndex> _indexes;
 
 signals:
     void foundNodeIdsChanged(const SearchManager*);
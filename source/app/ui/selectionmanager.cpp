@@ -59,23 +59,26 @@ NodeIdSet SelectionManager::selectedNodes() const
         }));
 #endif
 
-    return _selectedNodeIds;
+    return _selectedNodeIds.toSet();
 }
 
 NodeIdSet SelectionManager::unselectedNodes() const
 {
-    const auto& nodeIds = _graphModel->graph().nodeIds();
-    auto unselectedNodeIds = NodeIdSet(nodeIds.begin(), nodeIds.end());
-    unselectedNodeIds.erase(_selectedNodeIds.begin(), _selectedNodeIds.end());
+    NodeIdSet unselectedNodeIds;
+
+    for(auto nodeId : _graphModel->graph().nodeIds())
+    {
+        if(!_selectedNodeIds.contains(nodeId))
+            unselectedNodeIds.insert(nodeId);
+    }
 
     return unselectedNodeIds;
 }
 
-//FIXME http://en.cppreference.com/w/cpp/container/unordered_set/merge will be useful here
-template<typename C> bool _selectNodes(const GraphModel& graphModel, NodeIdSet& selectedNodeIds,
-    NodeIdSet& mask, const C& nodeIds, bool selectMergedNodes = true)
+template<typename C> bool _selectNodes(const GraphModel& graphModel, NodeIdBitSet& selectedNodeIds,
+    const NodeIdBitSet& mask, const C& nodeIds, bool selectMergedNodes = true)
 {
-    NodeIdSet newSelectedNodeIds;
+    bool selectionWillChange = false;
 
     if(selectMergedNodes)
     {
@@ -88,8 +91,8 @@ template<typename C> bool _selectNodes(const GraphModel& graphModel, NodeIdSet&
 
             for(auto mergedNodeId : mergedNodeIds)
             {
-                if(mask.empty() || u::contains(mask, mergedNodeId))
-                    newSelectedNodeIds.insert(mergedNodeId);
+                if(mask.empty() || mask.contains(mergedNodeId))
+                    selectionWillChange |= selectedNodeIds.insert(mergedNodeId);
             }
         }
     }
@@ -97,14 +100,12 @@ template<typename C> bool _selectNodes(const GraphModel& graphModel, NodeIdSet&
     {
         for(auto nodeId : nodeIds)
         {
-            if(mask.empty() || u::contains(mask, nodeId))
-                newSelectedNodeIds.insert(nodeId);
+            if(mask.empty() || mask.contains(nodeId))
+                selectionWillChange |= selectedNodeIds.insert(nodeId);
         }
     }
 
-    auto oldSize = selectedNodeIds.size();
-    selectedNodeIds.insert(newSelectedNodeIds.begin(), newSelectedNodeIds.end());
-    return selectedNodeIds.size() > oldSize;
+    return selectionWillChange;
 }
 
 bool SelectionManager::selectNodes(const NodeIdSet& nodeIds)
@@ -132,7 +133,7 @@ bool SelectionManager::selectNode(NodeId nodeId)
 }
 
 
-template<typename C> bool _deselectNodes(const GraphModel& graphModel, NodeIdSet& selectedNodeIds,
+template<typename C> bool _deselectNodes(const GraphModel& graphModel, NodeIdBitSet& selectedNodeIds,
     const C& nodeIds, bool deselectMergedNodes = true)
 {
     bool selectionWillChange = false;
@@ -183,14 +184,14 @@ bool SelectionManager::deselectNodes(const std::vector<NodeId>& nodeIds)
     });
 }
 
-template<typename C> void _toggleNodes(NodeIdSet& selectedNodeIds, NodeIdSet& mask, const C& nodeIds)
+template<typename C> void _toggleNodes(NodeIdBitSet& selectedNodeIds, const NodeIdBitSet& mask, const C& nodeIds)
 {
-    NodeIdSet difference;
+    NodeIdBitSet difference;
     for(auto nodeId : nodeIds)
     {
-        if(!u::contains(selectedNodeIds, nodeId))
+        if(!selectedNodeIds.contains(nodeId))
         {
-            if(mask.empty() || u::contains(mask, nodeId))
+            if(mask.empty() || mask.contains(nodeId))
                 difference.insert(nodeId);
         }
     }
@@ -215,7 +216,7 @@ bool SelectionManager::nodeIsSelected(NodeId nodeId) const
 #ifdef EXPENSIVE_DEBUG_CHECKS
     Q_ASSERT(u::contains(_graphModel->graph().nodeIds(), nodeId));
 #endif
-    return u::contains(_selectedNodeIds, nodeId);
+    return _selectedNodeIds.contains(nodeId);
 }
 
 bool SelectionManager::selectAllNodes()
@@ -227,13 +228,7 @@ bool SelectionManager::selectAllNodes()
         // If there is a mask in place, selecting all might actually need some deselection first
         if(!_nodeIdsMask.empty() && !_selectedNodeIds.empty())
         {
-            NodeIdSet deselectedNodeIds;
-            for(auto nodeId : _selectedNodeIds)
-            {
-                if(!u::contains(_nodeIdsMask, nodeId))
-                    deselectedNodeIds.insert(nodeId);
-            }
-
+            auto deselectedNodeIds = _selectedNodeIds - _nodeIdsMask;
             nodesDeselected = _deselectNodes(*_graphModel, _selectedNodeIds, deselectedNodeIds, true);
         }
 
@@ -260,38 +255,36 @@ void SelectionManager::invertNodeSelection()
         emit selectionChanged(this);
 }
 
-void SelectionManager::setNodesMask(const NodeIdSet& nodeIds, bool applyMask)
+void SelectionManager::setNodesMask(const NodeIdBitSet& nodeIds, bool applyMask)
 {
     _nodeIdsMask = nodeIds;
 
     if(applyMask)
     {
-        std::vector<NodeId> nodeIdsToDeselect;
-
-        for(const auto& selectedNodeId : _selectedNodeIds)
-        {
-            if(!u::contains(_nodeIdsMask, selectedNodeId))
-                nodeIdsToDeselect.emplace_back(selectedNodeId);
-        }
-
+        auto nodeIdsToDeselect = u::vectorFrom(_selectedNodeIds - _nodeIdsMask);
         deselectNodes(nodeIdsToDeselect);
     }
 
     emit nodesMaskChanged();
 }
 
+void SelectionManager::setNodesMask(const NodeIdSet& nodeIds, bool applyMask)
+{
+    setNodesMask(NodeIdBitSet(nodeIds), applyMask);
+}
+
 void SelectionManager::setNodesMask(const std::vector<NodeId>& nodeIds, bool applyMask)
 {
-    setNodesMask(NodeIdSet(nodeIds.begin(), nodeIds.end()), applyMask);
+    setNodesMask(NodeIdBitSet(nodeIds), applyMask);
 }
 
 QString SelectionManager::numNodesSelectedAsString() const
 {
-    int selectionSize = static_cast<int>(selectedNodes().size());
+    int selectionSize = numNodesSelected();
 
     if(selectionSize == 1)
     {
-        auto nodeId = *selectedNodes().begin();
+        auto nodeId = *_selectedNodeIds.begin();
         const auto& nodeName = _graphModel->nodeNames()[nodeId];
 
         if(!nodeName.isEmpty())
@@ -20,6 +20,7 @@
 #define SELECTIONMANAGER_H
 
 #include "shared/ui/iselectionmanager.h"
+#include "shared/graph/elementid_bitset.h"
 #include "shared/utils/container.h"
 
 #include <QObject>
@@ -37,6 +38,9 @@ public:
     NodeIdSet selectedNodes() const override;
     NodeIdSet unselectedNodes() const override;
 
+    // The same as selectedNodes(), without the conversion
+    const NodeIdBitSet& selectedNodeIds() const { return _selectedNodeIds; }
+
     bool selectNode(NodeId nodeId) override;
     bool selectNodes(const NodeIdSet& nodeIds) override;
     bool selectNodes(const std::vector<NodeId>& nodeIds);
@@ -53,6 +57,7 @@ public:
     bool clearNodeSelection() override;
     void invertNodeSelection() override;
 
+    void setNodesMask(const NodeIdBitSet& nodeIds, bool applyMask = true);
     void setNodesMask(const NodeIdSet& nodeIds, bool applyMask = true);
     void setNodesMask(const std::vector<NodeId>& nodeIds, bool applyMask = true);
     void clearNodesMask() { _nodeIdsMask.clear(); emit nodesMaskChanged(); }
@@ -66,12 +71,12 @@ public:
 private:
     const GraphModel* _graphModel = nullptr;
 
-    NodeIdSet _selectedNodeIds;
+    NodeIdBitSet _selectedNodeIds;
 
     // Temporary storage for NodeIds that have been deleted
     std::vector<NodeId> _deletedNodes;
 
-    NodeIdSet _nodeIdsMask;
+    NodeIdBitSet _nodeIdsMask;
 
     bool _suppressSignals = false;
 
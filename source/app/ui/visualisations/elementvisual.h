@@ -21,6 +21,17 @@
 
 #include "shared/ui/visualisations/ielementvisual.h"
 
+// Which aspects of ElementVisuals have changed
+enum class VisualChangeFlags
+{
+    None    = 0x0,
+    Size    = 0x1,
+    Color   = 0x2,
+    Text    = 0x4,
+    State   = 0x8,
+    All     = Size|Color|Text|State
+};
+
 struct ElementVisual : IElementVisual
 {
     float _size = -1.0f;
@@ -28,10 +28,16 @@
 #include "shared/graph/grapharray.h"
 #include "shared/utils/utils.h"
 #include "shared/utils/container.h"
+#include "shared/utils/threadpool.h"
 #include "attributes/attribute.h"
+#include "attributes/attributecolumn.h"
 
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
 #include <type_traits>
 
 #include <QCollator>
@@ -60,7 +66,9 @@ private:
         {}
 
         int _index;
-        ElementIdArray<ElementId, bool> _array;
+
+        // Not bool, as std::vector<bool> can't be written to concurrently
+        ElementIdArray<ElementId, uint8_t> _array;
     };
 
     std::array<std::vector<Applied>, NumChannels> _applications;
@@ -99,6 +107,183 @@ private:
         return elementIds(_graph);
     }
 
+    // Below this, e.g. for most components, the work isn't worth distributing over threads
+    static constexpr size_t MinimumConcurrentElements = 10000;
+
+    template<typename Fn>
+    static void parallelFor(const std::vector<ElementId>& elementIds, Fn&& fn)
+    {
+        if(elementIds.size() < MinimumConcurrentElements)
+        {
+            for(auto elementId : elementIds)
+                fn(elementId);
+
+            return;
+        }
+
+        concurrent_for(elementIds.begin(), elementIds.end(), std::forward<Fn>(fn));
+    }
+
+    // As above, but fn is also passed the index of the thread it's called from
+    template<typename Fn>
+    static void parallelForWithThreadIndex(const std::vector<ElementId>& elementIds, Fn&& fn)
+    {
+        if(elementIds.size() < MinimumConcurrentElements)
+        {
+            for(auto it = elementIds.begin(); it != elementIds.end(); ++it)
+                fn(it, 0);
+
+            return;
+        }
+
+        concurrent_for(elementIds.begin(), elementIds.end(), std::forward<Fn>(fn));
+    }
+
+    // Copies the attribute's values into a dense array; this is done concurrently
+    // only when reading from a column, since an attribute's value function is
+    // not necessarily safe to call from multiple threads
+    template<typename T, typename Fn>
+    void gatherValues(const std::vector<ElementId>& elementIds,
+        bool concurrently, ElementIdArray<ElementId, T>& values, Fn&& valueOf) const
+    {
+        if(concurrently)
+        {
+            parallelFor(elementIds, [&values, &valueOf](ElementId elementId)
+            {
+                values[elementId] = valueOf(elementId);
+            });
+        }
+        else
+        {
+            for(auto elementId : elementIds)
+                values[elementId] = valueOf(elementId);
+        }
+    }
+
+    static constexpr size_t NumHistogramBins = 64;
+
+    // Equivalent to u::findStatisticsFor, but computed in two (concurrent, if there are
+    // enough elements) passes; the second also bins the values into a histogram, if one
+    // is requested
+    static u::Statistics findStatisticsFor(const std::vector<ElementId>& elementIds,
+        const ElementIdArray<ElementId, double>& values,
+        std::vector<size_t>* histogram = nullptr)
+    {
+        struct Partial
+        {
+            double _min = std::numeric_limits<double>::max();
+            double _max = std::numeric_limits<double>::lowest();
+            double _sum = 0.0;
+            double _sumSq = 0.0;
+            double _sumDeviationSq = 0.0;
+            size_t _largestIndex = 0u;
+            double _largestValue = 0.0;
+            bool _allPositive = true;
+            std::vector<size_t> _histogram;
+        };
+
+        using It = typename std::vector<ElementId>::const_iterator;
+
+        std::vector<Partial> partials(elementIds.size() < MinimumConcurrentElements ?
+            1 : S(ThreadPoolSingleton)->numThreads());
+
+        u::Statistics s;
+        const auto n = static_cast<double>(elementIds.size());
+
+        parallelForWithThreadIndex(elementIds,
+        [&](It it, size_t threadIndex)
+        {
+            auto& p = partials.at(threadIndex);
+            auto value = values.get(*it);
+
+            p._allPositive = p._allPositive && !std::signbit(value);
+            p._sum += value;
+            p._sumSq += value * value;
+            p._min = std::min(p._min, value);
+            p._max = std::max(p._max, value);
+
+            // Iterators are visited in order within a thread, so this is
+            // the first occurrence, as it is in u::findStatisticsFor
+            if(std::abs(value) > std::abs(p._largestValue))
+            {
+                p._largestIndex = static_cast<size_t>(std::distance(elementIds.begin(), it));
+                p._largestValue = value;
+            }
+        });
+
+        bool allPositive = true;
+        double largestValue = 0.0;
+
+        for(const auto& p : partials)
+        {
+            allPositive = allPositive && p._allPositive;
+            s._sum += p._sum;
+            s._sumSq += p._sumSq;
+            s._min = std::min(s._min, p._min);
+            s._max = std::max(s._max, p._max);
+
+            if(std::abs(p._largestValue) > std::abs(largestValue))
+            {
+                s._largestIndex = p._largestIndex;
+                largestValue = p._largestValue;
+            }
+        }
+
+        s._mean = s._sum / n;
+        s._range = s._max - s._min;
+        s._sumAllSq = s._sum * s._sum;
+        s._variability = std::sqrt((n * s._sumSq) - s._sumAllSq);
+
+        if(histogram != nullptr)
+        {
+            for(auto& p : partials)
+                p._histogram.resize(NumHistogramBins, 0u);
+        }
+
+        parallelForWithThreadIndex(elementIds,
+        [&](It it, size_t threadIndex)
+        {
+            auto& p = partials.at(threadIndex);
+            auto value = values.get(*it);
+
+            auto deviation = value - s._mean;
+            p._sumDeviationSq += deviation * deviation;
+
+            if(histogram == nullptr)
+                return;
+
+            size_t bin = 0;
+            if(s._range > 0.0)
+            {
+                bin = static_cast<size_t>(((value - s._min) / s._range) * NumHistogramBins);
+                bin = std::min(bin, NumHistogramBins - 1);
+            }
+
+            p._histogram[bin]++;
+        });
+
+        double sumDeviationSq = 0.0;
+        for(const auto& p : partials)
+            sumDeviationSq += p._sumDeviationSq;
+
+        s._variance = sumDeviationSq / n;
+        s._stddev = std::sqrt(s._variance);
+        s._coefVar = (allPositive && s._mean > 0.0) ? s._stddev / s._mean : std::nan("1");
+
+        if(histogram != nullptr)
+        {
+            histogram->assign(NumHistogramBins, 0u);
+
+            for(const auto& p : partials)
+            {
+                for(size_t bin = 0; bin < NumHistogramBins; bin++)
+                    (*histogram)[bin] += p._histogram[bin];
+            }
+        }
+
+        return s;
+    }
+
 public:
     void findOverrideAlerts(VisualisationInfosMap& infos)
     {
@@ -142,7 +327,9 @@ public:
         }
     }
 
+    // If column is set, the attribute's values are read from it
     void build(const Attribute& attribute,
+               const AttributeColumn<ElementId>* column,
                const VisualisationChannel& channel,
                const VisualisationConfig& config,
                int index, VisualisationInfo& visualisationInfo)
@@ -156,6 +343,9 @@ public:
             return;
         }
 
+        // Reading from a column is safe to do concurrently
+        const bool concurrently = column != nullptr;
+
         switch(attribute.valueType())
         {
         case ValueType::Int:
@@ -164,9 +354,17 @@ public:
             const bool invert = config.isFlagSet(QStringLiteral("invert"));
             const bool perComponent = config.isFlagSet(QStringLiteral("component"));
 
+            ElementIdArray<ElementId, double> values(*_graph);
+            gatherValues(elementIds(), concurrently, values,
+            [&attribute, column](ElementId elementId)
+            {
+                return column != nullptr ? column->numericValueOf(elementId) :
+                    attribute.numericValueOf(elementId);
+            });
+
             int numApplications = 0;
 
-            auto applyTo = [&](const auto& graph, const u::Statistics& statistics)
+            auto applyTo = [&](const std::vector<ElementId>& ids, const u::Statistics& statistics)
             {
                 if(channel.requiresRange() && statistics._range == 0.0)
                 {
@@ -180,9 +378,9 @@ public:
                 visualisationInfo.setMappedMinimum(mapping.min());
                 visualisationInfo.setMappedMaximum(mapping.max());
 
-                for(auto elementId : elementIds(graph))
+                parallelFor(ids, [&](ElementId elementId)
                 {
-                    double value = attribute.numericValueOf(elementId);
+                    double value = values.get(elementId);
 
                     if(channel.allowsMapping())
                     {
@@ -193,26 +391,30 @@ public:
                     }
 
                     apply(value, channel, elementId, _numAppliedVisualisations);
-                }
+                });
 
                 numApplications++;
             };
 
-            auto statistics = attribute.findStatisticsforElements(elementIds(), true);
+            std::vector<size_t> histogram;
+            auto ids = elementIds();
+            auto statistics = findStatisticsFor(ids, values, &histogram);
 
             if(perComponent)
             {
                 for(auto componentId : _graph->componentIds())
                 {
                     const auto* component = _graph->componentById(componentId);
-                    auto componentStatistics = attribute.findStatisticsforElements(elementIds(component));
-                    applyTo(component, componentStatistics);
+                    auto componentIds = elementIds(component);
+                    auto componentStatistics = findStatisticsFor(componentIds, values);
+                    applyTo(componentIds, componentStatistics);
                 }
             }
             else
-                applyTo(_graph, statistics);
+                applyTo(ids, statistics);
 
             visualisationInfo.setStatistics(statistics);
+            visualisationInfo.setHistogram(histogram);
             visualisationInfo.setNumApplications(numApplications);
 
             if(numApplications > 0)
@@ -223,11 +425,20 @@ public:
 
         case ValueType::String:
         {
-            for(auto elementId : elementIds())
+            auto ids = elementIds();
+
+            ElementIdArray<ElementId, QString> values(*_graph);
+            gatherValues(ids, concurrently, values,
+            [&attribute, column](ElementId elementId)
             {
-                auto stringValue = attribute.stringValueOf(elementId);
-                apply(stringValue, channel, elementId, _numAppliedVisualisations);
-            }
+                return column != nullptr ? column->stringValueOf(elementId) :
+                    attribute.stringValueOf(elementId);
+            });
+
+            parallelFor(ids, [&](ElementId elementId)
+            {
+                apply(values.get(elementId), channel, elementId, _numAppliedVisualisations);
+            });
 
             _numAppliedVisualisations++;
             break;
@@ -33,6 +33,7 @@ class VisualisationInfo
 private:
     std::vector<Alert> _alerts;
     u::Statistics _statistics;
+    std::vector<size_t> _histogram;
     double _mappedMinimum = std::numeric_limits<double>::max();
     double _mappedMaximum = std::numeric_limits<double>::lowest();
     std::vector<QString> _stringValues;
@@ -50,6 +51,10 @@ public:
     const u::Statistics& statistics() const { return _statistics; }
     void setStatistics(const u::Statistics& statistics) { _statistics = statistics; }
 
+    // The number of values in each of a series of equal width bins, spanning the statistics' range
+    const std::vector<size_t>& histogram() const { return _histogram; }
+    void setHistogram(const std::vector<size_t>& histogram) { _histogram = histogram; }
+
     void setMappedMinimum(double mappedMinimum) { _mappedMinimum = mappedMinimum; }
     double mappedMinimum() const { return _mappedMinimum; }
 
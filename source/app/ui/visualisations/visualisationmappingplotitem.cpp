@@ -19,6 +19,7 @@
 #include "visualisationmappingplotitem.h"
 
 #include <cmath>
+#include <algorithm>
 
 VisualisationMappingPlotItem::VisualisationMappingPlotItem(QQuickItem* parent) :
     QCustomPlotQuickItem(parent)
@@ -44,10 +45,23 @@ void VisualisationMappingPlotItem::setRangeToStddev()
     buildPlot();
 }
 
-void VisualisationMappingPlotItem::setValues(const QVector<double>& values)
+void VisualisationMappingPlotItem::setStatistics(const QVariantMap& statistics)
 {
-    _values = values;
-    _statistics = u::findStatisticsFor(_values);
+    _statisticsMap = statistics;
+
+    _statistics = {};
+    _statistics._min = statistics.value(QStringLiteral("min"), 0.0).toDouble();
+    _statistics._max = statistics.value(QStringLiteral("max"), 0.0).toDouble();
+    _statistics._range = _statistics._max - _statistics._min;
+    _statistics._mean = statistics.value(QStringLiteral("mean"), 0.0).toDouble();
+    _statistics._stddev = statistics.value(QStringLiteral("stddev"), 0.0).toDouble();
+
+    _histogram.clear();
+    const auto histogram = statistics.value(QStringLiteral("histogram")).toList();
+    _histogram.reserve(histogram.size());
+    for(const auto& count : histogram)
+        _histogram.append(count.toDouble());
+
     buildPlot();
 }
 
@@ -151,8 +165,8 @@ void VisualisationMappingPlotItem::buildPlot()
     customPlot().plotLayout()->addElement(0, 0, valuesAxisLayout);
 
     auto* valuesAxisRect = new QCPAxisRect(&customPlot());
-    valuesAxisRect->setMinimumSize(10, 0);
-    valuesAxisRect->setMaximumSize(10, 10000);
+    valuesAxisRect->setMinimumSize(20, 0);
+    valuesAxisRect->setMaximumSize(20, 10000);
     valuesAxisLayout->addElement(valuesAxisRect);
     auto* valuesXAxis = valuesAxisRect->axis(QCPAxis::atBottom);
     auto* valuesYAxis = valuesAxisRect->axis(QCPAxis::atLeft);
@@ -162,25 +176,32 @@ void VisualisationMappingPlotItem::buildPlot()
     valuesXAxis->setRange(0.0, 1.0);
     valuesYAxis->setRange(min, max);
 
-    auto* points = new QCPGraph(valuesXAxis, valuesYAxis);
+    if(!_histogram.isEmpty())
+    {
+        // The bars run horizontally, with their length proportional to the count in each bin
+        auto* bars = new QCPBars(valuesYAxis, valuesXAxis);
 
-    QVector<double> px;
-    QVector<double> py;
+        auto binWidth = _statistics._range / _histogram.size();
+        auto maxCount = *std::max_element(_histogram.begin(), _histogram.end());
 
-    px.reserve(_values.size());
-    py.reserve(_values.size());
+        QVector<double> keys;
+        QVector<double> lengths;
 
-    for(int i = 0 ; i < _values.size(); i++)
-    {
-        px.append(0.5);
-        py.append(_values.at(i));
-    }
+        keys.reserve(_histogram.size());
+        lengths.reserve(_histogram.size());
 
-    auto pointColor = QColor(0, 0, 255, 53);
-    points->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle,
-        pointColor, pointColor, 5.0));
-    points->setLineStyle(QCPGraph::lsNone);
-    points->setData(px, py);
+        for(int i = 0; i < _histogram.size(); i++)
+        {
+            keys.append(_statistics._min + ((i + 0.5) * binWidth));
+            lengths.append(maxCount > 0.0 ? _histogram.at(i) / maxCount : 0.0);
+        }
+
+        auto barColor = QColor(0, 0, 255, 128);
+        bars->setPen(Qt::NoPen);
+        bars->setBrush(barColor);
+        bars->setWidth(binWidth);
+        bars->setData(keys, lengths, true);
+    }
 
     QCPMarginGroup *marginGroup = new QCPMarginGroup(&customPlot());
     mainAxisRect->setMarginGroup(QCP::msBottom, marginGroup);
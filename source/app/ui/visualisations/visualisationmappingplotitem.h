@@ -26,13 +26,14 @@
 #include <QObject>
 #include <QQuickPaintedItem>
 #include <QVector>
+#include <QVariantMap>
 
 class VisualisationMappingPlotItem : public QCustomPlotQuickItem
 {
     Q_OBJECT
 
 public:
-    Q_PROPERTY(QVector<double> values MEMBER _values WRITE setValues)
+    Q_PROPERTY(QVariantMap statistics MEMBER _statisticsMap WRITE setStatistics)
     Q_PROPERTY(bool invert MEMBER _invert WRITE setInvert)
     Q_PROPERTY(double exponent MEMBER _exponent WRITE setExponent)
     Q_PROPERTY(double minimum MEMBER _min WRITE setMinimum NOTIFY minimumChanged)
@@ -44,15 +45,16 @@ public:
     Q_INVOKABLE void setRangeToStddev();
 
 private:
-    QVector<double> _values;
+    QVariantMap _statisticsMap;
     u::Statistics _statistics;
+    QVector<double> _histogram;
 
     bool _invert = false;
     double _exponent = 1.0;
     double _min = 0.0;
     double _max = 1.0;
 
-    void setValues(const QVector<double>& values);
+    void setStatistics(const QVariantMap& statistics);
     void setInvert(bool invert);
     void setExponent(double exponent);
     void setMinimum(double min);
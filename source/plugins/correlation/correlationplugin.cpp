@@ -40,6 +40,8 @@
 #include <json_helper.h>
 
 #include <map>
+#include <numeric>
+#include <atomic>
 
 CorrelationPluginInstance::CorrelationPluginInstance()
 {
@@ -76,25 +78,24 @@ bool CorrelationPluginInstance::loadUserData(const TabularData& tabularData,
 
     parser.setProgress(-1);
 
-    uint64_t numDataPoints = static_cast<uint64_t>(tabularData.numColumns()) * tabularData.numRows();
     size_t left = dataRect.x();
     size_t right = dataRect.x() + dataRect.width();
     size_t top = dataRect.y();
     size_t bottom = dataRect.y() + dataRect.height();
 
+    Q_ASSERT(static_cast<size_t>(dataRect.width()) == _numColumns);
+    Q_ASSERT(static_cast<size_t>(dataRect.height()) == _numRows);
+
+    // The names and annotations that surround the data rectangle are strings...
     for(size_t rowIndex = 0; rowIndex < tabularData.numRows(); rowIndex++)
     {
-        for(size_t columnIndex = 0; columnIndex < tabularData.numColumns(); columnIndex++)
-        {
-            if(parser.cancelled())
-                return false;
-
-            uint64_t rowOffset = static_cast<uint64_t>(rowIndex) * tabularData.numColumns();
-            uint64_t dataPoint = columnIndex + rowOffset;
-            parser.setProgress(static_cast<int>((dataPoint * 100) / numDataPoints));
+        if(parser.cancelled())
+            return false;
 
-            const auto& value = tabularData.valueAt(columnIndex, rowIndex);
+        parser.setProgress(static_cast<int>((rowIndex * 50) / tabularData.numRows()));
 
+        for(size_t columnIndex = 0; columnIndex < tabularData.numColumns(); columnIndex++)
+        {
             size_t dataColumnIndex = columnIndex - dataRect.x();
             size_t dataRowIndex = rowIndex - dataRect.y();
             bool isColumnInDataRect = left <= columnIndex && columnIndex < right;
@@ -102,54 +103,81 @@ bool CorrelationPluginInstance::loadUserData(const TabularData& tabularData,
             bool isColumnAnnotation = rowIndex < top;
             bool isRowAttribute = columnIndex < left;
 
-            if((isColumnInDataRect && dataColumnIndex >= _numColumns) ||
-                (isRowInDataRect && dataRowIndex >= _numRows))
-            {
-                qDebug() << QString("WARNING: Attempting to set data at coordinate (%1, %2) in "
-                                    "dataRect of dimensions (%3, %4)")
-                    .arg(dataColumnIndex).arg(dataRowIndex)
-                    .arg(_numColumns).arg(_numRows);
-
+            if(isRowInDataRect && isColumnInDataRect)
                 continue;
-            }
 
             if(rowIndex == 0)
             {
                 if(isColumnInDataRect)
-                    setDataColumnName(dataColumnIndex, value);
+                    setDataColumnName(dataColumnIndex, tabularData.valueAt(columnIndex, rowIndex));
                 else if(isRowAttribute)
-                    _userNodeData.add(value);
+                    _userNodeData.add(tabularData.valueAt(columnIndex, rowIndex));
             }
             else if(isColumnAnnotation)
             {
                 if(columnIndex == 0)
-                    _userColumnData.add(value);
+                    _userColumnData.add(tabularData.valueAt(columnIndex, rowIndex));
                 else if(isColumnInDataRect)
-                    _userColumnData.setValue(dataColumnIndex, tabularData.valueAt(0, rowIndex), value);
+                {
+                    _userColumnData.setValue(dataColumnIndex, tabularData.valueAt(0, rowIndex),
+                        tabularData.valueAt(columnIndex, rowIndex));
+                }
             }
             else if(isColumnInDataRect)
             {
-                double transformedValue = 0.0;
+                qDebug() << QString("WARNING: Attempting to set data at coordinate (%1, %2) in "
+                                    "dataRect of dimensions (%3, %4)")
+                    .arg(dataColumnIndex).arg(dataRowIndex)
+                    .arg(_numColumns).arg(_numRows);
+            }
+            else if(isRowAttribute)
+            {
+                _userNodeData.setValue(dataRowIndex, tabularData.valueAt(columnIndex, 0),
+                    tabularData.valueAt(columnIndex, rowIndex));
+            }
+        }
+    }
 
-                if(!value.isEmpty())
-                {
-                    bool success = false;
-                    transformedValue = value.toDouble(&success);
-                    Q_ASSERT(success);
-                }
-                else
+    // ...whereas the data itself was recognised as numeric during parsing,
+    // so it can be copied en masse, without any string conversion
+    auto numericBlock = tabularData.numericBlock(left, top, _numColumns, _numRows);
+    _data = std::move(numericBlock.values());
+
+    bool hasMissingValues = numericBlock.hasMissingValues();
+    bool requiresScaling = _scalingType != ScalingType::None;
+
+    if(hasMissingValues || requiresScaling)
+    {
+        std::vector<size_t> dataRowIndices(_numRows);
+        std::iota(dataRowIndices.begin(), dataRowIndices.end(), 0);
+        std::atomic<size_t> numRowsProcessed(0);
+
+        concurrent_for(dataRowIndices.begin(), dataRowIndices.end(),
+        [&](size_t dataRowIndex)
+        {
+            if(parser.cancelled())
+                return;
+
+            for(size_t dataColumnIndex = 0; dataColumnIndex < _numColumns; dataColumnIndex++)
+            {
+                auto index = (dataRowIndex * _numColumns) + dataColumnIndex;
+                auto& value = _data.at(index);
+
+                if(hasMissingValues && numericBlock.missingAt(dataColumnIndex, dataRowIndex))
                 {
-                    transformedValue = CorrelationFileParser::imputeValue(_missingDataType, _missingDataReplacementValue,
-                        tabularData, dataRect, columnIndex, rowIndex);
+                    value = CorrelationFileParser::imputeValue(_missingDataType, _missingDataReplacementValue,
+                        tabularData, dataRect, left + dataColumnIndex, top + dataRowIndex);
                 }
 
-                transformedValue = CorrelationFileParser::scaleValue(_scalingType, transformedValue);
-
-                setData(dataColumnIndex, dataRowIndex, transformedValue);
+                value = CorrelationFileParser::scaleValue(_scalingType, value);
             }
-            else if(isRowAttribute)
-                _userNodeData.setValue(dataRowIndex, tabularData.valueAt(columnIndex, 0), value);
-        }
+
+            numRowsProcessed++;
+            parser.setProgress(static_cast<int>(50 + ((numRowsProcessed * 50) / _numRows)));
+        });
+
+        if(parser.cancelled())
+            return false;
     }
 
     makeDataColumnNamesUnique();
@@ -380,13 +408,6 @@ void CorrelationPluginInstance::makeDataColumnNamesUnique()
     }
 }
 
-void CorrelationPluginInstance::setData(size_t column, size_t row, double value)
-{
-    auto index = (row * _numColumns) + column;
-    Q_ASSERT(index < _data.size());
-    _data.at(index) = value;
-}
-
 void CorrelationPluginInstance::finishDataRow(size_t row)
 {
     Q_ASSERT(row < _numRows);
@@ -109,8 +109,6 @@ private:
     void setDataColumnName(size_t column, const QString& name);
     void makeDataColumnNamesUnique();
 
-    void setData(size_t column, size_t row, double value);
-
     void finishDataRow(size_t row);
 
     QAbstractTableModel* nodeAttributeTableModel() { return &_nodeAttributeTableModel; }
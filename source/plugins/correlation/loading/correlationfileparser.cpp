@@ -51,8 +51,7 @@ static QRect findLargestDataRect(const TabularData& tabularData, size_t startCol
     {
         for(size_t row = tabularData.numRows(); row-- > startRow; )
         {
-            const auto& value = tabularData.valueAt(column, row);
-            if(u::isNumeric(value) || value.isEmpty())
+            if(tabularData.valueIsNumeric(column, row) || tabularData.valueIsEmpty(column, row))
                 heightHistogram.at(column)++;
             else
                 break;
@@ -125,10 +124,7 @@ static bool dataRectHasMissingValues(const TabularData& tabularData, const QRect
     {
         for(auto row = dataRect.top(); row <= dataRect.bottom(); row++)
         {
-            const auto& value = tabularData.valueAt(
-                static_cast<size_t>(column), static_cast<size_t>(row));
-
-            if(value.isEmpty())
+            if(tabularData.valueIsEmpty(static_cast<size_t>(column), static_cast<size_t>(row)))
                 return true;
         }
     }
@@ -136,6 +132,13 @@ static bool dataRectHasMissingValues(const TabularData& tabularData, const QRect
     return false;
 }
 
+// Equivalent to QString::toDouble, but uses the value parsed during tokenisation
+static double valueOrZero(const TabularData& tabularData, size_t column, size_t row)
+{
+    return tabularData.valueIsNumeric(column, row) ?
+        tabularData.numericValueAt(column, row) : 0.0;
+}
+
 double CorrelationFileParser::imputeValue(MissingDataType missingDataType,
     double replacementValue, const TabularData& tabularData,
     const QRect& dataRect, size_t columnIndex, size_t rowIndex)
@@ -159,10 +162,9 @@ double CorrelationFileParser::imputeValue(MissingDataType missingDataType,
         size_t rowCount = 0;
         for(size_t avgRowIndex = left; avgRowIndex < right; avgRowIndex++)
         {
-            const auto& value = tabularData.valueAt(columnIndex, avgRowIndex);
-            if(!value.isEmpty())
+            if(!tabularData.valueIsEmpty(columnIndex, avgRowIndex))
             {
-                averageValue += value.toDouble();
+                averageValue += valueOrZero(tabularData, columnIndex, avgRowIndex);
                 rowCount++;
             }
         }
@@ -185,10 +187,9 @@ double CorrelationFileParser::imputeValue(MissingDataType missingDataType,
         // Find right value
         for(size_t rightColumn = columnIndex; rightColumn < right; rightColumn++)
         {
-            const auto& value = tabularData.valueAt(rightColumn, rowIndex);
-            if(!value.isEmpty())
+            if(!tabularData.valueIsEmpty(rightColumn, rowIndex))
             {
-                rightValue = value.toDouble();
+                rightValue = valueOrZero(tabularData, rightColumn, rowIndex);
                 rightValueFound = true;
                 rightDistance = (rightColumn > columnIndex) ? rightColumn - columnIndex : columnIndex - rightColumn;
                 break;
@@ -197,10 +198,9 @@ double CorrelationFileParser::imputeValue(MissingDataType missingDataType,
         // Find left value
         for(size_t leftColumn = columnIndex; leftColumn-- != left;)
         {
-            const auto& value = tabularData.valueAt(leftColumn, rowIndex);
-            if(!value.isEmpty())
+            if(!tabularData.valueIsEmpty(leftColumn, rowIndex))
             {
-                leftValue = value.toDouble();
+                leftValue = valueOrZero(tabularData, leftColumn, rowIndex);
                 leftValueFound = true;
                 leftDistance = (leftColumn > columnIndex) ? leftColumn - columnIndex : columnIndex - leftColumn;
                 break;
@@ -540,18 +540,16 @@ std::vector<CorrelationDataRow> TabularDataParser::sampledDataRows(size_t numSam
             if(_graphSizeEstimateCancellable.cancelled())
                 return {};
 
-            const auto& value = _dataPtr->valueAt(columnIndex, rowIndex);
             double transformedValue = 0.0;
 
-            if(!value.isEmpty())
+            if(!_dataPtr->valueIsEmpty(columnIndex, rowIndex))
             {
-                bool success = false;
-                transformedValue = value.toDouble(&success);
-
-                if(!success)
+                if(_dataPtr->valueIsNumeric(columnIndex, rowIndex))
+                    transformedValue = _dataPtr->numericValueAt(columnIndex, rowIndex);
+                else
                 {
                     qDebug() << QStringLiteral("WARNING: non-numeric value at (%1, %2): %3")
-                        .arg(columnIndex).arg(rowIndex).arg(value);
+                        .arg(columnIndex).arg(rowIndex).arg(_dataPtr->valueAt(columnIndex, rowIndex));
                 }
             }
             else
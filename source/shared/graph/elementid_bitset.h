@@ -0,0 +1,311 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ELEMENTID_BITSET_H
+#define ELEMENTID_BITSET_H
+
+#include "elementid.h"
+#include "elementid_containers.h"
+
+#include <vector>
+#include <bitset>
+#include <iterator>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// A set of ElementIds, stored as one bit per possible ElementId; membership
+// tests are a single bit test and set operations work on a word at a time
+template<typename T>
+class ElementIdBitSet
+{
+private:
+    using Word = uint64_t;
+    static constexpr size_t WordBits = 64;
+
+    std::vector<Word> _words;
+    size_t _size = 0;
+
+    static size_t wordIndexOf(T elementId) { return static_cast<size_t>(static_cast<int>(elementId)) / WordBits; }
+    static Word bitOf(T elementId) { return Word(1) << (static_cast<size_t>(static_cast<int>(elementId)) % WordBits); }
+
+    static size_t popcount(Word word)
+    {
+        return std::bitset<WordBits>(word).count();
+    }
+
+    static size_t lowestSetBit(Word word)
+    {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanForward64(&index, word);
+        return static_cast<size_t>(index);
+#else
+        return static_cast<size_t>(__builtin_ctzll(word));
+#endif
+    }
+
+    void recount()
+    {
+        _size = 0;
+        for(auto word : _words)
+            _size += popcount(word);
+    }
+
+    void trim()
+    {
+        while(!_words.empty() && _words.back() == 0)
+            _words.pop_back();
+    }
+
+public:
+    class const_iterator
+    {
+        friend class ElementIdBitSet;
+
+    private:
+        const std::vector<Word>* _words = nullptr;
+        size_t _wordIndex = 0;
+
+        // The bits of the current word that are yet to be visited
+        Word _word = 0;
+
+        const_iterator(const std::vector<Word>* words, size_t wordIndex, Word word) :
+            _words(words), _wordIndex(wordIndex), _word(word)
+        {
+            skipEmptyWords();
+        }
+
+        void skipEmptyWords()
+        {
+            while(_word == 0 && _wordIndex < _words->size())
+            {
+                _wordIndex++;
+
+                if(_wordIndex < _words->size())
+                    _word = (*_words)[_wordIndex];
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = T;
+
+        const_iterator() = default;
+
+        T operator*() const
+        {
+            return T(static_cast<int>((_wordIndex * WordBits) + lowestSetBit(_word)));
+        }
+
+        const_iterator& operator++()
+        {
+            _word &= _word - 1;
+            skipEmptyWords();
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto previous = *this;
+            ++(*this);
+            return previous;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            return _wordIndex == other._wordIndex && _word == other._word;
+        }
+
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    };
+
+    using iterator = const_iterator;
+    using value_type = T;
+
+    ElementIdBitSet() = default;
+
+    template<typename C>
+    explicit ElementIdBitSet(const C& elementIds)
+    {
+        insert(std::begin(elementIds), std::end(elementIds));
+    }
+
+    const_iterator begin() const
+    {
+        if(_words.empty())
+            return end();
+
+        return {&_words, 0, _words.front()};
+    }
+
+    const_iterator end() const { return {&_words, _words.size(), 0}; }
+
+    const_iterator find(T elementId) const
+    {
+        if(!contains(elementId))
+            return end();
+
+        // Mask off the bits below elementId, so that iteration continues from it
+        auto bit = bitOf(elementId);
+        auto wordIndex = wordIndexOf(elementId);
+        return {&_words, wordIndex, _words[wordIndex] & ~(bit - 1)};
+    }
+
+    bool contains(T elementId) const
+    {
+        assert(!elementId.isNull());
+
+        auto wordIndex = wordIndexOf(elementId);
+        return wordIndex < _words.size() && (_words[wordIndex] & bitOf(elementId)) != 0;
+    }
+
+    // Returns true if elementId wasn't already present
+    bool insert(T elementId)
+    {
+        assert(!elementId.isNull());
+
+        auto wordIndex = wordIndexOf(elementId);
+        if(wordIndex >= _words.size())
+            _words.resize(wordIndex + 1, 0);
+
+        auto& word = _words[wordIndex];
+        auto bit = bitOf(elementId);
+
+        if((word & bit) != 0)
+            return false;
+
+        word |= bit;
+        _size++;
+        return true;
+    }
+
+    template<typename It>
+    void insert(It first, It last)
+    {
+        for(auto it = first; it != last; ++it)
+            insert(*it);
+    }
+
+    // Returns the number of elements removed, for compatibility with std::unordered_set
+    size_t erase(T elementId)
+    {
+        if(!contains(elementId))
+            return 0;
+
+        _words[wordIndexOf(elementId)] &= ~bitOf(elementId);
+        _size--;
+        return 1;
+    }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    void clear()
+    {
+        _words.clear();
+        _size = 0;
+    }
+
+    ElementIdBitSet& operator|=(const ElementIdBitSet& other)
+    {
+        if(other._words.size() > _words.size())
+            _words.resize(other._words.size(), 0);
+
+        for(size_t i = 0; i < other._words.size(); i++)
+            _words[i] |= other._words[i];
+
+        recount();
+        return *this;
+    }
+
+    ElementIdBitSet& operator&=(const ElementIdBitSet& other)
+    {
+        _words.resize(std::min(_words.size(), other._words.size()));
+
+        for(size_t i = 0; i < _words.size(); i++)
+            _words[i] &= other._words[i];
+
+        trim();
+        recount();
+        return *this;
+    }
+
+    // Set difference
+    ElementIdBitSet& operator-=(const ElementIdBitSet& other)
+    {
+        auto size = std::min(_words.size(), other._words.size());
+
+        for(size_t i = 0; i < size; i++)
+            _words[i] &= ~other._words[i];
+
+        trim();
+        recount();
+        return *this;
+    }
+
+    // Symmetric difference
+    ElementIdBitSet& operator^=(const ElementIdBitSet& other)
+    {
+        if(other._words.size() > _words.size())
+            _words.resize(other._words.size(), 0);
+
+        for(size_t i = 0; i < other._words.size(); i++)
+            _words[i] ^= other._words[i];
+
+        trim();
+        recount();
+        return *this;
+    }
+
+    friend ElementIdBitSet operator|(ElementIdBitSet a, const ElementIdBitSet& b) { return a |= b; }
+    friend ElementIdBitSet operator^(ElementIdBitSet a, const ElementIdBitSet& b) { return a ^= b; }
+    friend ElementIdBitSet operator&(ElementIdBitSet a, const ElementIdBitSet& b) { return a &= b; }
+    friend ElementIdBitSet operator-(ElementIdBitSet a, const ElementIdBitSet& b) { return a -= b; }
+
+    bool operator==(const ElementIdBitSet& other) const
+    {
+        if(_size != other._size)
+            return false;
+
+        // Trailing zero words are not significant
+        const auto& shorter = _words.size() < other._words.size() ? _words : other._words;
+        const auto& longer = _words.size() < other._words.size() ? other._words : _words;
+
+        return std::equal(shorter.begin(), shorter.end(), longer.begin()) &&
+            std::all_of(longer.begin() + static_cast<std::ptrdiff_t>(shorter.size()), longer.end(),
+            [](auto word) { return word == 0; });
+    }
+
+    bool operator!=(const ElementIdBitSet& other) const { return !(*this == other); }
+
+    ElementIdSet<T> toSet() const { return ElementIdSet<T>(begin(), end()); }
+};
+
+using NodeIdBitSet = ElementIdBitSet<NodeId>;
+using EdgeIdBitSet = ElementIdBitSet<EdgeId>;
+
+#endif // ELEMENTID_BITSET_H
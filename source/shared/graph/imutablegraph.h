@@ -24,6 +24,9 @@
 
 #include "shared/graph/igraph.h"
 
+#include <vector>
+#include <utility>
+
 class IMutableGraph : public virtual IGraph
 {
 public:
@@ -49,6 +52,9 @@ public:
         endTransaction();
     }
 
+    // Adds numNodes new nodes with consecutive ids, returning the first of them
+    virtual NodeId addNodesInBulk(int numNodes) = 0;
+
     virtual void removeNode(NodeId nodeId) = 0;
     template<typename C> void removeNodes(const C& nodeIds)
     {
@@ -81,6 +87,9 @@ public:
         endTransaction();
     }
 
+    // Adds an edge for each (source, target) pair, with consecutive ids, returning the first of them
+    virtual EdgeId addEdgesInBulk(const std::vector<std::pair<NodeId, NodeId>>& edges) = 0;
+
     virtual void removeEdge(EdgeId edgeId) = 0;
     template<typename C> void removeEdges(const C& edgeIds)
     {
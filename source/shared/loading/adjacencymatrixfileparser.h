@@ -192,9 +192,8 @@ static bool parseMatrixFromTabularData(const TabularData& tabularData,
                 columnIndex++)
             {
                 // Edges
-                const auto& qStringValue = tabularData.valueAt(columnIndex, rowIndex);
-                bool success = false;
-                double doubleValue = qStringValue.toDouble(&success);
+                bool success = tabularData.valueIsNumeric(columnIndex, rowIndex);
+                double doubleValue = tabularData.numericValueAt(columnIndex, rowIndex);
                 NodeId targetNode, sourceNode;
 
                 targetNode = columnToNodeId.at(columnIndex);
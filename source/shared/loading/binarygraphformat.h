@@ -0,0 +1,83 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BINARYGRAPHFORMAT_H
+#define BINARYGRAPHFORMAT_H
+
+#include <QtGlobal>
+
+#include <cstdint>
+#include <cstddef>
+
+// A compact, lossless representation of a graph and its user defined attributes,
+// designed to be read and written with little more than a memory copy
+//
+// All values are little endian, and each section begins on an 8 byte boundary:
+//
+//  Header
+//  int32       nodeIds[numNodes]       ids of the nodes in the graph that was saved
+//  uint32      edgeSources[numEdges]   indices into nodeIds
+//  uint32      edgeTargets[numEdges]
+//  Strings     nodeNames[numNodes]
+//  Column      nodeColumns[numNodeColumns]
+//  Column      edgeColumns[numEdgeColumns]
+//  (Flags::Csr only)
+//  uint64      csrOffsets[numNodes + 1]  outgoing edges of node i are in the range
+//  uint32      csrEdges[numEdges]        [csrOffsets[i], csrOffsets[i + 1]) of csrEdges
+//
+//  Strings: uint64 offsets[n + 1], then the concatenated UTF-8 bytes
+//  Column:  uint32 nameLength, name UTF-8 bytes, uint8 ColumnType, uint8 hasMissing,
+//           then int32[n], double[n] or Strings[n], then if hasMissing a bitmap of
+//           (n + 7) / 8 bytes, in which a set bit indicates a missing value
+
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "Binary graphs are only supported on little endian hosts");
+
+namespace BinaryGraph
+{
+constexpr char MAGIC[] = {'G', 'R', 'A', 'P', 'H', 'B', 'I', 'N'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t ALIGNMENT = 8;
+
+enum Flags : uint32_t
+{
+    None = 0x0,
+    Csr  = 0x1
+};
+
+enum class ColumnType : uint8_t
+{
+    Int,
+    Float,
+    String
+};
+
+struct Header
+{
+    char _magic[sizeof(MAGIC)];
+    uint32_t _version;
+    uint32_t _flags;
+    uint64_t _numNodes;
+    uint64_t _numEdges;
+    uint32_t _numNodeColumns;
+    uint32_t _numEdgeColumns;
+};
+
+static_assert(sizeof(Header) == 40, "Header is not packed as expected");
+} // namespace BinaryGraph
+
+#endif // BINARYGRAPHFORMAT_H
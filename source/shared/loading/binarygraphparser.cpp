@@ -0,0 +1,346 @@
+/* Copyright © 2013-2020 Graphia Technologies Ltd.
+ *
+ * This file is part of Graphia.
+ *
+ * Graphia is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Graphia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Graphia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binarygraphparser.h"
+
+#include "shared/loading/binarygraphformat.h"
+#include "shared/graph/igraphmodel.h"
+#include "shared/graph/imutablegraph.h"
+
+#include <QFile>
+#include <QUrl>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// Bounds checked sequential access to the mapped file
+class BinaryReader
+{
+private:
+    const char* _data;
+    size_t _size;
+    size_t _position = 0;
+    bool _ok = true;
+
+public:
+    BinaryReader(const char* data, size_t size) : _data(data), _size(size) {}
+
+    bool ok() const { return _ok; }
+
+    const char* readRaw(size_t size)
+    {
+        if(!_ok || size > _size - _position)
+        {
+            _ok = false;
+            return nullptr;
+        }
+
+        const auto* data = _data + _position;
+        _position += size;
+
+        return data;
+    }
+
+    template<typename T>
+    T read()
+    {
+        T value{};
+
+        const auto* data = readRaw(sizeof(T));
+        if(data != nullptr)
+            std::memcpy(&value, data, sizeof(T));
+
+        return value;
+    }
+
+    template<typename T>
+    std::vector<T> readArray(uint64_t size)
+    {
+        if(size > (_size - _position) / sizeof(T))
+        {
+            _ok = false;
+            return {};
+        }
+
+        std::vector<T> values(static_cast<size_t>(size));
+        const auto* data = readRaw(values.size() * sizeof(T));
+        if(data != nullptr)
+            std::memcpy(values.data(), data, values.size() * sizeof(T));
+
+        return values;
+    }
+
+    std::vector<QString> readStrings(uint64_t size)
+    {
+        auto offsets = readArray<uint64_t>(size + 1);
+        if(!_ok)
+            return {};
+
+        const auto* bytes = readRaw(static_cast<size_t>(offsets.back()));
+        if(bytes == nullptr)
+            return {};
+
+        std::vector<QString> strings;
+        strings.reserve(static_cast<size_t>(size));
+
+        for(size_t i = 0; i < static_cast<size_t>(size); i++)
+        {
+            if(offsets[i] > offsets[i + 1] || offsets[i + 1] > offsets.back())
+            {
+                _ok = false;
+                return {};
+            }
+
+            strings.push_back(QString::fromUtf8(bytes + offsets[i],
+                static_cast<int>(offsets[i + 1] - offsets[i])));
+        }
+
+        align();
+
+        return strings;
+    }
+
+    void align()
+    {
+        auto remainder = _position % BinaryGraph::ALIGNMENT;
+
+        if(remainder != 0)
+            readRaw(BinaryGraph::ALIGNMENT - remainder);
+    }
+};
+
+template<typename E>
+bool readColumn(BinaryReader& reader, uint64_t numElements, E firstElementId,
+    UserElementData<E>* userElementData)
+{
+    auto nameLength = reader.read<uint32_t>();
+    const auto* nameBytes = reader.readRaw(nameLength);
+    auto columnType = static_cast<BinaryGraph::ColumnType>(reader.read<uint8_t>());
+    auto hasMissing = reader.read<uint8_t>() != 0;
+    reader.align();
+
+    if(!reader.ok())
+        return false;
+
+    auto name = QString::fromUtf8(nameBytes, static_cast<int>(nameLength));
+    std::vector<QString> values;
+
+    switch(columnType)
+    {
+    case BinaryGraph::ColumnType::Int:
+    {
+        auto intValues = reader.readArray<int32_t>(numElements);
+        values.reserve(intValues.size());
+        for(auto intValue : intValues)
+            values.push_back(QString::number(intValue));
+
+        break;
+    }
+
+    case BinaryGraph::ColumnType::Float:
+    {
+        auto floatValues = reader.readArray<double>(numElements);
+        values.reserve(floatValues.size());
+        // 17 significant digits is enough for any double to survive the round trip
+        for(auto floatValue : floatValues)
+            values.push_back(QString::number(floatValue, 'g', 17));
+
+        break;
+    }
+
+    case BinaryGraph::ColumnType::String:
+        values = reader.readStrings(numElements);
+        break;
+
+    default:
+        return false;
+    }
+
+    reader.align();
+
+    std::vector<uint8_t> missing;
+    if(hasMissing)
+    {
+        missing = reader.readArray<uint8_t>((numElements + 7) / 8);
+        reader.align();
+    }
+
+    if(!reader.ok())
+        return false;
+
+    if(userElementData == nullptr)
+        return true;
+
+    for(size_t i = 0; i < values.size(); i++)
+    {
+        if(hasMissing && (missing[i / 8] & (1u << (i % 8))) != 0)
+            continue;
+
+        userElementData->setValueBy(firstElementId + static_cast<int>(i), name, values[i]);
+    }
+
+    return true;
+}
+} // namespace
+
+bool BinaryGraphParser::canLoad(const QUrl& url)
+{
+    QFile file(url.toLocalFile());
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    auto magic = file.read(sizeof(BinaryGraph::MAGIC));
+    return magic.size() == sizeof(BinaryGraph::MAGIC) &&
+        std::equal(magic.begin(), magic.end(), std::begin(BinaryGraph::MAGIC));
+}
+
+bool BinaryGraphParser::parse(const QUrl& url, IGraphModel* graphModel)
+{
+    Q_ASSERT(graphModel != nullptr);
+
+    QFile file(url.toLocalFile());
+    if(!file.open(QIODevice::ReadOnly) || graphModel == nullptr)
+        return false;
+
+    const auto* data = reinterpret_cast<const char*>(file.map(0, file.size()));
+    if(data == nullptr)
+    {
+        setFailureReason(QObject::tr("Failed to map %1 into memory.").arg(file.fileName()));
+        return false;
+    }
+
+    BinaryReader reader(data, static_cast<size_t>(file.size()));
+
+    auto header = reader.read<BinaryGraph::Header>();
+    reader.align();
+
+    if(!reader.ok() || !std::equal(std::begin(BinaryGraph::MAGIC),
+        std::end(BinaryGraph::MAGIC), header._magic))
+    {
+        setFailureReason(QObject::tr("File is not a binary graph."));
+        return false;
+    }
+
+    if(header._version > BinaryGraph::VERSION)
+    {
+        setFailureReason(QObject::tr("Binary graph version %1 is not supported.").arg(header._version));
+        return false;
+    }
+
+    if(header._numNodes > static_cast<uint64_t>(std::numeric_limits<int>::max()) ||
+        header._numEdges > static_cast<uint64_t>(std::numeric_limits<int>::max()))
+    {
+        setFailureReason(QObject::tr("Binary graph is too large."));
+        return false;
+    }
+
+    auto numSteps = 2 + header._numNodeColumns + header._numEdgeColumns;
+    uint64_t step = 0;
+    auto nextStep = [this, &step, numSteps] { setProgress(static_cast<int>((++step * 100) / numSteps)); };
+
+    setProgress(-1);
+
+    // The node id table is informational only; nodes are renumbered from the graph's next id
+    reader.readArray<int32_t>(header._numNodes);
+    reader.align();
+
+    auto sources = reader.readArray<uint32_t>(header._numEdges);
+    reader.align();
+    auto targets = reader.readArray<uint32_t>(header._numEdges);
+    reader.align();
+    auto nodeNames = reader.readStrings(header._numNodes);
+
+    auto numNodes = header._numNodes;
+    auto outOfRange = [numNodes](uint32_t index) { return index >= numNodes; };
+
+    if(!reader.ok() || std::any_of(sources.begin(), sources.end(), outOfRange) ||
+        std::any_of(targets.begin(), targets.end(), outOfRange))
+    {
+        setFailureReason(QObject::tr("Binary graph structure is corrupt."));
+        return false;
+    }
+
+    auto& graph = graphModel->mutableGraph();
+    graph.setPhase(QObject::tr("Nodes"));
+
+    auto firstNodeId = graph.addNodesInBulk(static_cast<int>(header._numNodes));
+
+    for(size_t i = 0; i < nodeNames.size(); i++)
+        graphModel->setNodeName(firstNodeId + static_cast<int>(i), nodeNames[i]);
+
+    nextStep();
+
+    if(cancelled())
+        return false;
+
+    graph.setPhase(QObject::tr("Edges"));
+
+    std::vector<std::pair<NodeId, NodeId>> edges;
+    edges.reserve(sources.size());
+    for(size_t i = 0; i < sources.size(); i++)
+    {
+        edges.emplace_back(firstNodeId + static_cast<int>(sources[i]),
+            firstNodeId + static_cast<int>(targets[i]));
+    }
+
+    sources = {};
+    targets = {};
+
+    auto firstEdgeId = graph.addEdgesInBulk(edges);
+    edges = {};
+    nextStep();
+
+    graph.setPhase(QObject::tr("Attributes"));
+
+    for(uint32_t i = 0; i < header._numNodeColumns; i++)
+    {
+        if(cancelled())
+            return false;
+
+        if(!readColumn(reader, header._numNodes, firstNodeId, _userNodeData))
+        {
+            setFailureReason(QObject::tr("Binary graph node attribute is corrupt."));
+            return false;
+        }
+
+        nextStep();
+    }
+
+    for(uint32_t i = 0; i < header._numEdgeColumns; i++)
+    {
+        if(cancelled())
+            return false;
+
+        if(!readColumn(reader, header._numEdges, firstEdgeId, _userEdgeData))
+        {
+            setFailureReason(QObject::tr("Binary graph edge attribute is corrupt."));
+            return false;
+        }
+
+        nextStep();
+    }
+
+    // Any CSR block is redundant here, given the edge arrays
+
+    return true;
+}
@@ -23,88 +23,56 @@
 #include "shared/graph/igraphmodel.h"
 #include "shared/graph/imutablegraph.h"
 
-#include <QDataStream>
 #include <QFile>
 #include <QUrl>
 
-bool JsonGraphParser::parse(const QUrl &url, IGraphModel *graphModel)
-{
-    QFile file(url.toLocalFile());
-    QByteArray byteArray;
-
-    if(!file.open(QIODevice::ReadOnly))
-        return false;
-
-    auto totalBytes = file.size();
-
-    if(totalBytes == 0)
-        return false;
-
-    qint64 bytesRead = 0;
-    QDataStream input(&file);
-
-    do
-    {
-        const int ChunkSize = 2 << 16;
-        std::vector<unsigned char> buffer(ChunkSize);
+#include <streambuf>
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
-        auto numBytes = input.readRawData(reinterpret_cast<char*>(buffer.data()), ChunkSize);
-        byteArray.append(reinterpret_cast<char*>(buffer.data()), numBytes);
-
-        bytesRead += numBytes;
-
-        setProgress(static_cast<int>((bytesRead * 100) / totalBytes));
-    } while(!input.atEnd());
-
-    auto jsonBody = parseJsonFrom(byteArray, this);
-
-    if(cancelled())
-        return false;
-
-    if(jsonBody.is_null() || !jsonBody.is_object())
-    {
-        setFailureReason(QObject::tr("Body is empty, or not an object."));
-        return false;
-    }
+namespace
+{
+QString metadataValue(const json& value)
+{
+    if(value.is_string())
+        return QString::fromStdString(value.get<std::string>());
 
-    const json* graph = nullptr;
+    if(value.is_number_integer())
+        return QString::number(value.get<int>());
 
-    if(u::contains(jsonBody, "graphs") && jsonBody["graphs"].is_array() && !jsonBody["graphs"].empty())
-        graph = &jsonBody["graphs"].at(0);
-    else if(u::contains(jsonBody, "graph") && jsonBody["graph"].is_object())
-        graph = &jsonBody["graph"];
-    else
-    {
-        setFailureReason(QObject::tr("Body doesn't contain a graph object."));
-        return false;
-    }
+    if(value.is_number_float())
+        return QString::number(value.get<double>());
 
-    return parseGraphObject(*graph, graphModel, *this, false, _userNodeData, _userEdgeData);
+    return {};
 }
 
-bool JsonGraphParser::parseGraphObject(const json& jsonGraphObject, IGraphModel* graphModel,
-                                       IParser& parser, bool useElementIdsLiterally,
-                                       UserNodeData* userNodeData, UserEdgeData* userEdgeData)
+// Adds nodes and edges to the graph one JSON object at a time
+class JsonGraphBuilder
 {
-    if(!u::contains(jsonGraphObject, "nodes") || !u::contains(jsonGraphObject, "edges"))
-    {
-        parser.setFailureReason(QObject::tr("Graph doesn't contain nodes or edges arrays."));
-        return false;
-    }
-
-    const auto& jsonNodes = jsonGraphObject["nodes"];
-    const auto& jsonEdges = jsonGraphObject["edges"];
-
-    uint64_t i = 0;
-
-    graphModel->mutableGraph().setPhase(QObject::tr("Nodes"));
-
-    std::map<std::string, NodeId> stringNodeIdToNodeId;
-    for(const auto& jsonNode : jsonNodes)
+private:
+    IGraphModel* _graphModel;
+    IParser* _parser;
+    bool _useElementIdsLiterally;
+    UserNodeData* _userNodeData;
+    UserEdgeData* _userEdgeData;
+
+    std::unordered_map<std::string, NodeId> _stringNodeIdToNodeId;
+
+public:
+    JsonGraphBuilder(IGraphModel* graphModel, IParser* parser, bool useElementIdsLiterally,
+        UserNodeData* userNodeData, UserEdgeData* userEdgeData) :
+        _graphModel(graphModel), _parser(parser),
+        _useElementIdsLiterally(useElementIdsLiterally),
+        _userNodeData(userNodeData), _userEdgeData(userEdgeData)
+    {}
+
+    bool addNode(const json& jsonNode)
     {
         if(!u::contains(jsonNode, "id") || !jsonNode["id"].is_string())
         {
-            parser.setFailureReason(QObject::tr("Node has no ID."));
+            _parser->setFailureReason(QObject::tr("Node has no ID."));
             return false;
         }
 
@@ -112,55 +80,38 @@ bool JsonGraphParser::parseGraphObject(const json& jsonGraphObject, IGraphModel*
 
         NodeId nodeId;
 
-        if(useElementIdsLiterally && u::isNumeric(nodeIdString))
+        if(_useElementIdsLiterally && u::isNumeric(nodeIdString))
         {
             nodeId = std::stoi(nodeIdString);
-            graphModel->mutableGraph().reserveNodeId(nodeId);
-            nodeId = graphModel->mutableGraph().addNode(nodeId);
+            _graphModel->mutableGraph().reserveNodeId(nodeId);
+            nodeId = _graphModel->mutableGraph().addNode(nodeId);
         }
         else
-            nodeId = graphModel->mutableGraph().addNode();
+            nodeId = _graphModel->mutableGraph().addNode();
 
-        stringNodeIdToNodeId[nodeIdString] = nodeId;
+        _stringNodeIdToNodeId[nodeIdString] = nodeId;
 
         if(u::contains(jsonNode, "label"))
         {
             auto nodeJsonLabel = jsonNode["label"].get<std::string>();
-            graphModel->setNodeName(nodeId, QString::fromStdString(nodeJsonLabel));
+            _graphModel->setNodeName(nodeId, QString::fromStdString(nodeJsonLabel));
         }
 
-        if(u::contains(jsonNode, "metadata") && userNodeData != nullptr)
+        if(u::contains(jsonNode, "metadata") && _userNodeData != nullptr)
         {
-            auto metadata = jsonNode["metadata"];
+            const auto& metadata = jsonNode["metadata"];
             for(auto it = metadata.begin(); it != metadata.end(); ++it)
-            {
-                auto key = QString::fromStdString(it.key());
-                QString value;
-
-                if(it.value().is_string())
-                    value = QString::fromStdString(it.value().get<std::string>());
-                else if(it.value().is_number_integer())
-                    value = QString::number(it.value().get<int>());
-                else if(it.value().is_number_float())
-                    value = QString::number(it.value().get<double>());
-
-                userNodeData->setValueBy(nodeId, key, value);
-            }
+                _userNodeData->setValueBy(nodeId, QString::fromStdString(it.key()), metadataValue(it.value()));
         }
 
-        parser.setProgress(static_cast<int>((i++ * 100) / jsonNodes.size()));
+        return true;
     }
 
-    parser.setProgress(-1);
-
-    i = 0;
-
-    graphModel->mutableGraph().setPhase(QObject::tr("Edges"));
-    for(const auto& jsonEdge : jsonEdges)
+    bool addEdge(const json& jsonEdge)
     {
         if(!u::contains(jsonEdge, "source") || !u::contains(jsonEdge, "target"))
         {
-            parser.setFailureReason(QObject::tr("Edge has no source or target."));
+            _parser->setFailureReason(QObject::tr("Edge has no source or target."));
             return false;
         }
 
@@ -170,46 +121,330 @@ bool JsonGraphParser::parseGraphObject(const json& jsonGraphObject, IGraphModel*
         auto sourceIdString = jsonEdge["source"].get<std::string>();
         auto targetIdString = jsonEdge["target"].get<std::string>();
 
-        if(!u::contains(stringNodeIdToNodeId, sourceIdString) ||
-            !u::contains(stringNodeIdToNodeId, targetIdString))
+        if(!u::contains(_stringNodeIdToNodeId, sourceIdString) ||
+            !u::contains(_stringNodeIdToNodeId, targetIdString))
         {
             return false;
         }
 
         EdgeId edgeId;
-        NodeId sourceId = stringNodeIdToNodeId.at(sourceIdString);
-        NodeId targetId = stringNodeIdToNodeId.at(targetIdString);
+        NodeId sourceId = _stringNodeIdToNodeId.at(sourceIdString);
+        NodeId targetId = _stringNodeIdToNodeId.at(targetIdString);
 
-        if(useElementIdsLiterally && u::contains(jsonEdge, "id") && jsonEdge["id"].is_string())
+        if(_useElementIdsLiterally && u::contains(jsonEdge, "id") && jsonEdge["id"].is_string())
         {
             edgeId = std::stoi(jsonEdge["id"].get<std::string>());
 
-            graphModel->mutableGraph().reserveEdgeId(edgeId);
-            edgeId = graphModel->mutableGraph().addEdge(edgeId, sourceId, targetId);
+            _graphModel->mutableGraph().reserveEdgeId(edgeId);
+            edgeId = _graphModel->mutableGraph().addEdge(edgeId, sourceId, targetId);
         }
         else
-            edgeId = graphModel->mutableGraph().addEdge(sourceId, targetId);
+            edgeId = _graphModel->mutableGraph().addEdge(sourceId, targetId);
 
-        if(u::contains(jsonEdge, "metadata") && userEdgeData != nullptr)
+        if(u::contains(jsonEdge, "metadata") && _userEdgeData != nullptr)
         {
-            auto metadata = jsonEdge["metadata"];
+            const auto& metadata = jsonEdge["metadata"];
             for(auto it = metadata.begin(); it != metadata.end(); ++it)
-            {
-                QString key = QString::fromStdString(it.key());
-                QString value;
+                _userEdgeData->setValueBy(edgeId, QString::fromStdString(it.key()), metadataValue(it.value()));
+        }
+
+        return true;
+    }
+};
+
+// Feeds a file to the JSON parser in blocks, reporting progress as each is consumed
+class FileStreamBuffer : public std::streambuf
+{
+private:
+    QFile* _file;
+    IParser* _parser;
+    std::vector<char> _buffer;
+    qint64 _bytesRead = 0;
+
+public:
+    struct cancelled_exception {};
+
+    FileStreamBuffer(QFile* file, IParser* parser) :
+        _file(file), _parser(parser), _buffer(1u << 20u)
+    {}
+
+protected:
+    int_type underflow() override
+    {
+        if(gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+
+        if(_parser->cancelled())
+            throw cancelled_exception();
+
+        auto numBytes = _file->read(_buffer.data(), static_cast<qint64>(_buffer.size()));
+        if(numBytes <= 0)
+            return traits_type::eof();
+
+        _bytesRead += numBytes;
+        _parser->setProgress(static_cast<int>((_bytesRead * 100) / _file->size()));
+
+        setg(_buffer.data(), _buffer.data(), _buffer.data() + numBytes);
+        return traits_type::to_int_type(*gptr());
+    }
+};
+
+// Tracks where the parser is in the document, so that the elements of the nodes
+// and edges arrays can be identified, built and then discarded as they complete
+class JsonGraphStreamHandler
+{
+private:
+    JsonGraphBuilder* _builder;
+
+    // Indexed by the depth reported by the parser
+    std::vector<bool> _containerIsArray;
+    std::vector<std::string> _keys;
+
+    int _graphDepth = -1;
+    bool _inGraph = false;
+    bool _hasNodes = false;
+    bool _hasEdges = false;
+    bool _nodesComplete = false;
+
+    // Edges that appear before the nodes array has finished can't be resolved
+    // yet, so must be retained until it has
+    std::vector<json> _pendingEdges;
+
+    bool isElementContainer(int depth, const char* key) const
+    {
+        return _inGraph && depth == _graphDepth + 1 && _keys.at(static_cast<size_t>(depth)) == key;
+    }
+
+    void addEdge(const json& jsonEdge)
+    {
+        if(!_builder->addEdge(jsonEdge))
+            throw failed_exception();
+    }
+
+    void enterContainer(int depth, bool isArray)
+    {
+        auto size = static_cast<size_t>(depth) + 2;
+        if(_containerIsArray.size() < size)
+        {
+            _containerIsArray.resize(size, false);
+            _keys.resize(size);
+        }
+
+        _containerIsArray[static_cast<size_t>(depth)] = isArray;
+        _keys[static_cast<size_t>(depth) + 1].clear();
+    }
+
+    bool isGraphObject(int depth) const
+    {
+        if(_containerIsArray.front())
+            return false;
+
+        // { "graph": { ... } }
+        if(depth == 1 && _keys.at(1) == "graph")
+            return true;
+
+        // { "graphs": [ { ... }, ... ] }
+        return depth == 2 && _containerIsArray.at(1) && _keys.at(1) == "graphs";
+    }
+
+public:
+    struct failed_exception {};
+
+    explicit JsonGraphStreamHandler(JsonGraphBuilder* builder) :
+        _builder(builder)
+    {}
+
+    bool foundGraph() const { return _graphDepth >= 0; }
+    bool hasNodesAndEdges() const { return _hasNodes && _hasEdges; }
+
+    void flushPendingEdges()
+    {
+        for(const auto& jsonEdge : _pendingEdges)
+            addEdge(jsonEdge);
+
+        _pendingEdges.clear();
+    }
+
+    bool handle(int depth, json::parse_event_t event, json& parsed)
+    {
+        switch(event)
+        {
+        case json::parse_event_t::key:
+            _keys.at(static_cast<size_t>(depth)) = parsed.get<std::string>();
+            break;
+
+        case json::parse_event_t::object_start:
+        case json::parse_event_t::array_start:
+            enterContainer(depth, event == json::parse_event_t::array_start);
 
-                if(it.value().is_string())
-                    value = QString::fromStdString(it.value().get<std::string>());
-                else if(it.value().is_number_integer())
-                    value = QString::number(it.value().get<int>());
-                else if(it.value().is_number_float())
-                    value = QString::number(it.value().get<double>());
+            if(event == json::parse_event_t::object_start &&
+                depth > 0 && depth <= 2 && isGraphObject(depth))
+            {
+                // Only the first graph is loaded; skip any others entirely
+                if(foundGraph())
+                    return false;
 
-                userEdgeData->setValueBy(edgeId, key, value);
+                _graphDepth = depth;
+                _inGraph = true;
+            }
+            else if(isElementContainer(depth, "nodes"))
+                _hasNodes = true;
+            else if(isElementContainer(depth, "edges"))
+                _hasEdges = true;
+            break;
+
+        case json::parse_event_t::object_end:
+        case json::parse_event_t::array_end:
+            if(_inGraph && depth == _graphDepth + 2)
+            {
+                if(isElementContainer(depth - 1, "nodes"))
+                {
+                    if(!_builder->addNode(parsed))
+                        throw failed_exception();
+
+                    return false;
+                }
+
+                if(isElementContainer(depth - 1, "edges"))
+                {
+                    if(_nodesComplete)
+                        addEdge(parsed);
+                    else
+                        _pendingEdges.emplace_back(std::move(parsed));
+
+                    return false;
+                }
             }
+            else if(isElementContainer(depth, "nodes"))
+            {
+                _nodesComplete = true;
+                flushPendingEdges();
+            }
+            else if(_inGraph && depth == _graphDepth)
+                _inGraph = false;
+            break;
+
+        case json::parse_event_t::value:
+            // Nodes and edges that aren't objects
+            if(_inGraph && depth == _graphDepth + 2 && !parsed.is_discarded() &&
+                (isElementContainer(depth - 1, "nodes") || isElementContainer(depth - 1, "edges")))
+            {
+                // These fail, but set an appropriate reason for doing so
+                if(isElementContainer(depth - 1, "nodes"))
+                    _builder->addNode(parsed);
+                else
+                    _builder->addEdge(parsed);
 
+                throw failed_exception();
+            }
+            break;
         }
 
+        return true;
+    }
+};
+} // namespace
+
+bool JsonGraphParser::parse(const QUrl &url, IGraphModel *graphModel)
+{
+    QFile file(url.toLocalFile());
+
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    if(file.size() == 0)
+        return false;
+
+    // The document is never held in memory in its entirety; instead each node and
+    // edge is added to the graph as soon as it has been parsed, then discarded
+    JsonGraphBuilder builder(graphModel, this, false, _userNodeData, _userEdgeData);
+    JsonGraphStreamHandler handler(&builder);
+
+    FileStreamBuffer streamBuffer(&file, this);
+    std::istream stream(&streamBuffer);
+
+    graphModel->mutableGraph().setPhase(QObject::tr("Parsing"));
+
+    json jsonBody;
+
+    try
+    {
+        jsonBody = json::parse(stream,
+        [&handler](int depth, json::parse_event_t event, json& parsed)
+        {
+            return handler.handle(depth, event, parsed);
+        }, false);
+    }
+    catch(FileStreamBuffer::cancelled_exception&) { return false; }
+    catch(JsonGraphStreamHandler::failed_exception&) { return false; }
+
+    if(cancelled())
+        return false;
+
+    if(jsonBody.is_null() || !jsonBody.is_object())
+    {
+        setFailureReason(QObject::tr("Body is empty, or not an object."));
+        return false;
+    }
+
+    if(!handler.foundGraph())
+    {
+        setFailureReason(QObject::tr("Body doesn't contain a graph object."));
+        return false;
+    }
+
+    if(!handler.hasNodesAndEdges())
+    {
+        setFailureReason(QObject::tr("Graph doesn't contain nodes or edges arrays."));
+        return false;
+    }
+
+    try
+    {
+        handler.flushPendingEdges();
+    }
+    catch(JsonGraphStreamHandler::failed_exception&) { return false; }
+
+    setProgress(-1);
+    return true;
+}
+
+bool JsonGraphParser::parseGraphObject(const json& jsonGraphObject, IGraphModel* graphModel,
+                                       IParser& parser, bool useElementIdsLiterally,
+                                       UserNodeData* userNodeData, UserEdgeData* userEdgeData)
+{
+    if(!u::contains(jsonGraphObject, "nodes") || !u::contains(jsonGraphObject, "edges"))
+    {
+        parser.setFailureReason(QObject::tr("Graph doesn't contain nodes or edges arrays."));
+        return false;
+    }
+
+    const auto& jsonNodes = jsonGraphObject["nodes"];
+    const auto& jsonEdges = jsonGraphObject["edges"];
+
+    JsonGraphBuilder builder(graphModel, &parser, useElementIdsLiterally, userNodeData, userEdgeData);
+
+    uint64_t i = 0;
+
+    graphModel->mutableGraph().setPhase(QObject::tr("Nodes"));
+    for(const auto& jsonNode : jsonNodes)
+    {
+        if(!builder.addNode(jsonNode))
+            return false;
+
+        parser.setProgress(static_cast<int>((i++ * 100) / jsonNodes.size()));
+    }
+
+    parser.setProgress(-1);
+
+    i = 0;
+
+    graphModel->mutableGraph().setPhase(QObject::tr("Edges"));
+    for(const auto& jsonEdge : jsonEdges)
+    {
+        if(!builder.addEdge(jsonEdge))
+            return false;
+
         parser.setProgress(static_cast<int>((i++ * 100) / jsonEdges.size()));
     }
 
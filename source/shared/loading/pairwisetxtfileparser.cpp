@@ -18,8 +18,8 @@
 
 #include "pairwisetxtfileparser.h"
 
-#include "shared/utils/container.h"
 #include "shared/utils/string.h"
+#include "shared/utils/threadpool.h"
 #include "shared/graph/igraphmodel.h"
 #include "shared/graph/imutablegraph.h"
 #include "shared/plugins/userelementdata.h"
@@ -27,19 +27,256 @@
 #include <utfcpp/utf8.h>
 
 #include <QFile>
-#include <QTextStream>
-#include <QFileInfo>
-#include <QStringList>
 #include <QUrl>
-#include <QDebug>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
-#include <string>
-#include <iostream>
-#include <fstream>
-#include <cctype>
+namespace
+{
+using Tokens = std::vector<std::string_view>;
+
+struct PairwiseChunk
+{
+    // Byte range of the input, aligned to line boundaries
+    size_t _begin = 0;
+    size_t _end = 0;
+
+    // Storage for any tokens that can't simply refer to the mapped file,
+    // i.e. those that have been repaired or pieced together from quotes
+    std::deque<std::string> _ownedStrings;
+
+    // Node names local to the chunk, in order of first appearance, along
+    // with the index of the first chunk edge that refers to each of them
+    std::unordered_map<std::string_view, int> _nameIndices;
+    std::vector<std::string_view> _names;
+    std::vector<size_t> _firstEdgeIndices;
+
+    std::vector<std::pair<int, int>> _localEdges;
+
+    // Only allocated once an edge with a weight is encountered; edges
+    // without a weight are NaN
+    std::vector<double> _weights;
+
+    struct NodeComment
+    {
+        size_t _numPrecedingEdges = 0;
+        Tokens _tokens;
+    };
+
+    std::vector<NodeComment> _nodeComments;
+
+    // Filled in once all the chunks have been tokenised
+    std::vector<int> _globalIndices;
+    size_t _firstEdgeIndex = 0;
+    std::vector<std::pair<NodeId, NodeId>> _edges;
+
+    size_t computeCostHint() const { return _end - _begin; }
+
+    int intern(std::string_view name)
+    {
+        auto [it, inserted] = _nameIndices.try_emplace(name, static_cast<int>(_names.size()));
+
+        if(inserted)
+        {
+            _names.push_back(name);
+            _firstEdgeIndices.push_back(_localEdges.size());
+        }
+
+        return it->second;
+    }
+
+    void addEdge(std::string_view source, std::string_view target)
+    {
+        auto sourceIndex = intern(source);
+        auto targetIndex = intern(target);
+        _localEdges.emplace_back(sourceIndex, targetIndex);
+    }
+
+    void addWeight(double weight)
+    {
+        if(_weights.size() + 1 < _localEdges.size())
+            _weights.resize(_localEdges.size() - 1, std::numeric_limits<double>::quiet_NaN());
+
+        _weights.push_back(weight);
+    }
+
+    double weightAt(size_t index) const
+    {
+        if(index < _weights.size())
+            return _weights[index];
+
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+};
+
+bool isTerminator(char c) { return c == '\n' || c == '\r'; }
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// A token in the process of being built; it refers directly to its source for as
+// long as its characters are contiguous, and is copied otherwise
+class TokenBuilder
+{
+private:
+    const char* _begin = nullptr;
+    const char* _end = nullptr;
+    std::string _copy;
+    bool _copied = false;
+
+public:
+    bool empty() const { return _copied ? _copy.empty() : _begin == nullptr; }
+
+    void append(const char* c)
+    {
+        if(_copied)
+            _copy.push_back(*c);
+        else if(_begin == nullptr)
+        {
+            _begin = c;
+            _end = c + 1;
+        }
+        else if(_end == c)
+            _end++;
+        else
+        {
+            _copy.assign(_begin, _end);
+            _copy.push_back(*c);
+            _copied = true;
+        }
+    }
+
+    std::string_view take(std::deque<std::string>& ownedStrings)
+    {
+        std::string_view token;
+
+        if(_copied)
+        {
+            ownedStrings.emplace_back(std::move(_copy));
+            token = ownedStrings.back();
+        }
+        else if(_begin != nullptr)
+            token = std::string_view(_begin, static_cast<size_t>(_end - _begin));
+
+        _begin = _end = nullptr;
+        _copy.clear();
+        _copied = false;
+
+        return token;
+    }
+};
+
+// Splits a line into tokens, separated by whitespace, quoted or otherwise; all the
+// characters of interest are ASCII, so valid UTF-8 can be processed bytewise
+bool tokeniseLine(const char* begin, const char* end,
+    Tokens& tokens, std::deque<std::string>& ownedStrings)
+{
+    tokens.clear();
+
+    TokenBuilder token;
+    bool inQuotes = false;
+    bool isComment = false;
+
+    for(const auto* it = begin; it < end; it++)
+    {
+        if(*it == '/' && it + 2 < end && *(it + 1) == '/')
+        {
+            isComment = true;
+
+            // Skip both /
+            it += 2;
+        }
+
+        if(*it == '\"')
+        {
+            if(inQuotes)
+                tokens.push_back(token.take(ownedStrings));
+
+            inQuotes = !inQuotes;
+        }
+        else
+        {
+            bool space = isSpace(*it);
+
+            if(space && !token.empty() && !inQuotes)
+                tokens.push_back(token.take(ownedStrings));
+            else if(!space || inQuotes)
+                token.append(it);
+        }
+    }
+
+    if(!token.empty())
+        tokens.push_back(token.take(ownedStrings));
+
+    return isComment;
+}
+
+bool startsWith(std::string_view string, std::string_view prefix)
+{
+    return string.substr(0, prefix.size()) == prefix;
+}
+
+QString toQString(std::string_view string)
+{
+    return QString::fromUtf8(string.data(), static_cast<int>(string.size()));
+}
+
+void tokeniseLineInto(PairwiseChunk& chunk, const char* begin, const char* end,
+    Tokens& tokens, bool keepNodeComments)
+{
+    // Lines that aren't valid UTF-8 are repaired into a copy
+    if(utf8::find_invalid(begin, end) != end)
+    {
+        std::string validatedLine;
+        utf8::replace_invalid(begin, end, std::back_inserter(validatedLine));
+        chunk._ownedStrings.emplace_back(std::move(validatedLine));
+
+        const auto& line = chunk._ownedStrings.back();
+        begin = line.data();
+        end = line.data() + line.size();
+    }
+
+    bool isComment = tokeniseLine(begin, end, tokens, chunk._ownedStrings);
+
+    if(isComment)
+    {
+        if(keepNodeComments && tokens.size() >= 2 && startsWith(tokens.front(), "NODE"))
+            chunk._nodeComments.push_back({chunk._localEdges.size(), tokens});
+    }
+    else if(tokens.size() >= 2)
+    {
+        chunk.addEdge(tokens.at(0), tokens.at(1));
+
+        if(tokens.size() >= 3)
+        {
+            // We have an edge weight too
+            const auto& thirdToken = tokens.at(2);
+            double edgeWeight = 0.0;
+
+            if(u::parseNumber(thirdToken.data(), thirdToken.data() + thirdToken.size(), edgeWeight))
+            {
+                if(std::isnan(edgeWeight) || !std::isfinite(edgeWeight))
+                    edgeWeight = 1.0;
+
+                chunk.addWeight(edgeWeight);
+            }
+        }
+    }
+}
+} // namespace
 
 PairwiseTxtFileParser::PairwiseTxtFileParser(UserNodeData* userNodeData, UserEdgeData* userEdgeData) :
     _userNodeData(userNodeData), _userEdgeData(userEdgeData)
@@ -52,202 +289,272 @@ bool PairwiseTxtFileParser::parse(const QUrl& url, IGraphModel* graphModel)
 {
     Q_ASSERT(graphModel != nullptr);
 
-    std::ifstream file(url.toLocalFile().toStdString());
-    if(!file || graphModel == nullptr)
+    QFile file(url.toLocalFile());
+    if(!file.open(QIODevice::ReadOnly) || graphModel == nullptr)
         return false;
 
-    auto fileSize = file.tellg();
-    file.seekg(0, std::ios::end);
-    fileSize = file.tellg() - fileSize;
+    auto fileSize = static_cast<size_t>(file.size());
+    if(fileSize == 0)
+        return true;
 
-    std::unordered_map<std::string, NodeId> nodeIdMap;
-
-    std::string line;
-    std::string token;
-    std::vector<std::string> tokens;
+    const auto* data = reinterpret_cast<const char*>(file.map(0, file.size()));
+    if(data == nullptr)
+    {
+        setFailureReason(QObject::tr("Failed to map %1 into memory.").arg(file.fileName()));
+        return false;
+    }
 
     setProgress(-1);
 
-    file.seekg(0, std::ios::beg);
-    while(u::getline(file, line))
+    // Split the file into chunks that start at the beginning of a line; the chunks are
+    // processed in batches, so that only one batch's tokens are held at any one time
+    const size_t MIN_CHUNK_SIZE = 1u << 20u;
+    const size_t MAX_CHUNK_SIZE = 1u << 23u;
+    const size_t CHUNKS_PER_BATCH = std::max(1u, std::thread::hardware_concurrency()) * 4;
+    auto numChunks = std::max<size_t>(fileSize / MAX_CHUNK_SIZE,
+        std::clamp<size_t>(fileSize / MIN_CHUNK_SIZE, 1, CHUNKS_PER_BATCH));
+
+    auto naiveChunkSize = fileSize / numChunks;
+    std::vector<size_t> alignedBegins(numChunks, 0);
+    for(size_t i = 1; i < numChunks; i++)
     {
-        if(cancelled())
-            return false;
+        const auto* it = std::find_if(data + (i * naiveChunkSize), data + fileSize, &isTerminator);
 
-        tokens.clear();
+        if(it < data + fileSize && *it == '\r')
+            it++;
 
-        bool inQuotes = false;
-        bool isComment = false;
+        if(it < data + fileSize && *it == '\n')
+            it++;
 
-        std::string validatedLine;
-        utf8::replace_invalid(line.begin(), line.end(), std::back_inserter(validatedLine));
-        auto it = validatedLine.begin();
-        auto end = validatedLine.end();
-        while(it < end)
+        alignedBegins[i] = std::max(static_cast<size_t>(it - data), alignedBegins[i - 1]);
+    }
+
+    // Each byte is counted once when it's tokenised and again once its edges are in the graph
+    std::atomic<size_t> bytesProcessed(0);
+    auto updateProgress = [&] { setProgress(static_cast<int>((bytesProcessed * 50) / fileSize)); };
+
+    bool keepNodeComments = _userNodeData != nullptr;
+
+    // The node names of all the chunks, interned into a single table; any names that
+    // don't refer to the mapped file are copied, as they would otherwise be discarded
+    // along with the chunk that owns them
+    std::unordered_map<std::string_view, int> nameIndices;
+    std::deque<std::string> ownedNames;
+    std::vector<NodeId> nodeIds;
+    std::vector<size_t> firstEdgeIndices;
+    size_t numEdges = 0;
+
+    auto& graph = graphModel->mutableGraph();
+
+    // Node properties are only applied to nodes that have already appeared in an
+    // edge, preceding the comment
+    auto applyNodeComments = [&](const PairwiseChunk& chunk)
+    {
+        for(const auto& nodeComment : chunk._nodeComments)
         {
-            uint32_t codePoint = utf8::next(it, end);
+            const auto& tokens = nodeComment._tokens;
 
-            if(it < end && it < (end - 1) &&
-               codePoint == '/' && utf8::peek_next(it, end) == '/')
-            {
-                isComment = true;
+            auto nameIndex = nameIndices.find(tokens.at(1));
+            if(nameIndex == nameIndices.end())
+                continue;
 
-                // Skip the second /
-                utf8::advance(it, 1, end);
-                codePoint = utf8::next(it, end);
-            }
+            auto index = static_cast<size_t>(nameIndex->second);
+            if(firstEdgeIndices.at(index) >= chunk._firstEdgeIndex + nodeComment._numPrecedingEdges)
+                continue;
 
-            if(codePoint == '\"')
-            {
-                if(inQuotes)
-                {
-                    tokens.emplace_back(std::move(token));
-                    token.clear();
-                }
+            const std::string_view NODE("NODE");
+            auto property = tokens.at(0).substr(NODE.size());
+
+            QString attributeName;
+            QString value;
 
-                inQuotes = !inQuotes;
+            if(tokens.size() == 4 && property == "CLASS")
+            {
+                attributeName = toQString(tokens.at(3));
+                value = toQString(tokens.at(2));
             }
-            else
+            else if(tokens.size() == 3 && property == "SIZE")
             {
-                bool space = (codePoint < 0xFF) && (std::isspace(codePoint) != 0);
-                bool trailingSpace = space && !token.empty();
-
-                if(trailingSpace && !inQuotes)
-                {
-                    tokens.emplace_back(std::move(token));
-                    token.clear();
-                }
-                else if(!space || inQuotes)
-                    utf8::unchecked::append(codePoint, std::back_inserter(token));
+                attributeName = QObject::tr("BioLayout Node Size");
+                value = toQString(tokens.at(2));
+            }
+            else if(tokens.size() == 4 && property == "SHAPE")
+            {
+                attributeName = QObject::tr("BioLayout Node Shape");
+                value = toQString(tokens.at(3));
+            }
+            else if(tokens.size() == 3 && property == "ALPHA")
+            {
+                attributeName = QObject::tr("BioLayout Node Opacity");
+                value = toQString(tokens.at(2));
+            }
+            else if(tokens.size() == 3 && property == "COLOR")
+            {
+                attributeName = QObject::tr("BioLayout Node Colour");
+                value = toQString(tokens.at(2));
             }
+            else if(tokens.size() == 3 && property == "DESC")
+            {
+                attributeName = QObject::tr("BioLayout Node Description");
+                value = toQString(tokens.at(2));
+            }
+            else if(tokens.size() == 3 && property == "URL")
+            {
+                attributeName = QObject::tr("BioLayout Node URL");
+                value = toQString(tokens.at(2));
+            }
+
+            if(!attributeName.isEmpty())
+                _userNodeData->setValueBy(nodeIds.at(index), attributeName, value);
         }
+    };
 
-        if(!token.empty())
+    for(size_t batchBegin = 0; batchBegin < numChunks; batchBegin += CHUNKS_PER_BATCH)
+    {
+        auto batchEnd = std::min(batchBegin + CHUNKS_PER_BATCH, numChunks);
+
+        std::vector<PairwiseChunk> chunks(batchEnd - batchBegin);
+        for(size_t i = 0; i < chunks.size(); i++)
         {
-            tokens.emplace_back(std::move(token));
-            token.clear();
+            auto chunkIndex = batchBegin + i;
+            chunks[i]._begin = alignedBegins[chunkIndex];
+            chunks[i]._end = (chunkIndex + 1 < numChunks) ? alignedBegins[chunkIndex + 1] : fileSize;
         }
 
-        if(isComment)
+        concurrent_for(chunks.begin(), chunks.end(),
+        [this, data, fileSize, keepNodeComments, &bytesProcessed, &updateProgress](PairwiseChunk& chunk)
         {
-            if(!tokens.empty() && _userNodeData != nullptr)
+            const size_t PROGRESS_GRANULARITY = 1u << 16u;
+
+            Tokens tokens;
+            auto position = chunk._begin;
+            auto lastReportedPosition = position;
+
+            while(position < chunk._end)
             {
-                NodeId nodeId;
-                QString attributeName;
-                QString value;
+                const auto* lineBegin = data + position;
+                const auto* lineEnd = std::find_if(lineBegin, data + chunk._end, &isTerminator);
 
-                const std::string NODE("NODE");
-                auto& firstToken = tokens.at(0);
+                tokeniseLineInto(chunk, lineBegin, lineEnd, tokens, keepNodeComments);
 
-                if(firstToken.compare(0, NODE.length(), NODE) == 0)
-                {
-                    auto& secondToken = tokens.at(1);
-                    if(u::contains(nodeIdMap, secondToken))
-                        nodeId = nodeIdMap.at(secondToken);
+                position = static_cast<size_t>(lineEnd - data);
+                if(position < fileSize && data[position] == '\r')
+                    position++;
+                if(position < fileSize && data[position] == '\n')
+                    position++;
 
-                    std::string property = firstToken.substr(NODE.length(), std::string::npos);
+                if(position - lastReportedPosition >= PROGRESS_GRANULARITY)
+                {
+                    if(cancelled())
+                        break;
 
-                    if(tokens.size() == 4 && property == "CLASS")
-                    {
-                        attributeName = QString::fromStdString(tokens.at(3));
-                        value = QString::fromStdString(tokens.at(2));
-                    }
-                    else if(tokens.size() == 3 && property == "SIZE")
-                    {
-                        attributeName = QObject::tr("BioLayout Node Size");
-                        value = QString::fromStdString(tokens.at(2));
-                    }
-                    else if(tokens.size() == 4 && property == "SHAPE")
-                    {
-                        attributeName = QObject::tr("BioLayout Node Shape");
-                        value = QString::fromStdString(tokens.at(3));
-                    }
-                    else if(tokens.size() == 3 && property == "ALPHA")
-                    {
-                        attributeName = QObject::tr("BioLayout Node Opacity");
-                        value = QString::fromStdString(tokens.at(2));
-                    }
-                    else if(tokens.size() == 3 && property == "COLOR")
-                    {
-                        attributeName = QObject::tr("BioLayout Node Colour");
-                        value = QString::fromStdString(tokens.at(2));
-                    }
-                    else if(tokens.size() == 3 && property == "DESC")
-                    {
-                        attributeName = QObject::tr("BioLayout Node Description");
-                        value = QString::fromStdString(tokens.at(2));
-                    }
-                    else if(tokens.size() == 3 && property == "URL")
-                    {
-                        attributeName = QObject::tr("BioLayout Node URL");
-                        value = QString::fromStdString(tokens.at(2));
-                    }
+                    bytesProcessed += (position - lastReportedPosition);
+                    lastReportedPosition = position;
+                    updateProgress();
                 }
-
-                if(!nodeId.isNull())
-                    _userNodeData->setValueBy(nodeId, attributeName, value);
             }
-        }
-        else if(tokens.size() >= 2)
-        {
-            auto& firstToken = tokens.at(0);
-            auto& secondToken = tokens.at(1);
 
-            NodeId firstNodeId;
-            NodeId secondNodeId;
+            bytesProcessed += (position - lastReportedPosition);
+        });
+
+        if(cancelled())
+            return false;
+
+        // Visiting the chunks in order means nodes are numbered in order
+        // of first appearance in the file
+        std::vector<std::string_view> newNames;
+
+        for(auto& chunk : chunks)
+        {
+            chunk._firstEdgeIndex = numEdges;
+            chunk._globalIndices.resize(chunk._names.size());
 
-            if(!u::contains(nodeIdMap, firstToken))
+            for(size_t i = 0; i < chunk._names.size(); i++)
             {
-                firstNodeId = graphModel->mutableGraph().addNode();
-                nodeIdMap.emplace(firstToken, firstNodeId);
+                auto name = chunk._names.at(i);
+                auto it = nameIndices.find(name);
 
-                if(_userNodeData != nullptr)
+                if(it == nameIndices.end())
                 {
-                    auto nodeName = QString::fromStdString(firstToken);
-                    _userNodeData->setValueBy(firstNodeId, QObject::tr("Node Name"), nodeName);
-                    graphModel->setNodeName(firstNodeId, nodeName);
+                    if(name.data() < data || name.data() >= data + fileSize)
+                    {
+                        ownedNames.emplace_back(name);
+                        name = ownedNames.back();
+                    }
+
+                    it = nameIndices.emplace(name, static_cast<int>(firstEdgeIndices.size())).first;
+                    newNames.push_back(name);
+                    firstEdgeIndices.push_back(numEdges + chunk._firstEdgeIndices.at(i));
                 }
+
+                chunk._globalIndices[i] = it->second;
             }
-            else
-                firstNodeId = nodeIdMap[firstToken];
 
-            if(!u::contains(nodeIdMap, secondToken))
+            numEdges += chunk._localEdges.size();
+
+            // The local table is no longer needed
+            chunk._nameIndices = {};
+            chunk._names = {};
+            chunk._firstEdgeIndices = {};
+        }
+
+        auto firstNodeId = graph.addNodesInBulk(static_cast<int>(newNames.size()));
+
+        for(size_t i = 0; i < newNames.size(); i++)
+        {
+            auto nodeId = firstNodeId + static_cast<int>(i);
+            nodeIds.push_back(nodeId);
+
+            if(_userNodeData != nullptr)
             {
-                secondNodeId = graphModel->mutableGraph().addNode();
-                nodeIdMap.emplace(secondToken, secondNodeId);
+                auto nodeName = toQString(newNames.at(i));
+                _userNodeData->setValueBy(nodeId, QObject::tr("Node Name"), nodeName);
+                graphModel->setNodeName(nodeId, nodeName);
 
-                if(_userNodeData != nullptr)
-                {
-                    auto nodeName = QString::fromStdString(secondToken);
-                    _userNodeData->setValueBy(secondNodeId, QObject::tr("Node Name"), nodeName);
-                    graphModel->setNodeName(secondNodeId, nodeName);
-                }
+                if((i % 1000) == 0 && cancelled())
+                    return false;
             }
-            else
-                secondNodeId = nodeIdMap[secondToken];
+        }
 
-            auto edgeId = graphModel->mutableGraph().addEdge(firstNodeId, secondNodeId);
+        concurrent_for(chunks.begin(), chunks.end(),
+        [&nodeIds](PairwiseChunk& chunk)
+        {
+            chunk._edges.reserve(chunk._localEdges.size());
 
-            if(tokens.size() >= 3)
+            auto nodeIdOf = [&nodeIds, &chunk](int localIndex)
             {
-                // We have an edge weight too
-                auto& thirdToken = tokens.at(2);
+                return nodeIds.at(static_cast<size_t>(chunk._globalIndices.at(localIndex)));
+            };
 
-                if(u::isNumeric(thirdToken))
-                {
-                    auto edgeWeight = u::toNumber(thirdToken);
+            for(const auto& [sourceIndex, targetIndex] : chunk._localEdges)
+                chunk._edges.emplace_back(nodeIdOf(sourceIndex), nodeIdOf(targetIndex));
+
+            chunk._localEdges = {};
+        });
+
+        for(auto& chunk : chunks)
+        {
+            if(cancelled())
+                return false;
 
-                    if(std::isnan(edgeWeight) || !std::isfinite(edgeWeight))
-                        edgeWeight = 1.0;
+            auto firstEdgeId = graph.addEdgesInBulk(chunk._edges);
 
-                    _userEdgeData->setValueBy(edgeId, QObject::tr("Edge Weight"), QString::number(edgeWeight));
+            for(size_t i = 0; i < chunk._weights.size(); i++)
+            {
+                auto edgeWeight = chunk.weightAt(i);
+                if(!std::isnan(edgeWeight))
+                {
+                    _userEdgeData->setValueBy(firstEdgeId + static_cast<int>(i),
+                        QObject::tr("Edge Weight"), QString::number(edgeWeight));
                 }
             }
-        }
 
-        auto filePosition = file.tellg();
-        if(filePosition >= 0)
-            setProgress(static_cast<int>(filePosition * 100 / fileSize));
+            if(_userNodeData != nullptr)
+                applyNodeComments(chunk);
+
+            bytesProcessed += (chunk._end - chunk._begin);
+            updateProgress();
+        }
     }
 
     return true;
@@ -18,12 +18,27 @@
 
 #include "tabulardata.h"
 
+#include "shared/utils/threadpool.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <thread>
+
+TabularData::TabularData() = default;
+TabularData::~TabularData() = default;
+
 TabularData::TabularData(TabularData&& other) noexcept :
     _data(std::move(other._data)),
     _columns(other._columns),
     _rows(other._rows),
-    _transposed(other._transposed)
-
+    _transposed(other._transposed),
+    _mappedFile(std::move(other._mappedFile)),
+    _mappedData(other._mappedData),
+    _ownedData(std::move(other._ownedData))
 {
     other.reset();
 }
@@ -36,6 +51,9 @@ TabularData& TabularData::operator=(TabularData&& other) noexcept
         _columns = other._columns;
         _rows = other._rows;
         _transposed = other._transposed;
+        _mappedFile = std::move(other._mappedFile);
+        _mappedData = other._mappedData;
+        _ownedData = std::move(other._ownedData);
 
         other.reset();
     }
@@ -65,6 +83,15 @@ size_t TabularData::index(size_t column, size_t row) const
     return index;
 }
 
+const char* TabularData::dataFor(const Cell& cell) const
+{
+    if(cell._owned)
+        return _ownedData.data() + cell._offset;
+
+    Q_ASSERT(_mappedData != nullptr);
+    return _mappedData + cell._offset;
+}
+
 size_t TabularData::numColumns() const
 {
     return !_transposed ? _columns : _rows;
@@ -95,6 +122,9 @@ void TabularData::setValueAt(size_t column, size_t row, QString&& value, int pro
             std::move_backward(oldPosition,
                 oldPosition + _columns,
                 newPosition + _columns);
+
+            // Clear the cells that have been vacated
+            std::fill(oldPosition, std::min(newPosition, oldPosition + _columns), Cell());
         }
     }
 
@@ -128,7 +158,19 @@ void TabularData::setValueAt(size_t column, size_t row, QString&& value, int pro
     }
 
     _data.resize(newSize);
-    _data.at(index(column, row)) = value.trimmed();
+
+    auto utf8Value = value.trimmed().toUtf8();
+
+    Cell cell;
+    cell._offset = _ownedData.size();
+    cell._length = static_cast<uint32_t>(utf8Value.size());
+    cell._owned = true;
+
+    _ownedData.append(utf8Value.constData(), static_cast<size_t>(utf8Value.size()));
+    cell._numeric = u::parseNumber(utf8Value.constData(),
+        utf8Value.constData() + utf8Value.size(), cell._number);
+
+    _data.at(index(column, row)) = cell;
 }
 
 void TabularData::shrinkToFit()
@@ -136,7 +178,7 @@ void TabularData::shrinkToFit()
     auto lastRowIsEmpty = [this]
     {
         size_t column = 0;
-        while(column < _columns && valueAt(column, _rows - 1).isEmpty())
+        while(column < _columns && _data.at(column + ((_rows - 1) * _columns)).empty())
             column++;
 
         return column >= _columns;
@@ -150,6 +192,7 @@ void TabularData::shrinkToFit()
     }
 
     _data.shrink_to_fit();
+    _ownedData.shrink_to_fit();
 }
 
 void TabularData::reset()
@@ -158,9 +201,553 @@ void TabularData::reset()
     _columns = 0;
     _rows = 0;
     _transposed = false;
+
+    _mappedData = nullptr;
+    _mappedFile.reset();
+    _ownedData.clear();
+}
+
+QString TabularData::valueAt(size_t column, size_t row) const
+{
+    const auto& cell = _data.at(index(column, row));
+
+    if(cell.empty())
+        return {};
+
+    return QString::fromUtf8(dataFor(cell), static_cast<int>(cell._length)).trimmed();
+}
+
+bool TabularData::valueIsEmpty(size_t column, size_t row) const
+{
+    return _data.at(index(column, row)).empty();
+}
+
+bool TabularData::valueIsNumeric(size_t column, size_t row) const
+{
+    return _data.at(index(column, row))._numeric;
+}
+
+double TabularData::numericValueAt(size_t column, size_t row) const
+{
+    const auto& cell = _data.at(index(column, row));
+
+    if(!cell._numeric)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    return cell._number;
+}
+
+TabularData::NumericBlock TabularData::numericBlock(size_t left, size_t top, size_t width, size_t height) const
+{
+    NumericBlock block;
+
+    if(width == 0 || height == 0)
+        return block;
+
+    Q_ASSERT(left + width <= numColumns());
+    Q_ASSERT(top + height <= numRows());
+
+    // Each row of the bitmap is padded to a whole number of words,
+    // so that rows can be filled concurrently
+    block._width = width;
+    block._height = height;
+    block._missingStride = (width + 63) / 64;
+    block._values.resize(width * height);
+    block._missing.resize(block._missingStride * height);
+
+    std::vector<size_t> rows(height);
+    std::iota(rows.begin(), rows.end(), 0);
+
+    concurrent_for(rows.begin(), rows.end(),
+    [this, &block, left, top, width](size_t row)
+    {
+        auto* values = &block._values.at(row * width);
+        auto* missing = &block._missing.at(row * block._missingStride);
+
+        for(size_t column = 0; column < width; column++)
+        {
+            const auto& cell = _data[index(left + column, top + row)];
+
+            // Non-numeric values are treated as zero, in the same way as QString::toDouble
+            values[column] = cell._numeric ? cell._number : 0.0;
+
+            if(cell.empty())
+                missing[column / 64] |= (uint64_t{1} << (column % 64));
+        }
+    });
+
+    return block;
+}
+
+DelimitedTabularDataParser::DelimitedTabularDataParser(char delimiter, IParser* parent) :
+    _delimiter(delimiter)
+{
+    if(parent != nullptr)
+        setProgressFn([parent](int percent) { parent->setProgress(percent); });
 }
 
-const QString& TabularData::valueAt(size_t column, size_t row) const
+namespace
+{
+struct DelimitedChunk
+{
+    // Byte range of the input, aligned to row boundaries
+    size_t _begin = 0;
+    size_t _end = 0;
+
+    // Where tokenisation actually finished; this can differ from _end if the
+    // chunk boundary was wrongly guessed to be a row boundary
+    size_t _tokenisedEnd = 0;
+
+    std::vector<TabularData::Cell> _cells;
+    std::vector<uint32_t> _rowLengths;
+    std::string _ownedData;
+
+    size_t computeCostHint() const { return _end - _begin; }
+};
+
+bool isTerminator(char c) { return c == '\n' || c == '\r'; }
+
+bool isTrimmable(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+class DelimitedChunkTokeniser
+{
+private:
+    const char* _data;
+    size_t _size;
+    char _delimiter;
+
+    void addCell(DelimitedChunk& chunk, size_t begin, size_t end, bool quoted, bool simple) const
+    {
+        TabularData::Cell cell;
+
+        if(quoted && !simple)
+        {
+            // The value contains escaped quotes or trailing characters after
+            // the closing quote, so it can't be referenced in place
+            std::string value;
+            bool inQuotes = false;
+
+            for(auto i = begin; i < end; i++)
+            {
+                auto c = _data[i];
+
+                if(c == '\"')
+                {
+                    if(inQuotes && i + 1 < end && _data[i + 1] == '\"')
+                    {
+                        value += c;
+                        i++;
+                    }
+                    else
+                        inQuotes = !inQuotes;
+                }
+                else
+                    value += c;
+            }
+
+            auto first = std::find_if_not(value.begin(), value.end(), isTrimmable);
+            auto last = std::find_if_not(value.rbegin(), std::string::reverse_iterator(first), isTrimmable).base();
+
+            cell._offset = chunk._ownedData.size();
+            cell._length = static_cast<uint32_t>(std::distance(first, last));
+            cell._owned = true;
+
+            chunk._ownedData.append(first, last);
+
+            const auto* cellData = chunk._ownedData.data() + cell._offset;
+            cell._numeric = u::parseNumber(cellData, cellData + cell._length, cell._number);
+        }
+        else
+        {
+            if(quoted)
+            {
+                // Strip the quotes
+                begin++;
+                end--;
+            }
+
+            while(begin < end && isTrimmable(_data[begin]))
+                begin++;
+
+            while(end > begin && isTrimmable(_data[end - 1]))
+                end--;
+
+            cell._offset = begin;
+            cell._length = static_cast<uint32_t>(end - begin);
+            cell._numeric = u::parseNumber(_data + begin, _data + end, cell._number);
+        }
+
+        chunk._cells.push_back(cell);
+    }
+
+public:
+    DelimitedChunkTokeniser(const char* data, size_t size, char delimiter) :
+        _data(data), _size(size), _delimiter(delimiter)
+    {}
+
+    // Tokenises a single row starting at position, in the same manner as
+    // aria::csv::CsvParser, returning the position of the following row
+    size_t tokeniseRow(DelimitedChunk& chunk, size_t position) const
+    {
+        enum class State { StartOfField, InField, InQuotedField, InEscapedQuote };
+        auto state = State::StartOfField;
+
+        size_t fieldBegin = position;
+        bool quoted = false;
+        bool simple = true;
+        uint32_t rowLength = 0;
+
+        auto endField = [&](size_t fieldEnd)
+        {
+            addCell(chunk, fieldBegin, fieldEnd, quoted, simple);
+            rowLength++;
+        };
+
+        auto skipTerminator = [this](size_t i)
+        {
+            // Treat \r\n as a single terminator
+            if(_data[i] == '\r' && i + 1 < _size && _data[i + 1] == '\n')
+                i++;
+
+            return i + 1;
+        };
+
+        size_t i = position;
+        for(; i < _size; i++)
+        {
+            auto c = _data[i];
+
+            switch(state)
+            {
+            case State::StartOfField:
+                fieldBegin = i;
+                quoted = false;
+                simple = true;
+
+                if(isTerminator(c))
+                {
+                    chunk._rowLengths.push_back(rowLength);
+                    return skipTerminator(i);
+                }
+
+                if(c == '\"')
+                {
+                    quoted = true;
+                    state = State::InQuotedField;
+                }
+                else if(c == _delimiter)
+                    endField(i);
+                else
+                    state = State::InField;
+
+                break;
+
+            case State::InField:
+                if(isTerminator(c))
+                {
+                    endField(i);
+                    chunk._rowLengths.push_back(rowLength);
+                    return skipTerminator(i);
+                }
+
+                if(c == _delimiter)
+                {
+                    endField(i);
+                    state = State::StartOfField;
+                }
+
+                break;
+
+            case State::InQuotedField:
+                if(c == '\"')
+                    state = State::InEscapedQuote;
+
+                break;
+
+            case State::InEscapedQuote:
+                if(isTerminator(c))
+                {
+                    endField(i);
+                    chunk._rowLengths.push_back(rowLength);
+                    return skipTerminator(i);
+                }
+
+                if(c == '\"')
+                {
+                    simple = false;
+                    state = State::InQuotedField;
+                }
+                else if(c == _delimiter)
+                {
+                    endField(i);
+                    state = State::StartOfField;
+                }
+                else
+                {
+                    simple = false;
+                    state = State::InField;
+                }
+
+                break;
+            }
+        }
+
+        // End of input; like aria::csv, only non-empty trailing fields count
+        if(state != State::StartOfField && i > fieldBegin)
+        {
+            if(state == State::InQuotedField)
+            {
+                // Unterminated quote
+                simple = false;
+            }
+
+            endField(i);
+        }
+
+        if(rowLength > 0)
+            chunk._rowLengths.push_back(rowLength);
+
+        return i;
+    }
+
+    // Finds the first row boundary at or after position, given the quote
+    // parity at position
+    size_t alignToRow(size_t position, bool inQuotes) const
+    {
+        for(auto i = position; i < _size; i++)
+        {
+            auto c = _data[i];
+
+            if(c == '\"')
+                inQuotes = !inQuotes;
+            else if(!inQuotes && isTerminator(c))
+            {
+                // Treat \r\n as a single terminator
+                if(c == '\r' && i + 1 < _size && _data[i + 1] == '\n')
+                    i++;
+
+                return i + 1;
+            }
+        }
+
+        return _size;
+    }
+};
+} // namespace
+
+bool DelimitedTabularDataParser::parse(const QUrl& url, IGraphModel* graphModel)
 {
-    return _data.at(index(column, row));
+    if(graphModel != nullptr)
+        graphModel->mutableGraph().setPhase(QObject::tr("Parsing"));
+
+    _tabularData.reset();
+
+    auto file = std::make_unique<QFile>(url.toLocalFile());
+    if(!file->open(QIODevice::ReadOnly))
+        return false;
+
+    auto fileSize = static_cast<size_t>(file->size());
+    if(fileSize == 0)
+        return true;
+
+    const auto* data = reinterpret_cast<const char*>(file->map(0, file->size()));
+    if(data == nullptr)
+    {
+        setFailureReason(QObject::tr("Failed to map %1 into memory.").arg(file->fileName()));
+        return false;
+    }
+
+    DelimitedChunkTokeniser tokeniser(data, fileSize, _delimiter);
+    std::vector<DelimitedChunk> chunks;
+
+    const size_t MIN_CHUNK_SIZE = 1u << 20u;
+    auto numChunks = std::clamp<size_t>(fileSize / MIN_CHUNK_SIZE, 1,
+        std::max(1u, std::thread::hardware_concurrency()) * 4);
+
+    // When only a limited number of rows is wanted, there's no point in
+    // tokenising the whole file
+    if(_rowLimit > 0)
+        numChunks = 1;
+
+    chunks.resize(numChunks);
+
+    if(numChunks > 1)
+    {
+        setProgress(-1);
+
+        // Count the quotes in each naive chunk so that the quote parity at each
+        // naive boundary is known, which permits each boundary to be advanced
+        // to the start of the next row
+        auto naiveChunkSize = fileSize / numChunks;
+        for(size_t i = 0; i < numChunks; i++)
+        {
+            chunks[i]._begin = i * naiveChunkSize;
+            chunks[i]._end = (i + 1 < numChunks) ? (i + 1) * naiveChunkSize : fileSize;
+        }
+
+        auto quoteCountResults = concurrent_for(chunks.begin(), chunks.end(),
+        [data](const DelimitedChunk& chunk)
+        {
+            return static_cast<size_t>(std::count(data + chunk._begin, data + chunk._end, '\"'));
+        });
+
+        std::vector<size_t> quoteCounts(quoteCountResults.begin(), quoteCountResults.end());
+
+        size_t quoteCount = 0;
+        std::vector<size_t> alignedBegins(numChunks, 0);
+        for(size_t i = 1; i < numChunks; i++)
+        {
+            quoteCount += quoteCounts.at(i - 1);
+            alignedBegins[i] = tokeniser.alignToRow(chunks[i]._begin, (quoteCount % 2) != 0);
+            alignedBegins[i] = std::max(alignedBegins[i], alignedBegins[i - 1]);
+        }
+
+        for(size_t i = 0; i < numChunks; i++)
+        {
+            chunks[i]._begin = alignedBegins[i];
+            chunks[i]._end = (i + 1 < numChunks) ? alignedBegins[i + 1] : fileSize;
+        }
+    }
+    else
+    {
+        chunks.front()._begin = 0;
+        chunks.front()._end = fileSize;
+    }
+
+    std::atomic<size_t> bytesTokenised(0);
+    auto rowLimit = _rowLimit;
+
+    auto tokeniseChunk = [this, &tokeniser, &bytesTokenised, fileSize, rowLimit](DelimitedChunk& chunk)
+    {
+        const size_t PROGRESS_GRANULARITY = 1u << 16u;
+
+        auto position = chunk._begin;
+        auto lastReportedPosition = position;
+
+        while(position < chunk._end)
+        {
+            position = tokeniser.tokeniseRow(chunk, position);
+
+            if(position - lastReportedPosition >= PROGRESS_GRANULARITY)
+            {
+                if(cancelled())
+                    break;
+
+                bytesTokenised += (position - lastReportedPosition);
+                lastReportedPosition = position;
+                setProgress(static_cast<int>((bytesTokenised * 100) / fileSize));
+            }
+
+            if(rowLimit > 0 && chunk._rowLengths.size() > rowLimit)
+                break;
+        }
+
+        chunk._tokenisedEnd = position;
+    };
+
+    concurrent_for(chunks.begin(), chunks.end(), tokeniseChunk);
+
+    if(cancelled())
+        return false;
+
+    // If a guessed boundary turns out not to be at the start of a row, (e.g.
+    // a stray quote has confused the parity) then the chunks won't abut; in
+    // this case fall back to tokenising the remainder sequentially
+    for(size_t i = 0; i + 1 < chunks.size(); i++)
+    {
+        if(chunks[i]._tokenisedEnd != chunks[i + 1]._begin)
+        {
+            auto& chunk = chunks[i];
+            chunk._end = fileSize;
+            chunks.resize(i + 1);
+
+            while(chunk._tokenisedEnd < chunk._end)
+                chunk._tokenisedEnd = tokeniser.tokeniseRow(chunk, chunk._tokenisedEnd);
+
+            break;
+        }
+    }
+
+    setProgress(-1);
+
+    // Concatenate the chunks
+    size_t numRows = 0;
+    size_t numColumns = 0;
+    size_t ownedDataSize = 0;
+    std::vector<size_t> rowOffsets;
+    std::vector<size_t> ownedDataOffsets;
+
+    for(const auto& chunk : chunks)
+    {
+        rowOffsets.push_back(numRows);
+        ownedDataOffsets.push_back(ownedDataSize);
+
+        numRows += chunk._rowLengths.size();
+        ownedDataSize += chunk._ownedData.size();
+
+        if(!chunk._rowLengths.empty())
+        {
+            numColumns = std::max(numColumns, static_cast<size_t>(
+                *std::max_element(chunk._rowLengths.begin(), chunk._rowLengths.end())));
+        }
+    }
+
+    if(_rowLimit > 0)
+        numRows = std::min(numRows, _rowLimit + 1);
+
+    auto& tabularData = _tabularData;
+    tabularData._columns = numColumns;
+    tabularData._rows = numRows;
+    tabularData._data.resize(numColumns * numRows);
+    tabularData._ownedData.reserve(ownedDataSize);
+
+    for(const auto& chunk : chunks)
+        tabularData._ownedData.append(chunk._ownedData);
+
+    std::vector<size_t> chunkIndices(chunks.size());
+    std::iota(chunkIndices.begin(), chunkIndices.end(), 0);
+
+    concurrent_for(chunkIndices.begin(), chunkIndices.end(),
+    [&](size_t chunkIndex)
+    {
+        auto& chunk = chunks.at(chunkIndex);
+        auto row = rowOffsets.at(chunkIndex);
+        auto ownedDataOffset = ownedDataOffsets.at(chunkIndex);
+        auto cellIt = chunk._cells.begin();
+
+        for(auto rowLength : chunk._rowLengths)
+        {
+            if(row >= numRows)
+                break;
+
+            auto* rowCells = &tabularData._data.at(row * numColumns);
+
+            for(uint32_t column = 0; column < rowLength; column++, ++cellIt)
+            {
+                auto cell = *cellIt;
+
+                if(cell._owned)
+                    cell._offset += ownedDataOffset;
+
+                rowCells[column] = cell;
+            }
+
+            row++;
+        }
+
+        // Release the memory as we go
+        chunk._cells = {};
+        chunk._rowLengths = {};
+    });
+
+    tabularData._mappedData = data;
+    tabularData._mappedFile = std::move(file);
+
+    // Free up any over-allocation
+    tabularData.shrinkToFit();
+
+    return true;
 }
@@ -35,20 +35,81 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <memory>
 #include <cstring>
+#include <cstdint>
+
+class QFile;
 
 class TabularData
 {
+    friend class DelimitedTabularDataParser;
+
+public:
+    // Rather than each cell being a QString, cells are ranges of UTF-8 bytes
+    // that refer either to the memory mapped source file, or to a buffer that
+    // is owned by the TabularData itself, for values that can't be referenced
+    // in place; QStrings are only created when a value is actually requested
+    // Numeric values are recognised and converted when the cell is created
+    struct Cell
+    {
+        uint64_t _offset = 0;
+        uint32_t _length = 0;
+        bool _owned = false;
+        bool _numeric = false;
+        double _number = 0.0;
+
+        bool empty() const { return _length == 0; }
+    };
+
+    // A dense row major copy of a rectangle of numeric values, with a bitmap
+    // indicating which of the values are missing, i.e. the cell was empty
+    class NumericBlock
+    {
+        friend class TabularData;
+
+    private:
+        size_t _width = 0;
+        size_t _height = 0;
+        size_t _missingStride = 0;
+        std::vector<double> _values;
+        std::vector<uint64_t> _missing;
+
+    public:
+        size_t width() const { return _width; }
+        size_t height() const { return _height; }
+
+        double valueAt(size_t column, size_t row) const { return _values.at(column + (row * _width)); }
+        bool missingAt(size_t column, size_t row) const
+        {
+            return ((_missing.at((row * _missingStride) + (column / 64)) >> (column % 64)) & 1u) != 0;
+        }
+
+        bool hasMissingValues() const
+        {
+            return std::any_of(_missing.begin(), _missing.end(), [](auto word) { return word != 0; });
+        }
+
+        std::vector<double>& values() { return _values; }
+    };
+
 private:
-    std::vector<QString> _data;
+    std::vector<Cell> _data;
     size_t _columns = 0;
     size_t _rows = 0;
     bool _transposed = false;
 
+    std::unique_ptr<QFile> _mappedFile;
+    const char* _mappedData = nullptr;
+    std::string _ownedData;
+
     size_t index(size_t column, size_t row) const;
+    const char* dataFor(const Cell& cell) const;
 
 public:
-    TabularData() = default;
+    TabularData();
+    ~TabularData();
     TabularData(TabularData&&) noexcept;
     TabularData& operator=(TabularData&&) noexcept;
 
@@ -62,7 +123,12 @@ public:
     size_t numColumns() const;
     size_t numRows() const;
     bool transposed() const { return _transposed; }
-    const QString& valueAt(size_t column, size_t row) const;
+    QString valueAt(size_t column, size_t row) const;
+    bool valueIsEmpty(size_t column, size_t row) const;
+    bool valueIsNumeric(size_t column, size_t row) const;
+    double numericValueAt(size_t column, size_t row) const;
+
+    NumericBlock numericBlock(size_t left, size_t top, size_t width, size_t height) const;
 
     void setTransposed(bool transposed) { _transposed = transposed; }
     void setValueAt(size_t column, size_t row, QString&& value, int progressHint = -1);
@@ -71,70 +137,34 @@ public:
     void reset();
 };
 
-template<const char Delimiter>
-class TextDelimitedTabularDataParser : public IParser
+// Memory maps the input file, splits it into newline aligned chunks and
+// tokenises these in parallel; each resultant cell refers to the mapping
+class DelimitedTabularDataParser : public IParser
 {
-    static_assert(Delimiter != '\"', "Delimiter cannot be a quotemark");
-
 private:
+    char _delimiter;
     size_t _rowLimit = 0;
     TabularData _tabularData;
 
 public:
-    explicit TextDelimitedTabularDataParser(IParser* parent = nullptr)
-    {
-        if(parent != nullptr)
-            setProgressFn([parent](int percent) { parent->setProgress(percent); });
-    }
-
-    bool parse(const QUrl& url, IGraphModel* graphModel = nullptr) override
-    {
-        if(graphModel != nullptr)
-            graphModel->mutableGraph().setPhase(QObject::tr("Parsing"));
+    explicit DelimitedTabularDataParser(char delimiter, IParser* parent = nullptr);
 
-        size_t columnIndex = 0;
-        size_t rowIndex = 0;
-
-        std::ifstream file(url.toLocalFile().toStdString());
-
-        if(!file)
-            return false;
-
-        auto fileSize = file.tellg();
-        file.seekg(0, std::ios::end);
-        fileSize = file.tellg() - fileSize;
-        file.seekg(0, std::ios::beg);
-
-        auto parser = std::make_unique<aria::csv::CsvParser>(file);
-        parser->delimiter(Delimiter);
-        for(const auto& row : *parser)
-        {
-            auto progress = file.eof() ? 100 :
-                static_cast<int>(parser->position() * 100 / fileSize);
-            setProgress(progress);
-
-            for(const auto& field : row)
-            {
-                _tabularData.setValueAt(columnIndex++, rowIndex,
-                    QString::fromStdString(field), progress);
-            }
-
-            rowIndex++;
-            columnIndex = 0;
-
-            if(_rowLimit > 0 && rowIndex > _rowLimit)
-                break;
-        }
-
-        // Free up any over-allocation
-        _tabularData.shrinkToFit();
-
-        return true;
-    }
+    bool parse(const QUrl& url, IGraphModel* graphModel = nullptr) override;
 
     void setRowLimit(size_t rowLimit) { _rowLimit = rowLimit; }
 
     TabularData& tabularData() { return _tabularData; }
+};
+
+template<const char Delimiter>
+class TextDelimitedTabularDataParser : public DelimitedTabularDataParser
+{
+    static_assert(Delimiter != '\"', "Delimiter cannot be a quotemark");
+
+public:
+    explicit TextDelimitedTabularDataParser(IParser* parent = nullptr) :
+        DelimitedTabularDataParser(Delimiter, parent)
+    {}
 
     static bool canLoad(const QUrl& url)
     {
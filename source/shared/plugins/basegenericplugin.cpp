@@ -25,6 +25,7 @@
 #include "shared/loading/adjacencymatrixfileparser.h"
 #include "shared/loading/matfileparser.h"
 #include "shared/loading/jsongraphparser.h"
+#include "shared/loading/binarygraphparser.h"
 
 #include "shared/attributes/iattribute.h"
 
@@ -84,6 +85,9 @@ std::unique_ptr<IParser> BaseGenericPluginInstance::parserForUrlTypeName(const Q
     if(urlTypeName == QLatin1String("JSONGraph"))
         return std::make_unique<JsonGraphParser>(&_userNodeData, &_userEdgeData);
 
+    if(urlTypeName == QLatin1String("BinaryGraph"))
+        return std::make_unique<BinaryGraphParser>(&_userNodeData, &_userEdgeData);
+
     return nullptr;
 }
 
@@ -188,6 +192,7 @@ BaseGenericPlugin::BaseGenericPlugin()
     registerUrlType(QStringLiteral("BiopaxOWL"), QObject::tr("Biopax OWL File"), QObject::tr("Biopax OWL Files"), {"owl"});
     registerUrlType(QStringLiteral("MatFile"), QObject::tr("Matlab Data File"), QObject::tr("Matlab Data Files"), {"mat"});
     registerUrlType(QStringLiteral("JSONGraph"), QObject::tr("JSON Graph File"), QObject::tr("JSON Graph Files"), {"json"});
+    registerUrlType(QStringLiteral("BinaryGraph"), QObject::tr("Binary Graph File"), QObject::tr("Binary Graph Files"), {"graphbin"});
 }
 
 QStringList BaseGenericPlugin::identifyUrl(const QUrl& url) const
@@ -211,7 +216,8 @@ QStringList BaseGenericPlugin::identifyUrl(const QUrl& url) const
             (urlType == QStringLiteral("MatrixXLSX") && AdjacencyMatrixXLSXFileParser::canLoad(url)) ||
             (urlType == QStringLiteral("BiopaxOWL") && BiopaxFileParser::canLoad(url)) ||
             (urlType == QStringLiteral("MatFile") && MatFileParser::canLoad(url)) ||
-            (urlType == QStringLiteral("JSONGraph") && JsonGraphParser::canLoad(url));
+            (urlType == QStringLiteral("JSONGraph") && JsonGraphParser::canLoad(url)) ||
+            (urlType == QStringLiteral("BinaryGraph") && BinaryGraphParser::canLoad(url));
 
         if(canLoad)
             result.push_back(urlType);
@@ -21,8 +21,11 @@
 #include <QStringList>
 #include <QRegularExpression>
 #include <QLocale>
+#include <QByteArray>
 
 #include <vector>
+#include <array>
+#include <algorithm>
 #include <cmath>
 #include <sstream>
 #include <limits>
@@ -79,6 +82,111 @@ double u::toNumber(const QString& string)
     return std::numeric_limits<double>::quiet_NaN();
 }
 
+bool u::parseNumber(const char* begin, const char* end, double& value)
+{
+    if(begin >= end)
+        return false;
+
+    // Fast path: a decimal with at most 19 significant digits and a small exponent
+    // can be computed exactly using a single double multiplication or division
+    // (Clinger's algorithm); anything else is passed to Qt
+    static const std::array<double, 23> powersOf10 =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const auto* it = begin;
+    bool negative = false;
+
+    if(*it == '-' || *it == '+')
+    {
+        negative = (*it == '-');
+        it++;
+    }
+
+    uint64_t mantissa = 0;
+    int numDigits = 0;
+    int exponent = 0;
+    bool anyDigits = false;
+
+    for(; it < end && *it >= '0' && *it <= '9'; it++)
+    {
+        anyDigits = true;
+
+        if(mantissa == 0 && *it == '0')
+            continue;
+
+        mantissa = (mantissa * 10) + static_cast<uint64_t>(*it - '0');
+        numDigits++;
+    }
+
+    if(it < end && *it == '.')
+    {
+        for(it++; it < end && *it >= '0' && *it <= '9'; it++)
+        {
+            anyDigits = true;
+            exponent--;
+
+            if(mantissa == 0 && *it == '0')
+                continue;
+
+            mantissa = (mantissa * 10) + static_cast<uint64_t>(*it - '0');
+            numDigits++;
+        }
+    }
+
+    bool fastPath = anyDigits && numDigits <= 19;
+
+    if(fastPath && it < end && (*it == 'e' || *it == 'E'))
+    {
+        it++;
+
+        bool negativeExponent = false;
+        if(it < end && (*it == '-' || *it == '+'))
+        {
+            negativeExponent = (*it == '-');
+            it++;
+        }
+
+        int explicitExponent = 0;
+        const auto* exponentBegin = it;
+        for(; it < end && *it >= '0' && *it <= '9' && explicitExponent < 10000; it++)
+            explicitExponent = (explicitExponent * 10) + (*it - '0');
+
+        fastPath = (it != exponentBegin);
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    const uint64_t maxExactMantissa = uint64_t{1} << 53u;
+
+    if(fastPath && it == end && mantissa <= maxExactMantissa &&
+        exponent >= -22 && exponent <= 22)
+    {
+        auto d = static_cast<double>(mantissa);
+
+        if(exponent < 0)
+            d /= powersOf10.at(static_cast<size_t>(-exponent));
+        else
+            d *= powersOf10.at(static_cast<size_t>(exponent));
+
+        value = negative ? -d : d;
+        return true;
+    }
+
+    // Only bother with the slow path if there is some chance of it succeeding
+    if(!anyDigits && std::none_of(begin, end, [](char c) { return c == 'n' || c == 'N' || c == 'i' || c == 'I'; }))
+        return false;
+
+    bool success = false;
+    auto d = QByteArray::fromRawData(begin, static_cast<int>(end - begin)).toDouble(&success);
+
+    if(success)
+        value = d;
+
+    return success;
+}
+
 std::vector<QString> u::toQStringVector(const QStringList& stringList)
 {
     std::vector<QString> v;
@@ -38,6 +38,10 @@ namespace u
     double toNumber(const std::string& string);
     double toNumber(const QString& string);
 
+    // Parses the already trimmed range [begin, end) as a number, accepting the same
+    // inputs as QString::toDouble; returns false if the range isn't numeric
+    bool parseNumber(const char* begin, const char* end, double& value);
+
     std::vector<QString> toQStringVector(const QStringList& stringList);
     QStringList toQStringList(const std::vector<QString>& qStringVector);
 
@@ -59,6 +59,8 @@ public:
     ThreadPool& operator=(const ThreadPool& other) = delete;
     ThreadPool& operator=(ThreadPool&& other) = delete;
 
+    size_t numThreads() const { return _threads.size(); }
+
     bool saturated() const { return _activeThreads >= static_cast<int>(_threads.size()); }
     bool idle() const { return _activeThreads == 0; }
 
@@ -530,7 +532,11 @@ public:
     }
 };
 
-class ThreadPoolSingleton : public ThreadPool, public Singleton<ThreadPoolSingleton> {};
+class ThreadPoolSingleton : public ThreadPool, public Singleton<ThreadPoolSingleton>
+{
+public:
+    using ThreadPool::ThreadPool;
+};
 
 template<typename Fn, typename... Args>
 auto execute_on_threadpool(Fn&& f, Args&&... args)